@@ -10,5 +10,6 @@ public class TPSTarget : TargetRules
 		Type = TargetType.Game;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
 		ExtraModuleNames.Add("TPS");
+		bWithPushModel = true;
 	}
 }
@@ -14,7 +14,16 @@
 #include "Kismet/KismetMathLibrary.h"
 #include "Engine/GameEngine.h"
 #include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "../Game/TPSGameInstance.h"
+#include "../Game/TPSLagCompensationSubsystem.h"
+#include "../Game/TPSCorpseSubsystem.h"
+#include "../Game/TPSAnimSubsystem.h"
+#include "../Game/TPSFixedStepSubsystem.h"
+#include "../TPS.h"
+#include "../FuncLibrary/TPSDebugDraw.h"
+#include "../FuncLibrary/TPSTelemetry.h"
 
 ATPSCharacter::ATPSCharacter()
 {
@@ -32,6 +41,9 @@ ATPSCharacter::ATPSCharacter()
 	GetCharacterMovement()->bConstrainToPlane = true;
 	GetCharacterMovement()->bSnapToPlaneAtStart = true;
 
+	// Frame skip by screen size, full rate is restored in BeginPlay where hit boxes need it
+	UTPSAnimSubsystem::SetupMesh(GetMesh());
+
 	// Create a camera boom...
 	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
 	CameraBoom->SetupAttachment(RootComponent);
@@ -88,14 +100,81 @@ void ATPSCharacter::Tick(float DeltaSeconds)
 	MovementTick(DeltaSeconds);
 }
 
+void ATPSCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ATPSCharacter, CurrentWeapon);
+	DOREPLIFETIME(ATPSCharacter, CurrentIndexWeapon);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ATPSCharacter, ActiveEffects, Params);
+}
+
 void ATPSCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
-	if (CursorMaterial)
+	if (CursorMaterial && TPSShouldPlayCosmetics(GetWorld()))
 	{
 		CurrentCursor = UGameplayStatics::SpawnDecalAtLocation(GetWorld(), CursorMaterial, CursorSize, FVector(0));
 	}
+
+	UTPSLagCompensationSubsystem* myLagComp = GetWorld()->GetSubsystem<UTPSLagCompensationSubsystem>();
+	if (HasAuthority() && myLagComp)
+	{
+		myLagComp->RegisterCharacter(this);
+	}
+
+	UTPSAnimSubsystem* myAnim = GetWorld()->GetSubsystem<UTPSAnimSubsystem>();
+	if (myAnim)
+	{
+		//server rewinds bones for remote clients' shots, they must be current even off screen
+		const bool bFullRate = HasAuthority() && GetNetMode() != NM_Standalone && myLagComp && myLagComp->IsEnabled();
+		myAnim->Register(GetMesh(), bFullRate, true);
+	}
+
+	SurfaceTypeCache.Build(this, GetMesh());
+
+	UTPSRegenSubsystem* myRegen = GetWorld()->GetSubsystem<UTPSRegenSubsystem>();
+	if (myRegen)
+	{
+		//stamina in whole gameplay steps, same drain at any frame rate
+		UTPSFixedStepSubsystem* myFixedStep = GetWorld()->GetSubsystem<UTPSFixedStepSubsystem>();
+		StaminaRegenHandle = myRegen->Register(this, ETPSRegenChannel::Stamina, 1.0f, myFixedStep ? myFixedStep->GetStepTime() : 0.0f, true);
+	}
+}
+
+void ATPSCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UTPSLagCompensationSubsystem* myLagComp = GetWorld()->GetSubsystem<UTPSLagCompensationSubsystem>();
+	if (myLagComp)
+	{
+		myLagComp->UnregisterCharacter(this);
+	}
+	UTPSAnimSubsystem* myAnim = GetWorld()->GetSubsystem<UTPSAnimSubsystem>();
+	if (myAnim)
+	{
+		myAnim->Unregister(GetMesh());
+	}
+	UTPSRegenSubsystem* myRegen = GetWorld()->GetSubsystem<UTPSRegenSubsystem>();
+	if (myRegen)
+	{
+		myRegen->Unregister(StaminaRegenHandle);
+	}
+	//timer effects step on the fixed clock, they end with the owner
+	const TArray<UTPS_StateEffect*> myEffects = Effects;
+	for (UTPS_StateEffect* myEffect : myEffects)
+	{
+		if (myEffect)
+		{
+			myEffect->DestroyObject();
+		}
+	}
+	Effects.Empty();
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void ATPSCharacter::SetupPlayerInputComponent(UInputComponent* NewInputComponent)
@@ -143,11 +222,16 @@ void ATPSCharacter::MovementTick(float DeltaTime)
 	//GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Green, FString::Printf(TEXT("AxisX: %f"), AxisX));
 	//GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Blue, FString::Printf(TEXT("AxisY: %f"), AxisY));
 
-	APlayerController* myController = UGameplayStatics::GetPlayerController(GetWorld(), 0);
+	//only own player controller aims, AI and scripted characters set ShootEndLocation themselves
+	APlayerController* myController = Cast<APlayerController>(GetController());
 	if (myController && !CharHealthComponent->UTPSHealthComponent::CharIsDead)
 	{
 		FHitResult TraceHitResult;
-		myController->GetHitResultUnderCursor(ECC_GameTraceChannel1, true, TraceHitResult);
+		//no viewport with -nullrhi, bot controllers aim themselves
+		if (!myController->GetHitResultUnderCursor(ECC_GameTraceChannel1, true, TraceHitResult))
+			return;
+		TPS_DEBUG_LINE(GetWorld(), CursorTrace, GetActorLocation(), TraceHitResult.Location, FColor::Cyan, 0.0f);
+		TPS_DEBUG_POINT(GetWorld(), CursorTrace, TraceHitResult.Location, 24.0f, FColor::Cyan, 0.0f);
 		float FindRotatorResultYaw = UKismetMathLibrary::FindLookAtRotation(GetActorLocation(), TraceHitResult.Location).Yaw;
 		SetActorRotation(FQuat(FRotator(0.0f, FindRotatorResultYaw, 0.0f)));
 		int Xdir = 0; int Ydir = 0;
@@ -205,19 +289,19 @@ void ATPSCharacter::MovementTick(float DeltaTime)
 			{
 			case EMovementState::Aim_State:
 				Displacement = FVector(0.0f, 0.0f, 160.0f);
-				CurrentWeapon->ShouldReduceDispersion = true;
+				CurrentWeapon->GetSim().bReduceDispersion = true;
 				break;
 			case EMovementState::AimWalk_State:
-				CurrentWeapon->ShouldReduceDispersion = true;
+				CurrentWeapon->GetSim().bReduceDispersion = true;
 				Displacement = FVector(0.0f, 0.0f, 160.0f);
 				break;
 			case EMovementState::Walk_State:
 				Displacement = FVector(0.0f, 0.0f, 120.0f);
-				CurrentWeapon->ShouldReduceDispersion = false;
+				CurrentWeapon->GetSim().bReduceDispersion = false;
 				break;
 			case EMovementState::Run_State:
 				Displacement = FVector(0.0f, 0.0f, 120.0f);
-				CurrentWeapon->ShouldReduceDispersion = false;
+				CurrentWeapon->GetSim().bReduceDispersion = false;
 				break;
 			case EMovementState::Sprint_State:
 				break;
@@ -268,18 +352,28 @@ void ATPSCharacter::CharacterUpdate()
 		break;
 	}
 	GetCharacterMovement()->MaxWalkSpeed = ResSpeed;
+	//stamina is in ApplyRegen, per fixed step from UTPSRegenSubsystem
+	//GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Green, FString::Printf(TEXT("SprintBlock: %i"), SprintBlock));
+	//GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Blue, FString::Printf(TEXT("Stamina: %f"), Stamina));
+}
+
+bool ATPSCharacter::ApplyRegen(ETPSRegenChannel Channel, float Amount, float ElapsedTime)
+{
+	if (Channel != ETPSRegenChannel::Stamina || CharHealthComponent->UTPSHealthComponent::CharIsDead)
+		return false;
+
+	//CharacterSpeed is set by BP
 	if (CharacterSpeed >= 790 && Stamina > 0.0f && SprintBlock == 0)
 	{
-		Stamina -= 0.005;
+		Stamina = FMath::Max(Stamina - StaminaDrainPerSecond * ElapsedTime, 0.0f);
 	}
 	else if (CharacterSpeed <= 789 && Stamina < 1.0f)
-		Stamina += 0.005;
+		Stamina = FMath::Min(Stamina + StaminaRecoverPerSecond * ElapsedTime, 1.0f);
 	else if (Stamina >= 1.0f && SprintBlock == 1)
 		SprintBlock = 0;
 	if (Stamina <= 0.0f)
 		SprintBlock = 1;
-	//GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Green, FString::Printf(TEXT("SprintBlock: %i"), SprintBlock));
-	//GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Blue, FString::Printf(TEXT("Stamina: %f"), Stamina));
+	return true;
 }
 
 void ATPSCharacter::ChangeMovementState()
@@ -310,6 +404,22 @@ void ATPSCharacter::ChangeMovementState()
 	{
 		myWeapon->UpdateStateWeapon(MovementState);
 	}
+	if (!HasAuthority() && IsLocallyControlled())
+	{
+		ServerSetMovementState(MovementState);
+	}
+}
+
+void ATPSCharacter::ServerSetMovementState_Implementation(EMovementState NewMovementState)
+{
+	TPSCountServerRPC();
+	MovementState = NewMovementState;
+	CharacterUpdate();
+	AWeaponDefault* myWeapon = GetCurrentWeapon();
+	if (myWeapon)
+	{
+		myWeapon->UpdateStateWeapon(MovementState);
+	}
 }
 
 AWeaponDefault* ATPSCharacter::GetCurrentWeapon()
@@ -319,6 +429,10 @@ AWeaponDefault* ATPSCharacter::GetCurrentWeapon()
 
 void ATPSCharacter::InitWeapon(FName IdWeaponName, FAdditionalWeaponInfo WeaponAdditionalInfo, int32 NewCurrentIndexWeapon)
 {
+	//weapon actor is spawned by server and replicated
+	if (!HasAuthority())
+		return;
+
 	if (CurrentWeapon)
 	{
 		CurrentWeapon->Destroy();
@@ -349,21 +463,18 @@ void ATPSCharacter::InitWeapon(FName IdWeaponName, FAdditionalWeaponInfo WeaponA
 					CurrentWeapon = myWeapon;
 
 					myWeapon->WeaponSetting = myWeaponInfo;
+					myWeapon->WeaponIdName = IdWeaponName;
 
 					//myWeapon->AdditionalWeaponInfo.Round = myWeaponInfo.MaxRound;
 
-					myWeapon->ReloadTimer = myWeaponInfo.ReloadTime;
+					myWeapon->GetSim().ReloadTimer = myWeaponInfo.ReloadTime;
 					myWeapon->UpdateStateWeapon(MovementState);
 
-					myWeapon->AdditionalWeaponInfo = WeaponAdditionalInfo;
+					myWeapon->SetAdditionalWeaponInfo(WeaponAdditionalInfo);
 					//if(InventoryComponent)
 					CurrentIndexWeapon = NewCurrentIndexWeapon;//fix
 
-					//Not Forget remove delegate on change/drop weapon
-					myWeapon->OnWeaponReloadStart.AddDynamic(this, &ATPSCharacter::WeaponReloadStart);
-					myWeapon->OnWeaponReloadEnd.AddDynamic(this, &ATPSCharacter::WeaponReloadEnd);
-
-					myWeapon->OnWeaponFireStart.AddDynamic(this, &ATPSCharacter::WeaponFireStart);
+					BindWeaponEvents(myWeapon);
 
 					// after switch try reload weapon if needed
 					if (CurrentWeapon->GetWeaponRound() <= 0 && CurrentWeapon->CheckCanWeaponReload())
@@ -371,6 +482,8 @@ void ATPSCharacter::InitWeapon(FName IdWeaponName, FAdditionalWeaponInfo WeaponA
 
 					if (InventoryComponent)
 						InventoryComponent->OnWeaponAmmoAviable.Broadcast(myWeapon->WeaponSetting.WeaponType);
+
+					OnCurrentWeaponChanged.Broadcast();
 				}
 			}
 		}
@@ -381,6 +494,26 @@ void ATPSCharacter::InitWeapon(FName IdWeaponName, FAdditionalWeaponInfo WeaponA
 	}
 }
 
+void ATPSCharacter::OnRep_CurrentWeapon()
+{
+	if (CurrentWeapon)
+	{
+		BindWeaponEvents(CurrentWeapon);
+		CurrentWeapon->UpdateStateWeapon(MovementState);
+	}
+	OnCurrentWeaponChanged.Broadcast();
+}
+
+void ATPSCharacter::BindWeaponEvents(AWeaponDefault* Weapon)
+{
+	//Not Forget remove delegate on change/drop weapon
+	Weapon->OnWeaponReloadStart.AddUniqueDynamic(this, &ATPSCharacter::WeaponReloadStart);
+	Weapon->OnWeaponReloadEnd.AddUniqueDynamic(this, &ATPSCharacter::WeaponReloadEnd);
+
+	Weapon->OnWeaponFireStart.AddUniqueDynamic(this, &ATPSCharacter::WeaponFireStart);
+	Weapon->OnWeaponFired.AddUniqueDynamic(this, &ATPSCharacter::WeaponFired);
+}
+
 void ATPSCharacter::RemoveCurrentWeapon()
 {
 
@@ -391,10 +524,21 @@ void ATPSCharacter::TryReloadWeapon()
 	if (CurrentWeapon && !CurrentWeapon->WeaponReloading)
 	{
 		if (CurrentWeapon->GetWeaponRound() < CurrentWeapon->WeaponSetting.MaxRound && CurrentWeapon->CheckCanWeaponReload())
+		{
+			//owner starts reload at once, server runs the same timer
 			CurrentWeapon->InitReload();
+			if (!HasAuthority())
+				ServerReloadWeapon();
+		}
 	}
 }
 
+void ATPSCharacter::ServerReloadWeapon_Implementation()
+{
+	TPSCountServerRPC();
+	TryReloadWeapon();
+}
+
 void ATPSCharacter::WeaponReloadStart(UAnimMontage* Anim)
 {
 	WeaponReloadStart_BP(Anim);
@@ -422,9 +566,14 @@ void ATPSCharacter::WeaponReloadEnd_BP_Implementation(bool bIsSuccess)
 
 void ATPSCharacter::WeaponFireStart(UAnimMontage* Anim)
 {
+	WeaponFireStart_BP(Anim);
+}
+
+void ATPSCharacter::WeaponFired()
+{
+	//inventory slot keeps the clip for weapon switch, also on dedicated server
 	if (InventoryComponent && CurrentWeapon)
 		InventoryComponent->SetAdditionalInfoWeapon(CurrentIndexWeapon, CurrentWeapon->AdditionalWeaponInfo);
-	WeaponFireStart_BP(Anim);
 }
 
 void ATPSCharacter::WeaponFireStart_BP_Implementation(UAnimMontage* Anim)
@@ -442,6 +591,12 @@ UDecalComponent* ATPSCharacter::GetCursorToWorld()
 //now we not have not success switch/ if 1 weapon switch to self
 void ATPSCharacter::TrySwicthNextWeapon()
 {
+	if (!HasAuthority())
+	{
+		ServerSwitchWeapon(true);
+		return;
+	}
+
 	if (InventoryComponent->WeaponSlots.Num() > 1)
 	{
 		//We have more then one weapon go switch
@@ -465,6 +620,12 @@ void ATPSCharacter::TrySwicthNextWeapon()
 
 void ATPSCharacter::TrySwitchPreviosWeapon()
 {
+	if (!HasAuthority())
+	{
+		ServerSwitchWeapon(false);
+		return;
+	}
+
 	if (InventoryComponent->WeaponSlots.Num() > 1)
 	{
 		//We have more then one weapon go switch
@@ -487,8 +648,23 @@ void ATPSCharacter::TrySwitchPreviosWeapon()
 	}
 }
 
+void ATPSCharacter::ServerSwitchWeapon_Implementation(bool bIsForward)
+{
+	TPSCountServerRPC();
+	if (bIsForward)
+		TrySwicthNextWeapon();
+	else
+		TrySwitchPreviosWeapon();
+}
+
 void ATPSCharacter::TryAbilityEnabled()
 {
+	if (!HasAuthority())
+	{
+		ServerAbilityEnabled();
+		return;
+	}
+
 	if (AbilityEffect)//TODO Cool down
 	{
 		UTPS_StateEffect* NewEffect = NewObject<UTPS_StateEffect>(this, AbilityEffect);
@@ -499,6 +675,12 @@ void ATPSCharacter::TryAbilityEnabled()
 	}
 }
 
+void ATPSCharacter::ServerAbilityEnabled_Implementation()
+{
+	TPSCountServerRPC();
+	TryAbilityEnabled();
+}
+
 EPhysicalSurface ATPSCharacter::GetSurfuceType()
 {
 	EPhysicalSurface Result = EPhysicalSurface::SurfaceType_Default;
@@ -506,19 +688,26 @@ EPhysicalSurface ATPSCharacter::GetSurfuceType()
 	{
 		if (CharHealthComponent->GetCurrentShield() <= 0)
 		{
-			if (GetMesh())
-			{
-				UMaterialInterface* myMaterial = GetMesh()->GetMaterial(0);
-				if (myMaterial)
-				{
-					Result = myMaterial->GetPhysicalMaterial()->SurfaceType;
-				}
-			}
+			Result = GetCachedSurfaceType(GetMesh(), 0);
 		}
 	}
 	return Result;
 }
 
+EPhysicalSurface ATPSCharacter::GetCachedSurfaceType(const UPrimitiveComponent* Component, int32 MaterialIndex)
+{
+	if (!SurfaceTypeCache.IsBuilt())
+	{
+		SurfaceTypeCache.Build(this, GetMesh());
+	}
+	return SurfaceTypeCache.Get(Component, MaterialIndex);
+}
+
+void ATPSCharacter::InvalidateSurfaceTypeCache()
+{
+	SurfaceTypeCache.Invalidate();
+}
+
 TArray<UTPS_StateEffect*> ATPSCharacter::GetAllCurrentEffects()
 {
 	return Effects;
@@ -526,13 +715,56 @@ TArray<UTPS_StateEffect*> ATPSCharacter::GetAllCurrentEffects()
 
 void ATPSCharacter::RemoveEffect(UTPS_StateEffect* RemoveEffect)
 {
-	Effects.Remove(RemoveEffect);
+	const int32 Index = Effects.Find(RemoveEffect);
+	if (Index == INDEX_NONE)
+		return;
 
+	Effects.RemoveAt(Index);
+	if (HasAuthority() && RemoveEffect && RemoveEffect->RepInstanceId != 0)
+	{
+		const int32 InstanceId = RemoveEffect->RepInstanceId;
+		const int32 RepIndex = ActiveEffects.IndexOfByPredicate([InstanceId](const FTPSActiveEffectRep& Elem) { return Elem.InstanceId == InstanceId; });
+		if (RepIndex != INDEX_NONE)
+		{
+			ActiveEffects.RemoveAt(RepIndex);
+			MARK_PROPERTY_DIRTY_FROM_NAME(ATPSCharacter, ActiveEffects, this);
+			OnActiveEffectsChanged.Broadcast();
+		}
+	}
 }
 
 void ATPSCharacter::AddEffect(UTPS_StateEffect* newEffect)
 {
 	Effects.Add(newEffect);
+
+	UTPSGameInstance* myGI = Cast<UTPSGameInstance>(GetGameInstance());
+	if (HasAuthority() && myGI && newEffect)
+	{
+		const int32 EffectId = myGI->GetEffectIdByClass(newEffect->GetClass());
+		if (EffectId != INDEX_NONE && EffectId <= MAX_uint8)
+		{
+			FTPSActiveEffectRep& Rep = ActiveEffects.AddDefaulted_GetRef();
+			Rep.EffectId = (uint8)EffectId;
+			LastEffectInstanceId = LastEffectInstanceId == MAX_int32 ? 1 : LastEffectInstanceId + 1;
+			Rep.InstanceId = LastEffectInstanceId;
+			newEffect->RepInstanceId = Rep.InstanceId;
+			const float Duration = newEffect->GetDuration();
+			Rep.ExpireTime = Duration < 0.0f ? -1.0f : GetWorld()->GetTimeSeconds() + Duration;
+			MARK_PROPERTY_DIRTY_FROM_NAME(ATPSCharacter, ActiveEffects, this);
+			OnActiveEffectsChanged.Broadcast();
+		}
+	}
+}
+
+void ATPSCharacter::OnRep_ActiveEffects()
+{
+	OnActiveEffectsChanged.Broadcast();
+	ActiveEffectsChanged_BP();
+}
+
+void ATPSCharacter::ActiveEffectsChanged_BP_Implementation()
+{
+	// in BP
 }
 
 void ATPSCharacter::CharDead()
@@ -554,34 +786,66 @@ void ATPSCharacter::CharDead()
 	//Timer rag doll
 	GetWorldTimerManager().SetTimer(TimerHandle_RagDollTimer, this, &ATPSCharacter::EnableRagdoll, TimeAnim, false);
 
-	GetCursorToWorld()->SetVisibility(false);
+	if (GetCursorToWorld())
+		GetCursorToWorld()->SetVisibility(false);
 }
 
 void ATPSCharacter::EnableRagdoll()
 {
-	if (GetMesh())
+	UTPSCorpseSubsystem* myCorpses = GetWorld()->GetSubsystem<UTPSCorpseSubsystem>();
+	if (myCorpses)
+	{
+		myCorpses->AddCorpse(this);
+	}
+	else if (GetMesh())
 	{
 		GetMesh()->SetCollisionEnabled(ECollisionEnabled::PhysicsOnly);
 		GetMesh()->SetSimulatePhysics(true);
 	}
+
+	//physics owns the pose from here, death montage and anim graph are done
+	UTPSAnimSubsystem::StopAnimation(GetMesh());
+	if (CurrentWeapon)
+	{
+		UTPSAnimSubsystem::StopAnimation(CurrentWeapon->SkeletalMeshWeapon);
+	}
 }
 
 float ATPSCharacter::TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser)
 {
 	float ActualDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+	CSV_CUSTOM_STAT(TPS, DamageTaken, DamageAmount, ECsvCustomStatOp::Accumulate);
 	if (!CharHealthComponent->UTPSHealthComponent::CharIsDead)
 	{
 		//GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, FString::Printf(TEXT("World delta for current frame equals %f"), GetWorld()->TimeSeconds));
 		CharHealthComponent->ChangeHealthValue(-DamageAmount);
 	}
 
+	UClass* myEffect = nullptr;
 	if (DamageEvent.IsOfType(FRadialDamageEvent::ClassID))
 	{
 		AProjectileDefault* myProjectile = Cast<AProjectileDefault>(DamageCauser);
 		if (myProjectile)
 		{
 			UTypes::AddEffectBySurfaceType(this, myProjectile->ProjectileSetting.Effect, GetSurfuceType());
+			myEffect = myProjectile->ProjectileSetting.Effect;
+		}
+	}
+
+	if (FTPSTelemetry::IsEnabled())
+	{
+		//weapon id from the weapon or projectile that caused it
+		FName myWeaponName = NAME_None;
+		FVector myDirection = FVector::ZeroVector;
+		if (DamageCauser)
+		{
+			myDirection = (GetActorLocation() - DamageCauser->GetActorLocation()).GetSafeNormal();
+			if (AProjectileDefault* myProjectile = Cast<AProjectileDefault>(DamageCauser))
+				myWeaponName = myProjectile->WeaponIdName;
+			else if (AWeaponDefault* myWeapon = Cast<AWeaponDefault>(DamageCauser))
+				myWeaponName = myWeapon->WeaponIdName;
 		}
+		FTPSTelemetry::Record(GetWorld(), ETPSTelemetryType::Damage, myWeaponName, GetActorLocation(), myDirection, this, GetSurfuceType(), DamageAmount, myEffect);
 	}
 
 	return ActualDamage;
@@ -13,13 +13,18 @@
 
 #include "TPSCharacter.generated.h"
 
+//native, on server and owning client, HUD view-model listens
+DECLARE_MULTICAST_DELEGATE(FOnCurrentWeaponChanged);
+DECLARE_MULTICAST_DELEGATE(FOnActiveEffectsChanged);
+
 UCLASS(Blueprintable)
-class ATPSCharacter : public ACharacter, public ITPS_IGameActor
+class ATPSCharacter : public ACharacter, public ITPS_IGameActor, public ITPSRegenTarget
 {
 	GENERATED_BODY()
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 	ATPSCharacter();
@@ -76,6 +81,11 @@ public:
 	float Stamina = 1.00f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
 	bool SprintBlock = 0;
+	//stamina per second, applied by UTPSRegenSubsystem
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	float StaminaDrainPerSecond = 0.3f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	float StaminaRecoverPerSecond = 0.3f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
 	float CharacterSpeed = 0;
 	//UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
@@ -87,10 +97,25 @@ public:
 	TSubclassOf<UTPS_StateEffect> AbilityEffect;
 
 	//Weapon	
+	UPROPERTY(ReplicatedUsing = OnRep_CurrentWeapon)
 	AWeaponDefault* CurrentWeapon = nullptr;
+	UFUNCTION()
+	void OnRep_CurrentWeapon();
+	FOnCurrentWeaponChanged OnCurrentWeaponChanged;
+	void BindWeaponEvents(AWeaponDefault* Weapon);
 
 	//Effect
+	UPROPERTY()
 	TArray<UTPS_StateEffect*> Effects;
+	//server objects replicate only as ids, push model
+	UPROPERTY(ReplicatedUsing = OnRep_ActiveEffects, BlueprintReadOnly, Category = "Effect")
+	TArray<FTPSActiveEffectRep> ActiveEffects;
+	int32 LastEffectInstanceId = 0;
+	UFUNCTION()
+	void OnRep_ActiveEffects();
+	FOnActiveEffectsChanged OnActiveEffectsChanged;
+	UFUNCTION(BlueprintNativeEvent)
+	void ActiveEffectsChanged_BP();
 
 	//Inputs
 	UFUNCTION()
@@ -116,6 +141,9 @@ public:
 	void CharacterUpdate();
 	UFUNCTION(BlueprintCallable)
 	void ChangeMovementState();
+	//server weapon sim needs the state for dispersion and fire block
+	UFUNCTION(Server, Reliable)
+	void ServerSetMovementState(EMovementState NewMovementState);
 
 	UFUNCTION(BlueprintCallable)
 	AWeaponDefault* GetCurrentWeapon();
@@ -135,6 +163,8 @@ public:
 	void WeaponReloadEnd_BP(bool bIsSuccess);
 	UFUNCTION()
 	void WeaponFireStart(UAnimMontage* Anim);
+	UFUNCTION()
+	void WeaponFired();
 	UFUNCTION(BlueprintNativeEvent)
 	void WeaponFireStart_BP(UAnimMontage* Anim);
 
@@ -144,17 +174,31 @@ public:
 	//Inventory Func
 	void TrySwicthNextWeapon();
 	void TrySwitchPreviosWeapon();
+	UFUNCTION(Server, Reliable)
+	void ServerSwitchWeapon(bool bIsForward);
+	UFUNCTION(Server, Reliable)
+	void ServerReloadWeapon();
 
 	//ability func
 	void TryAbilityEnabled();
+	UFUNCTION(Server, Reliable)
+	void ServerAbilityEnabled();
 
-	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly)
+	UPROPERTY(Replicated, BlueprintReadOnly, EditDefaultsOnly)
 	int32 CurrentIndexWeapon = 0;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	//Interface
 	EPhysicalSurface GetSurfuceType() override;
+	EPhysicalSurface GetCachedSurfaceType(const UPrimitiveComponent* Component = nullptr, int32 MaterialIndex = 0) override;
+	void InvalidateSurfaceTypeCache() override;
+	FTPSSurfaceTypeCache SurfaceTypeCache;
 	TArray<UTPS_StateEffect*> GetAllCurrentEffects() override;
 	void RemoveEffect(UTPS_StateEffect* RemoveEffect)override;
+
+	bool ApplyRegen(ETPSRegenChannel Channel, float Amount, float ElapsedTime) override;
+	int32 StaminaRegenHandle = INDEX_NONE;
 	void AddEffect(UTPS_StateEffect* newEffect)override;
 	//End Interface
 
@@ -2,7 +2,51 @@
 
 
 #include "TPSCharacterHealthComponent.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 
+void UTPSCharacterHealthComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UTPSCharacterHealthComponent, Shield, Params);
+}
+
+void UTPSCharacterHealthComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UTPSRegenSubsystem* myRegen = GetWorld()->GetSubsystem<UTPSRegenSubsystem>();
+	if (myRegen && GetOwnerRole() == ROLE_Authority)
+	{
+		//one ShieldRecoverValue step every ShieldRecoverRate seconds, as the old looping timer
+		ShieldRegenHandle = myRegen->Register(this, ETPSRegenChannel::Shield, ShieldRecoverValue / FMath::Max(ShieldRecoverRate, KINDA_SMALL_NUMBER), ShieldRecoverRate, false);
+		if (HealthRegenPerSecond > 0.0f)
+		{
+			HealthRegenHandle = myRegen->Register(this, ETPSRegenChannel::Health, HealthRegenPerSecond, 0.0f, false);
+		}
+	}
+}
+
+void UTPSCharacterHealthComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UTPSRegenSubsystem* myRegen = GetWorld()->GetSubsystem<UTPSRegenSubsystem>();
+	if (myRegen)
+	{
+		myRegen->Unregister(ShieldRegenHandle);
+		myRegen->Unregister(HealthRegenHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UTPSCharacterHealthComponent::OnRep_Shield(float OldShield)
+{
+	ShowDamage(OldShield - Shield);
+	OnShieldChange.Broadcast(Shield, Shield - OldShield);
+}
 
 
 void UTPSCharacterHealthComponent::ChangeHealthValue(float ChangeValue)
@@ -28,6 +72,12 @@ void UTPSCharacterHealthComponent::ChangeHealthValue(float ChangeValue)
 				Super::ChangeHealthValue(ChangeValue);
 			}
 		}
+
+		UTPSRegenSubsystem* myRegen = GetWorld() ? GetWorld()->GetSubsystem<UTPSRegenSubsystem>() : nullptr;
+		if (myRegen && ChangeValue < 0.0f)
+		{
+			myRegen->SetCooldown(HealthRegenHandle, HealthRegenCoolDownTime);
+		}
 	}
 }
 
@@ -36,8 +86,15 @@ float UTPSCharacterHealthComponent::GetCurrentShield()
 	return Shield;
 }
 
+void UTPSCharacterHealthComponent::SetCurrentShield(float NewShield)
+{
+	Shield = FMath::Clamp(NewShield, 0.0f, 100.0f);
+	MARK_PROPERTY_DIRTY_FROM_NAME(UTPSCharacterHealthComponent, Shield, this);
+}
+
 void UTPSCharacterHealthComponent::ChangeShieldValue(float ChangeValue)
 {
+	const float OldShield = Shield;
 	Shield += ChangeValue;
 
 	if (Shield > 100.0f)
@@ -49,41 +106,38 @@ void UTPSCharacterHealthComponent::ChangeShieldValue(float ChangeValue)
 		if(Shield < 0.0f)
 			Shield = 0.0f;
 	}
+	MARK_PROPERTY_DIRTY_FROM_NAME(UTPSCharacterHealthComponent, Shield, this);
 
-	if (GetWorld())
+	UTPSRegenSubsystem* myRegen = GetWorld() ? GetWorld()->GetSubsystem<UTPSRegenSubsystem>() : nullptr;
+	if (myRegen)
 	{
-		GetWorld()->GetTimerManager().SetTimer(TimerHandle_CollDownShieldTimer, this, &UTPSCharacterHealthComponent::CoolDownShieldEnd, CoolDownShieldRecoverTime, false);
-
-		GetWorld()->GetTimerManager().ClearTimer(TimerHandle_ShieldRecoveryRateTimer);
-	}	
+		myRegen->SetCooldown(ShieldRegenHandle, CoolDownShieldRecoverTime);
+	}
 
+	ShowDamage(OldShield - Shield);
 	OnShieldChange.Broadcast(Shield, ChangeValue);
 }
 
-void UTPSCharacterHealthComponent::CoolDownShieldEnd()
+bool UTPSCharacterHealthComponent::ApplyRegen(ETPSRegenChannel Channel, float Amount, float ElapsedTime)
 {
-	if (GetWorld() && UTPSHealthComponent::CharIsDead != 1)
-	{		
-		GetWorld()->GetTimerManager().SetTimer(TimerHandle_ShieldRecoveryRateTimer, this, &UTPSCharacterHealthComponent::RecoveryShield, ShieldRecoverRate, true);
-	}	
-}
+	if (UTPSHealthComponent::CharIsDead)
+		return false;
 
-void UTPSCharacterHealthComponent::RecoveryShield()
-{
-	float tmp = Shield;
-	tmp = tmp + ShieldRecoverValue;
-	if (tmp > 100.0f)
+	switch (Channel)
 	{
-		Shield = 100.0f;
-		if (GetWorld())
+	case ETPSRegenChannel::Shield:
+		//several ShieldRecoverValue steps after a long frame
+		SetCurrentShield(Shield + Amount);
+		OnShieldChange.Broadcast(Shield, Amount);
+		return Shield < 100.0f;
+	case ETPSRegenChannel::Health:
+		if (HealthChangeBlock == 0)
 		{
-			GetWorld()->GetTimerManager().ClearTimer(TimerHandle_ShieldRecoveryRateTimer);
+			SetCurrentHealth(FMath::Min(GetCurrentHealth() + Amount, 100.0f));
+			OnHealthChange.Broadcast(GetCurrentHealth(), Amount);
 		}
+		return GetCurrentHealth() < 100.0f;
+	default:
+		return false;
 	}
-	else
-	{
-		Shield = tmp;
-	}
-
-	OnShieldChange.Broadcast(Shield, ShieldRecoverValue);
 }
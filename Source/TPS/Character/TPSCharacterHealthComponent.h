@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "TPSHealthComponent.h"
+#include "../Game/TPSRegenSubsystem.h"
 #include "TPSCharacterHealthComponent.generated.h"
 
 /**
@@ -12,7 +13,7 @@
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnShieldChange, float, Shield, float, Damage);
 
 UCLASS()
-class TPS_API UTPSCharacterHealthComponent : public UTPSHealthComponent
+class TPS_API UTPSCharacterHealthComponent : public UTPSHealthComponent, public ITPSRegenTarget
 {
 	GENERATED_BODY()
 	
@@ -20,13 +21,20 @@ public:
 	UPROPERTY(BlueprintAssignable, EditAnywhere, BlueprintReadWrite, Category = "Health")
 	FOnShieldChange OnShieldChange;
 
-	FTimerHandle TimerHandle_CollDownShieldTimer;
-	FTimerHandle TimerHandle_ShieldRecoveryRateTimer;
-
 protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	//UTPSRegenSubsystem handles, server only
+	int32 ShieldRegenHandle = INDEX_NONE;
+	int32 HealthRegenHandle = INDEX_NONE;
 
+	UPROPERTY(ReplicatedUsing = OnRep_Shield)
 	float Shield = 100.0f;
 
+	UFUNCTION()
+	void OnRep_Shield(float OldShield);
+
 public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shield")
@@ -35,17 +43,23 @@ public:
 	float ShieldRecoverValue = 1.0f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shield")
 	float ShieldRecoverRate = 0.1f;
+	//health per second after HealthRegenCoolDownTime without damage, 0 - off
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Health")
+	float HealthRegenPerSecond = 0.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Health")
+	float HealthRegenCoolDownTime = 5.0f;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Effect")
 	bool HealthChangeBlock = 0;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	void ChangeHealthValue(float ChangeValue) override;
 
 	float GetCurrentShield();
+	void SetCurrentShield(float NewShield);
 
 	void ChangeShieldValue(float ChangeValue);
 
-	void CoolDownShieldEnd();
-
-	void RecoveryShield();
+	bool ApplyRegen(ETPSRegenChannel Channel, float Amount, float ElapsedTime) override;
 };
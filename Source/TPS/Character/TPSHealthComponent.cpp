@@ -2,6 +2,9 @@
 
 
 #include "TPSHealthComponent.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "../Game/TPSDamageNumberSubsystem.h"
 
 // Sets default values for this component's properties
 UTPSHealthComponent::UTPSHealthComponent()
@@ -11,6 +14,38 @@ UTPSHealthComponent::UTPSHealthComponent()
 	PrimaryComponentTick.bCanEverTick = true;
 
 	// ...
+	SetIsReplicatedByDefault(true);
+}
+
+void UTPSHealthComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UTPSHealthComponent, Health, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(UTPSHealthComponent, CharIsDead, Params);
+}
+
+void UTPSHealthComponent::OnRep_Health(float OldHealth)
+{
+	ShowDamage(OldHealth - Health);
+	OnHealthChange.Broadcast(Health, Health - OldHealth);
+}
+
+void UTPSHealthComponent::ShowDamage(float Damage)
+{
+	UTPSDamageNumberSubsystem* myDamageNumbers = Damage > 0.0f && GetWorld() ? GetWorld()->GetSubsystem<UTPSDamageNumberSubsystem>() : nullptr;
+	if (myDamageNumbers)
+	{
+		myDamageNumbers->AddDamage(GetOwner(), Damage);
+	}
+}
+
+void UTPSHealthComponent::OnRep_CharIsDead()
+{
+	if (CharIsDead)
+		OnDead.Broadcast();
 }
 
 
@@ -40,13 +75,16 @@ float UTPSHealthComponent::GetCurrentHealth()
 void UTPSHealthComponent::SetCurrentHealth(float NewHealth)
 {
 	Health = NewHealth;
+	MARK_PROPERTY_DIRTY_FROM_NAME(UTPSHealthComponent, Health, this);
 }
 
 void UTPSHealthComponent::ChangeHealthValue(float ChangeValue)
 {
 	ChangeValue = ChangeValue * CoefDamage;
 
+	const float OldHealth = Health;
 	Health += ChangeValue;
+	MARK_PROPERTY_DIRTY_FROM_NAME(UTPSHealthComponent, Health, this);
 
 	if (Health > 100.0f)
 	{
@@ -57,9 +95,11 @@ void UTPSHealthComponent::ChangeHealthValue(float ChangeValue)
 		if (Health <= 0.0f)
 		{
 			CharIsDead = true;
+			MARK_PROPERTY_DIRTY_FROM_NAME(UTPSHealthComponent, CharIsDead, this);
 			OnDead.Broadcast();
 		}
 	}
 
+	ShowDamage(OldHealth - Health);
 	OnHealthChange.Broadcast(Health, ChangeValue);
 }
\ No newline at end of file
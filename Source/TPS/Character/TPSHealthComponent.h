@@ -27,15 +27,26 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	//push model, mark dirty on every write
+	UPROPERTY(ReplicatedUsing = OnRep_Health)
 	float Health = 100.0f;
 
+	UFUNCTION()
+	void OnRep_Health(float OldHealth);
+	UFUNCTION()
+	void OnRep_CharIsDead();
+	//floating damage number on this machine, Damage > 0
+	void ShowDamage(float Damage);
+
 public:	
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Health")
 	float CoefDamage = 1.0f;
-	UPROPERTY(EditAnywhere)
+	UPROPERTY(ReplicatedUsing = OnRep_CharIsDead, EditAnywhere)
 	bool CharIsDead = false;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 	UFUNCTION(BlueprintCallable, Category = "Health")
@@ -3,8 +3,20 @@
 
 #include "TPSInventoryComponent.h"
 #include "../Game/TPSGameInstance.h"
+#include "../Game/TPSWorldItemSubsystem.h"
+#include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
 #pragma optimize ("", off)
 
+float WorldItemsAutoPickupRadius = 0.0f;
+FAutoConsoleVariableRef CVARWorldItemsAutoPickupRadius{
+	TEXT("TPS.WorldItems.AutoPickupRadius"),
+	WorldItemsAutoPickupRadius,
+	TEXT("Server takes pickups this close to a character without overlap, 0 - overlap only"),
+	ECVF_Default
+};
+const float AutoPickupInterval = 0.25f;
+
 // Sets default values for this component's properties
 UTPSInventoryComponent::UTPSInventoryComponent()
 {
@@ -13,6 +25,17 @@ UTPSInventoryComponent::UTPSInventoryComponent()
 	PrimaryComponentTick.bCanEverTick = true;
 
 	// ...
+	SetIsReplicatedByDefault(true);
+	RepWeaponSlots.Owner = this;
+	RepAmmoSlots.Owner = this;
+}
+
+void UTPSInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(UTPSInventoryComponent, RepWeaponSlots, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(UTPSInventoryComponent, RepAmmoSlots, COND_OwnerOnly);
 }
 
 
@@ -47,11 +70,20 @@ void UTPSInventoryComponent::BeginPlay()
 
 	MaxSlotsWeapon = WeaponSlots.Num();
 
+	RepWeaponSlots.Owner = this;
+	RepAmmoSlots.Owner = this;
+	MarkAllSlotsDirty();
+
 	if (WeaponSlots.IsValidIndex(0))
 	{
 		if(!WeaponSlots[0].NameItem.IsNone())
 			OnSwitchWeapon.Broadcast(WeaponSlots[0].NameItem, WeaponSlots[0].AdditionalInfo, 0);
 	}
+
+	if (GetOwner() && GetOwner()->HasAuthority())
+	{
+		GetWorld()->GetTimerManager().SetTimer(AutoPickupTimer, this, &UTPSInventoryComponent::AutoPickup, AutoPickupInterval, true, FMath::FRand() * AutoPickupInterval);
+	}
 }
 
 
@@ -463,6 +495,7 @@ void UTPSInventoryComponent::SetAdditionalInfoWeapon(int32 IndexWeapon, FAdditio
 			{
 				WeaponSlots[i].AdditionalInfo = NewInfo;
 				bIsFind = true;
+				MarkWeaponSlotDirty(i);
 
 				OnWeaponAdditionalInfoChange.Broadcast(IndexWeapon,NewInfo);
 			}
@@ -486,6 +519,7 @@ void UTPSInventoryComponent::AmmoSlotChangeValue(EWeaponType TypeWeapon, int32 C
 			AmmoSlots[i].Cout += CoutChangeAmmo;
 			if (AmmoSlots[i].Cout > AmmoSlots[i].MaxCout)
 				AmmoSlots[i].Cout = AmmoSlots[i].MaxCout;
+			MarkAmmoSlotDirty(i);
 		
 			OnAmmoChange.Broadcast(AmmoSlots[i].WeaponType, AmmoSlots[i].Cout);
 
@@ -558,6 +592,7 @@ bool UTPSInventoryComponent::SwitchWeaponToInventory(FWeaponSlot NewWeapon, int3
 	if (WeaponSlots.IsValidIndex(IndexSlot) && GetDropItemInfoFromInventory(IndexSlot, DropItemInfo))
 	{
 		WeaponSlots[IndexSlot] = NewWeapon;
+		MarkWeaponSlotDirty(IndexSlot);
 	
 		SwitchWeaponToIndex(CurrentIndexWeaponChar,-1,NewWeapon.AdditionalInfo,true);	
 
@@ -575,6 +610,7 @@ bool UTPSInventoryComponent::TryGetWeaponToInventory(FWeaponSlot NewWeapon)
 		if (WeaponSlots.IsValidIndex(indexSlot))
 		{
 			WeaponSlots[indexSlot] = NewWeapon;
+			MarkWeaponSlotDirty(indexSlot);
 
 			OnUpdateWeaponSlots.Broadcast(indexSlot, NewWeapon);
 			return true;
@@ -583,6 +619,88 @@ bool UTPSInventoryComponent::TryGetWeaponToInventory(FWeaponSlot NewWeapon)
 	return false;
 }
 
+TArray<AActor*> UTPSInventoryComponent::GetTakeableItemsNearby(float Radius, int32 MaxCount)
+{
+	TArray<AActor*> Result;
+	UTPSWorldItemSubsystem* myItems = GetWorld()->GetSubsystem<UTPSWorldItemSubsystem>();
+	if (!myItems || !GetOwner())
+		return Result;
+
+	//inventory checks once for all candidates
+	uint32 AmmoTypeMask = 0;
+	for (const FAmmoSlot& Slot : AmmoSlots)
+	{
+		if (CheckCanTakeAmmo(Slot.WeaponType))
+			AmmoTypeMask |= 1u << (uint32)Slot.WeaponType;
+	}
+	int32 FreeSlot = INDEX_NONE;
+	const bool bCanTakeWeapon = CheckCanTakeWeapon(FreeSlot);
+
+	const FVector Location = GetOwner()->GetActorLocation();
+	if (AmmoTypeMask != 0)
+	{
+		FTPSWorldItemFilter AmmoFilter;
+		AmmoFilter.Kind = ETPSWorldItemKind::Ammo;
+		AmmoFilter.WeaponTypeMask = AmmoTypeMask;
+		myItems->FindNearest(Location, MaxCount, Radius, AmmoFilter, Result);
+	}
+	if (bCanTakeWeapon)
+	{
+		FTPSWorldItemFilter WeaponFilter;
+		WeaponFilter.Kind = ETPSWorldItemKind::Weapon;
+		TArray<AActor*> myWeapons;
+		myItems->FindNearest(Location, MaxCount, Radius, WeaponFilter, myWeapons);
+		Result.Append(myWeapons);
+
+		Result.Sort([Location](const AActor& A, const AActor& B)
+		{
+			return FVector::DistSquared(Location, A.GetActorLocation()) < FVector::DistSquared(Location, B.GetActorLocation());
+		});
+		if (Result.Num() > MaxCount)
+			Result.SetNum(MaxCount);
+	}
+	return Result;
+}
+
+int32 UTPSInventoryComponent::TakeItemsNearby(float Radius, int32 MaxCount)
+{
+	AActor* myOwner = GetOwner();
+	if (!myOwner || !myOwner->HasAuthority())
+		return 0;
+
+	static const FName ToInventoryEvent(TEXT("ToInventory"));
+	static const FName OverlapCharacterVariable(TEXT("OverlapCharacter"));
+
+	int32 Result = 0;
+	for (AActor* Item : GetTakeableItemsNearby(Radius, MaxCount))
+	{
+		//PickupActorSystem: ToInventory(InventoryComponent) runs CheckCanTakeAmmo/TryGetWeaponToInventory and destroys the item on success
+		UFunction* myEvent = Item->FindFunction(ToInventoryEvent);
+		const FObjectProperty* myParam = myEvent && myEvent->NumParms == 1 ? CastField<FObjectProperty>(myEvent->PropertyLink) : nullptr;
+		if (!myParam || !IsA(myParam->PropertyClass))
+			continue;
+
+		const FObjectProperty* myCharacter = CastField<FObjectProperty>(Item->GetClass()->FindPropertyByName(OverlapCharacterVariable));
+		if (myCharacter && myOwner->IsA(myCharacter->PropertyClass))
+		{
+			myCharacter->SetObjectPropertyValue_InContainer(Item, myOwner);
+		}
+
+		UTPSInventoryComponent* Params = this;
+		Item->ProcessEvent(myEvent, &Params);
+		Result++;
+	}
+	return Result;
+}
+
+void UTPSInventoryComponent::AutoPickup()
+{
+	if (WorldItemsAutoPickupRadius > 0.0f)
+	{
+		TakeItemsNearby(WorldItemsAutoPickupRadius);
+	}
+}
+
 bool UTPSInventoryComponent::GetDropItemInfoFromInventory(int32 IndexSlot, FDropItem &DropItemInfo)
 {
 	bool result = false;
@@ -602,4 +720,110 @@ bool UTPSInventoryComponent::GetDropItemInfoFromInventory(int32 IndexSlot, FDrop
 	return result;
 }
 
+void UTPSInventoryComponent::MarkWeaponSlotDirty(int32 IndexSlot)
+{
+	if (!GetOwner() || !GetOwner()->HasAuthority() || !WeaponSlots.IsValidIndex(IndexSlot))
+		return;
+
+	FTPSWeaponSlotItem* Item = RepWeaponSlots.Items.FindByPredicate([IndexSlot](const FTPSWeaponSlotItem& Elem) { return Elem.SlotIndex == IndexSlot; });
+	if (!Item)
+	{
+		Item = &RepWeaponSlots.Items.AddDefaulted_GetRef();
+		Item->SlotIndex = IndexSlot;
+	}
+	Item->Slot = WeaponSlots[IndexSlot];
+	RepWeaponSlots.MarkItemDirty(*Item);
+}
+
+void UTPSInventoryComponent::MarkAmmoSlotDirty(int32 IndexSlot)
+{
+	if (!GetOwner() || !GetOwner()->HasAuthority() || !AmmoSlots.IsValidIndex(IndexSlot))
+		return;
+
+	FTPSAmmoSlotItem* Item = RepAmmoSlots.Items.FindByPredicate([IndexSlot](const FTPSAmmoSlotItem& Elem) { return Elem.SlotIndex == IndexSlot; });
+	if (!Item)
+	{
+		Item = &RepAmmoSlots.Items.AddDefaulted_GetRef();
+		Item->SlotIndex = IndexSlot;
+	}
+	Item->Slot = AmmoSlots[IndexSlot];
+	RepAmmoSlots.MarkItemDirty(*Item);
+}
+
+void UTPSInventoryComponent::MarkAllSlotsDirty()
+{
+	if (!GetOwner() || !GetOwner()->HasAuthority())
+		return;
+
+	RepWeaponSlots.Items.Reset();
+	RepAmmoSlots.Items.Reset();
+	for (int32 i = 0; i < WeaponSlots.Num(); i++)
+	{
+		MarkWeaponSlotDirty(i);
+	}
+	for (int32 i = 0; i < AmmoSlots.Num(); i++)
+	{
+		MarkAmmoSlotDirty(i);
+	}
+	RepWeaponSlots.MarkArrayDirty();
+	RepAmmoSlots.MarkArrayDirty();
+}
+
+void UTPSInventoryComponent::ApplyReplicatedWeaponSlot(const FTPSWeaponSlotItem& Item)
+{
+	if (Item.SlotIndex < 0)
+		return;
+
+	if (!WeaponSlots.IsValidIndex(Item.SlotIndex))
+	{
+		WeaponSlots.SetNum(Item.SlotIndex + 1);
+		MaxSlotsWeapon = WeaponSlots.Num();
+	}
+
+	FWeaponSlot& Slot = WeaponSlots[Item.SlotIndex];
+	const bool bIsNewWeapon = Slot.NameItem != Item.Slot.NameItem;
+	Slot = Item.Slot;
+
+	if (bIsNewWeapon)
+		OnUpdateWeaponSlots.Broadcast(Item.SlotIndex, Slot);
+	else
+		OnWeaponAdditionalInfoChange.Broadcast(Item.SlotIndex, Slot.AdditionalInfo);
+}
+
+void UTPSInventoryComponent::ApplyReplicatedAmmoSlot(const FTPSAmmoSlotItem& Item)
+{
+	if (Item.SlotIndex < 0)
+		return;
+
+	if (!AmmoSlots.IsValidIndex(Item.SlotIndex))
+		AmmoSlots.SetNum(Item.SlotIndex + 1);
+
+	AmmoSlots[Item.SlotIndex] = Item.Slot;
+	OnAmmoChange.Broadcast(Item.Slot.WeaponType, Item.Slot.Cout);
+}
+
+void FTPSWeaponSlotItem::PostReplicatedAdd(const FTPSWeaponSlotArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+		InArraySerializer.Owner->ApplyReplicatedWeaponSlot(*this);
+}
+
+void FTPSWeaponSlotItem::PostReplicatedChange(const FTPSWeaponSlotArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+		InArraySerializer.Owner->ApplyReplicatedWeaponSlot(*this);
+}
+
+void FTPSAmmoSlotItem::PostReplicatedAdd(const FTPSAmmoSlotArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+		InArraySerializer.Owner->ApplyReplicatedAmmoSlot(*this);
+}
+
+void FTPSAmmoSlotItem::PostReplicatedChange(const FTPSAmmoSlotArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+		InArraySerializer.Owner->ApplyReplicatedAmmoSlot(*this);
+}
+
 #pragma optimize ("", on)
@@ -4,9 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Engine/NetSerialization.h"
 #include "../FuncLibrary/Types.h"
 #include "TPSInventoryComponent.generated.h"
 
+class UTPSInventoryComponent;
+
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnSwitchWeapon, FName, WeaponIdName, FAdditionalWeaponInfo, WeaponAdditionalInfo, int32, NewCurrentIndexWeapon);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnAmmoChange, EWeaponType, TypeAmmo, int32, Cout);
@@ -15,6 +18,80 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnWeaponAmmoEmpty, EWeaponType, Wea
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnWeaponAmmoAviable, EWeaponType, WeaponType);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnUpdateWeaponSlots, int32, IndexSlotChange, FWeaponSlot, NewInfo);
 
+//Replicated copy of one WeaponSlots entry, only changed items are sent
+USTRUCT()
+struct FTPSWeaponSlotItem : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 SlotIndex = INDEX_NONE;
+	UPROPERTY()
+	FWeaponSlot Slot;
+
+	void PostReplicatedAdd(const struct FTPSWeaponSlotArray& InArraySerializer);
+	void PostReplicatedChange(const struct FTPSWeaponSlotArray& InArraySerializer);
+};
+
+USTRUCT()
+struct FTPSWeaponSlotArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FTPSWeaponSlotItem> Items;
+	UPROPERTY(NotReplicated)
+	UTPSInventoryComponent* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FTPSWeaponSlotItem, FTPSWeaponSlotArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FTPSWeaponSlotArray> : public TStructOpsTypeTraitsBase2<FTPSWeaponSlotArray>
+{
+	enum { WithNetDeltaSerializer = true };
+};
+
+//Replicated copy of one AmmoSlots entry
+USTRUCT()
+struct FTPSAmmoSlotItem : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 SlotIndex = INDEX_NONE;
+	UPROPERTY()
+	FAmmoSlot Slot;
+
+	void PostReplicatedAdd(const struct FTPSAmmoSlotArray& InArraySerializer);
+	void PostReplicatedChange(const struct FTPSAmmoSlotArray& InArraySerializer);
+};
+
+USTRUCT()
+struct FTPSAmmoSlotArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FTPSAmmoSlotItem> Items;
+	UPROPERTY(NotReplicated)
+	UTPSInventoryComponent* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FTPSAmmoSlotItem, FTPSAmmoSlotArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FTPSAmmoSlotArray> : public TStructOpsTypeTraitsBase2<FTPSAmmoSlotArray>
+{
+	enum { WithNetDeltaSerializer = true };
+};
+
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class TPS_API UTPSInventoryComponent : public UActorComponent
 {
@@ -52,6 +129,17 @@ public:
 
 	int32 MaxSlotsWeapon = 0;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	//server: copy slot into replicated array, no-op on clients
+	void MarkWeaponSlotDirty(int32 IndexSlot);
+	void MarkAmmoSlotDirty(int32 IndexSlot);
+	void MarkAllSlotsDirty();
+
+	//client: apply replicated item to WeaponSlots/AmmoSlots and fire delegates
+	void ApplyReplicatedWeaponSlot(const FTPSWeaponSlotItem& Item);
+	void ApplyReplicatedAmmoSlot(const FTPSAmmoSlotItem& Item);
+
 	//TODO OMG Refactoring need!!!
 	bool SwitchWeaponToIndex(int32 ChangeToIndex, int32 OldIndex, FAdditionalWeaponInfo OldInfo, bool bIsForward);
 
@@ -77,4 +165,21 @@ public:
 
 	UFUNCTION(BlueprintCallable, Category = "Interface")
 	bool GetDropItemInfoFromInventory(int32 IndexSlot, FDropItem &DropItemInfo);
+	//pickups around the owner this inventory has room for, nearest first: ammo with free space, weapons while a slot is free
+	UFUNCTION(BlueprintCallable, Category = "Interface")
+	TArray<AActor*> GetTakeableItemsNearby(float Radius, int32 MaxCount = 8);
+	//server: hands every takeable pickup around to its ToInventory event, same as walking into it, returns how many
+	UFUNCTION(BlueprintCallable, Category = "Interface")
+	int32 TakeItemsNearby(float Radius, int32 MaxCount = 8);
+
+protected:
+	//TPS.WorldItems.AutoPickupRadius
+	void AutoPickup();
+	FTimerHandle AutoPickupTimer;
+
+	//owner only, WeaponSlots/AmmoSlots stay the working copy on every machine
+	UPROPERTY(Replicated)
+	FTPSWeaponSlotArray RepWeaponSlots;
+	UPROPERTY(Replicated)
+	FTPSAmmoSlotArray RepAmmoSlots;
 };
@@ -0,0 +1,493 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSMicroBenchCommandlet.h"
+#include "../Game/TPSGameInstance.h"
+#include "../Character/TPSInventoryComponent.h"
+#include "../Structure/TPS_EnvironmentStructure.h"
+#include "../StateEffects/TPS_StateEffect.h"
+#include "../FuncLibrary/Types.h"
+#include "../Weapon/TPSWeaponSim.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/DataTable.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTLS.h"
+
+//Forwards everything to the real allocator, counts allocations made by one thread
+class FTPSCountingMalloc : public FMalloc
+{
+public:
+	FTPSCountingMalloc(FMalloc* InInner, uint32 InThreadId) : Inner(InInner), ThreadId(InThreadId) {}
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAlloc();
+		return Inner->Malloc(Count, Alignment);
+	}
+	virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAlloc();
+		return Inner->TryMalloc(Count, Alignment);
+	}
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		if (!Original)
+			CountAlloc();
+		return Inner->Realloc(Original, Count, Alignment);
+	}
+	virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		if (!Original)
+			CountAlloc();
+		return Inner->TryRealloc(Original, Count, Alignment);
+	}
+	virtual void Free(void* Original) override { Inner->Free(Original); }
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+	virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+	virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+	virtual void UpdateStats() override { Inner->UpdateStats(); }
+	virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+	virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+	virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+	virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+	virtual const TCHAR* GetDescriptiveName() override { return TEXT("TPSCountingMalloc"); }
+
+	//only ThreadId writes it
+	int64 NumAllocs = 0;
+
+private:
+	void CountAlloc()
+	{
+		if (FPlatformTLS::GetCurrentThreadId() == ThreadId)
+			NumAllocs++;
+	}
+
+	FMalloc* Inner = nullptr;
+	const uint32 ThreadId = 0;
+};
+
+UTPSMicroBenchCommandlet::UTPSMicroBenchCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+bool UTPSMicroBenchCommandlet::ShouldRun(const TCHAR* Group) const
+{
+	return Filter.IsEmpty() || FString(Group).Contains(Filter);
+}
+
+template<typename FuncType>
+FTPSMicroBenchResult UTPSMicroBenchCommandlet::RunBench(const FString& Name, FuncType&& Func)
+{
+	//warm up caches and lazy init
+	for (int32 i = 0; i < NumWarmupIterations; i++)
+	{
+		Func();
+	}
+
+	const int64 StartAllocs = CountingMalloc ? CountingMalloc->NumAllocs : 0;
+	int64 Iterations = 0;
+	int64 Batch = 64;
+	const double StartTime = FPlatformTime::Seconds();
+	double Elapsed = 0.0;
+	while (Elapsed < MinTime)
+	{
+		for (int64 i = 0; i < Batch; i++)
+		{
+			Func();
+		}
+		Iterations += Batch;
+		Batch = FMath::Min<int64>(Batch * 2, 1 << 16);
+		Elapsed = FPlatformTime::Seconds() - StartTime;
+	}
+	const int64 NumAllocs = CountingMalloc ? CountingMalloc->NumAllocs - StartAllocs : 0;
+
+	FTPSMicroBenchResult Result;
+	Result.Name = Name;
+	Result.Iterations = Iterations;
+	Result.NsPerOp = Elapsed * 1.0e9 / Iterations;
+	Result.AllocsPerOp = (double)NumAllocs / Iterations;
+	Results.Add(Result);
+
+	UE_LOG(LogTemp, Display, TEXT("%-56s %12.1f ns/op %8.2f allocs/op (%lld iterations)"), *Result.Name, Result.NsPerOp, Result.AllocsPerOp, Result.Iterations);
+	return Result;
+}
+
+int32 UTPSMicroBenchCommandlet::Main(const FString& Params)
+{
+	FParse::Value(*Params, TEXT("Filter="), Filter);
+	FParse::Value(*Params, TEXT("Output="), OutputFile);
+	FParse::Value(*Params, TEXT("Rows="), NumRows);
+	FParse::Value(*Params, TEXT("MinTime="), MinTime);
+	FParse::Value(*Params, TEXT("Baseline="), BaselineFile);
+	FParse::Value(*Params, TEXT("Threshold="), RegressionThresholdPercent);
+	FParse::Value(*Params, TEXT("MinShotsPerSecond="), MinWeaponSimShotsPerSecond);
+
+	//installed once before anything runs and never swapped back, other threads may be inside GMalloc at any time
+	static FTPSCountingMalloc TPSCountingMalloc(GMalloc, FPlatformTLS::GetCurrentThreadId());
+	if (GMalloc != &TPSCountingMalloc)
+	{
+		GMalloc = &TPSCountingMalloc;
+	}
+	CountingMalloc = &TPSCountingMalloc;
+
+	//Map-less transient world, actors and components only need GetWorld()->GetGameInstance()
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("TPSMicroBench"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	UTPSGameInstance* myGI = NewObject<UTPSGameInstance>(GEngine);
+	WorldContext.OwningGameInstance = myGI;
+	World->SetGameInstance(myGI);
+
+	//synthetic tables
+	myGI->WeaponInfoTable = NewObject<UDataTable>(GetTransientPackage(), TEXT("DT_WeaponInfo_Bench"));
+	myGI->WeaponInfoTable->RowStruct = FWeaponInfo::StaticStruct();
+	myGI->DropItemInfoTable = NewObject<UDataTable>(GetTransientPackage(), TEXT("DT_DropItemInfo_Bench"));
+	myGI->DropItemInfoTable->RowStruct = FDropItem::StaticStruct();
+	for (int32 i = 0; i < NumRows; i++)
+	{
+		const FName RowName(*FString::Printf(TEXT("Weapon_%d"), i));
+		FWeaponInfo WeaponRow;
+		WeaponRow.WeaponType = (EWeaponType)(i % 4);
+		myGI->WeaponInfoTable->AddRow(RowName, WeaponRow);
+
+		FDropItem DropRow;
+		DropRow.WeaponInfo.NameItem = RowName;
+		myGI->DropItemInfoTable->AddRow(FName(*FString::Printf(TEXT("Drop_%d"), i)), DropRow);
+	}
+
+	if (ShouldRun(TEXT("Inventory")))
+		BenchInventorySwitch(World, myGI);
+	if (ShouldRun(TEXT("DataTable")))
+		BenchDataTableLookup(myGI);
+	if (ShouldRun(TEXT("Effect")))
+		BenchAddEffectBySurface(World);
+	if (ShouldRun(TEXT("WeaponSim")))
+		BenchWeaponSim();
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	WriteOutput();
+	if (!BaselineFile.IsEmpty() && !CompareWithBaseline())
+		bFailed = true;
+	return bFailed ? 1 : 0;
+}
+
+void UTPSMicroBenchCommandlet::BenchInventorySwitch(UWorld* World, UTPSGameInstance* GameInstance)
+{
+	AActor* Owner = World->SpawnActor<AActor>();
+	UTPSInventoryComponent* myInv = NewObject<UTPSInventoryComponent>(Owner);
+	myInv->RegisterComponent();
+
+	const int32 SlotCounts[] = { 2, 8, 32 };
+	const int32 AmmoCounts[] = { 4, 32 };
+	//0 - every slot loaded, 1 - slots empty but ammo at end of list, 2 - nothing to switch to
+	const TCHAR* CaseNames[] = { TEXT("Loaded"), TEXT("EmptyAmmoLast"), TEXT("EmptyNoAmmo") };
+
+	for (int32 NumSlots : SlotCounts)
+	{
+		for (int32 NumAmmo : AmmoCounts)
+		{
+			for (int32 Case = 0; Case < 3; Case++)
+			{
+				myInv->WeaponSlots.Empty();
+				for (int32 i = 0; i < NumSlots; i++)
+				{
+					FWeaponSlot Slot;
+					Slot.NameItem = FName(*FString::Printf(TEXT("Weapon_%d"), i * 4 % FMath::Max(NumRows, 1)));
+					Slot.AdditionalInfo.Round = Case == 0 ? 10 : 0;
+					myInv->WeaponSlots.Add(Slot);
+				}
+				myInv->AmmoSlots.Empty();
+				for (int32 i = 0; i < NumAmmo; i++)
+				{
+					FAmmoSlot Slot;
+					Slot.WeaponType = (i == NumAmmo - 1) ? EWeaponType::Pistol : EWeaponType::GrenadeLauncher;
+					Slot.Cout = (Case == 2) ? 0 : 10;
+					myInv->AmmoSlots.Add(Slot);
+				}
+				myInv->MaxSlotsWeapon = NumSlots;
+
+				const FAdditionalWeaponInfo OldInfo = myInv->WeaponSlots[0].AdditionalInfo;
+				RunBench(FString::Printf(TEXT("Inventory.SwitchWeaponToIndex.%s.Slots%d.Ammo%d"), CaseNames[Case], NumSlots, NumAmmo), [myInv, OldInfo]()
+				{
+					myInv->SwitchWeaponToIndex(1, 0, OldInfo, true);
+				});
+			}
+		}
+	}
+
+	Owner->Destroy();
+}
+
+void UTPSMicroBenchCommandlet::BenchDataTableLookup(UTPSGameInstance* GameInstance)
+{
+	const FName FirstName(TEXT("Weapon_0"));
+	const FName LastName(*FString::Printf(TEXT("Weapon_%d"), NumRows - 1));
+	const FName MissingName(TEXT("Weapon_Missing"));
+
+	RunBench(FString::Printf(TEXT("DataTable.GetWeaponInfoByName.Rows%d.Last"), NumRows), [GameInstance, LastName]()
+	{
+		FWeaponInfo Info;
+		GameInstance->GetWeaponInfoByName(LastName, Info);
+	});
+	RunBench(FString::Printf(TEXT("DataTable.GetWeaponInfoByName.Rows%d.Missing"), NumRows), [GameInstance, MissingName]()
+	{
+		FWeaponInfo Info;
+		GameInstance->GetWeaponInfoByName(MissingName, Info);
+	});
+	RunBench(FString::Printf(TEXT("DataTable.GetDropItemInfoByWeaponName.Rows%d.First"), NumRows), [GameInstance, FirstName]()
+	{
+		FDropItem Info;
+		GameInstance->GetDropItemInfoByWeaponName(FirstName, Info);
+	});
+	RunBench(FString::Printf(TEXT("DataTable.GetDropItemInfoByWeaponName.Rows%d.Last"), NumRows), [GameInstance, LastName]()
+	{
+		FDropItem Info;
+		GameInstance->GetDropItemInfoByWeaponName(LastName, Info);
+	});
+}
+
+void UTPSMicroBenchCommandlet::BenchAddEffectBySurface(UWorld* World)
+{
+	ATPS_EnvironmentStructure* myActor = World->SpawnActor<ATPS_EnvironmentStructure>();
+
+	//ExecuteOnce effect destroys itself right after add, so list size stays stable
+	UTPS_StateEffect* EffectCDO = UTPS_StateEffect_ExecuteOnce::StaticClass()->GetDefaultObject<UTPS_StateEffect>();
+	const TArray<TEnumAsByte<EPhysicalSurface>> OldSurfaces = EffectCDO->PossibleInteractSurface;
+	const bool bOldStakable = EffectCDO->bIsStakable;
+	EffectCDO->PossibleInteractSurface = { EPhysicalSurface::SurfaceType1 };
+	EffectCDO->bIsStakable = false;
+
+	const int32 EffectCounts[] = { 16, 256, 4096 };
+	for (int32 NumEffects : EffectCounts)
+	{
+		//same class everywhere - worst case, whole list scanned and effect rejected
+		myActor->Effects.Empty();
+		for (int32 i = 0; i < NumEffects; i++)
+		{
+			myActor->Effects.Add(NewObject<UTPS_StateEffect>(myActor, UTPS_StateEffect_ExecuteOnce::StaticClass()));
+		}
+		RunBench(FString::Printf(TEXT("Effect.AddEffectBySurfaceType.SameClass.Effects%d"), NumEffects), [myActor]()
+		{
+			UTypes::AddEffectBySurfaceType(myActor, UTPS_StateEffect_ExecuteOnce::StaticClass(), EPhysicalSurface::SurfaceType1);
+		});
+
+		//other class in list - effect is created, executed and removed
+		myActor->Effects.Empty();
+		for (int32 i = 0; i < NumEffects; i++)
+		{
+			myActor->Effects.Add(NewObject<UTPS_StateEffect>(myActor, UTPS_StateEffect::StaticClass()));
+		}
+		RunBench(FString::Printf(TEXT("Effect.AddEffectBySurfaceType.OtherClass.Effects%d"), NumEffects), [myActor]()
+		{
+			UTypes::AddEffectBySurfaceType(myActor, UTPS_StateEffect_ExecuteOnce::StaticClass(), EPhysicalSurface::SurfaceType1);
+		});
+	}
+
+	EffectCDO->PossibleInteractSurface = OldSurfaces;
+	EffectCDO->bIsStakable = bOldStakable;
+	myActor->Effects.Empty();
+	myActor->Destroy();
+}
+
+//Batches, shots, rounds left and wrapping sum of batch seeds of a seeded run
+struct FTPSWeaponSimReplay
+{
+	int32 NumBatches = 0;
+	int32 NumShots = 0;
+	int32 Round = 0;
+	uint32 SeedSum = 0;
+
+	bool operator==(const FTPSWeaponSimReplay& Other) const
+	{
+		return NumBatches == Other.NumBatches && NumShots == Other.NumShots && Round == Other.Round && SeedSum == Other.SeedSum;
+	}
+};
+
+static FTPSWeaponSimReplay ReplayWeaponSim(const FWeaponInfo& Info, int32 Seed, int32 NumSteps, float DeltaTime)
+{
+	FTPSWeaponSim mySim;
+	mySim.Init(Info, Info.MaxRound, Seed);
+	mySim.SetMovementState(Info, EMovementState::Walk_State);
+	mySim.SetFiring(true);
+
+	TArray<FTPSWeaponShotEvent> Shots;
+	FTPSWeaponSimReplay Result;
+	for (int32 i = 0; i < NumSteps; i++)
+	{
+		Shots.Reset();
+		mySim.Step(Info, DeltaTime, Shots);
+		for (const FTPSWeaponShotEvent& Shot : Shots)
+		{
+			Result.NumBatches++;
+			Result.NumShots += Shot.ShotCount;
+			Result.SeedSum += (uint32)Shot.Seed;
+		}
+	}
+	Result.Round = mySim.Round;
+	return Result;
+}
+
+void UTPSMicroBenchCommandlet::BenchWeaponSim()
+{
+	FWeaponInfo Rifle;
+	Rifle.RateOfFire = 0.1f;
+	Rifle.ReloadTime = 2.0f;
+	Rifle.MaxRound = 30;
+	Rifle.NumberProjectileByShot = 1;
+
+	FWeaponInfo Shotgun = Rifle;
+	Shotgun.RateOfFire = 0.8f;
+	Shotgun.MaxRound = 8;
+	Shotgun.NumberProjectileByShot = 8;
+
+	//seed 1234, 6000 steps of 1/60 s, any change to fire rate, reload or batch seeds changes these
+	const float DeltaTime = 1.0f / 60.0f;
+	struct FGoldenReplay
+	{
+		const FWeaponInfo* Info;
+		FTPSWeaponSimReplay Expected;
+	};
+	const FGoldenReplay Golden[] =
+	{
+		{ &Rifle, { 546, 546, 24, 0xaeb50829 } },
+		{ &Shotgun, { 96, 96, 0, 0xff910610 } },
+	};
+	for (const FGoldenReplay& Entry : Golden)
+	{
+		const FTPSWeaponSimReplay Replay = ReplayWeaponSim(*Entry.Info, 1234, 6000, DeltaTime);
+		if (!(Replay == Entry.Expected))
+		{
+			UE_LOG(LogTemp, Error, TEXT("UTPSMicroBenchCommandlet::BenchWeaponSim - Replay differs, batches %d shots %d round %d seeds %08x, expected %d %d %d %08x"),
+				Replay.NumBatches, Replay.NumShots, Replay.Round, Replay.SeedSum,
+				Entry.Expected.NumBatches, Entry.Expected.NumShots, Entry.Expected.Round, Entry.Expected.SeedSum);
+			bFailed = true;
+		}
+	}
+
+	//rate far above frame rate, every step fires a full MaxShotCount batch
+	FWeaponInfo Minigun = Rifle;
+	Minigun.RateOfFire = 0.0001f;
+	Minigun.MaxRound = 1 << 30;
+	Minigun.ReloadTime = 0.0f;
+
+	FTPSWeaponSim mySim;
+	mySim.Init(Minigun, Minigun.MaxRound, 1234);
+	mySim.SetMovementState(Minigun, EMovementState::Walk_State);
+	mySim.SetFiring(true);
+	TArray<FTPSWeaponShotEvent> Shots;
+	Shots.Reserve(4);
+	int64 NumShots = 0;
+	const FTPSMicroBenchResult StepResult = RunBench(TEXT("WeaponSim.Step.MaxBatch"), [&mySim, &Minigun, &Shots, &NumShots, DeltaTime]()
+	{
+		Shots.Reset();
+		mySim.Step(Minigun, DeltaTime, Shots);
+		for (const FTPSWeaponShotEvent& Shot : Shots)
+		{
+			NumShots += Shot.ShotCount;
+		}
+		if (mySim.Round < FTPSWeaponSim::MaxShotCount)
+			mySim.Round = Minigun.MaxRound;
+	});
+
+	const FVector Direction = FVector::ForwardVector;
+	FRandomStream PelletStream(1234);
+	FVector Sum = FVector::ZeroVector;
+	RunBench(TEXT("WeaponSim.ApplyDispersion"), [&PelletStream, &Direction, &Sum]()
+	{
+		Sum += FTPSWeaponSim::ApplyDispersion(Direction, 5.0f, PelletStream);
+	});
+
+	//NumShots also counts the warm-up steps
+	const double ShotsPerStep = (double)NumShots / (StepResult.Iterations + NumWarmupIterations);
+	const double ShotsPerSecond = StepResult.NsPerOp > 0.0 ? ShotsPerStep * 1.0e9 / StepResult.NsPerOp : 0.0;
+	UE_LOG(LogTemp, Display, TEXT("WeaponSim - %.2f million shots/s (%.1f shots per step), pellet sum %s"),
+		ShotsPerSecond * 1.0e-6, ShotsPerStep, *Sum.ToString());
+	if (ShotsPerSecond < MinWeaponSimShotsPerSecond)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UTPSMicroBenchCommandlet::BenchWeaponSim - %.2f million shots/s is below the %.2f million target"),
+			ShotsPerSecond * 1.0e-6, MinWeaponSimShotsPerSecond * 1.0e-6);
+		bFailed = true;
+	}
+}
+
+void UTPSMicroBenchCommandlet::WriteOutput() const
+{
+	if (OutputFile.IsEmpty())
+		return;
+
+	FString Text = TEXT("Name,Iterations,NsPerOp,AllocsPerOp\n");
+	for (const FTPSMicroBenchResult& Result : Results)
+	{
+		Text += FString::Printf(TEXT("%s,%lld,%f,%f\n"), *Result.Name, Result.Iterations, Result.NsPerOp, Result.AllocsPerOp);
+	}
+	if (!FFileHelper::SaveStringToFile(Text, *OutputFile))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UTPSMicroBenchCommandlet::WriteOutput - Can't write %s"), *OutputFile);
+	}
+}
+
+bool UTPSMicroBenchCommandlet::CompareWithBaseline() const
+{
+	FString FilePath = BaselineFile;
+	if (FPaths::IsRelative(FilePath))
+	{
+		FilePath = FPaths::ProjectDir() / FilePath;
+	}
+
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UTPSMicroBenchCommandlet::CompareWithBaseline - Baseline not found - %s"), *FilePath);
+		return false;
+	}
+
+	//same layout as -Output, Name,Iterations,NsPerOp,AllocsPerOp, older files have no AllocsPerOp
+	TMap<FString, FTPSMicroBenchResult> Baseline;
+	for (const FString& Line : Lines)
+	{
+		TArray<FString> Columns;
+		Line.ParseIntoArray(Columns, TEXT(","));
+		if (Columns.Num() >= 3 && Columns[2].IsNumeric())
+		{
+			FTPSMicroBenchResult& BaseResult = Baseline.Add(Columns[0]);
+			BaseResult.NsPerOp = FCString::Atod(*Columns[2]);
+			BaseResult.AllocsPerOp = Columns.Num() >= 4 && Columns[3].IsNumeric() ? FCString::Atod(*Columns[3]) : -1.0;
+		}
+	}
+
+	bool bIsSuccess = true;
+	for (const FTPSMicroBenchResult& Result : Results)
+	{
+		const FTPSMicroBenchResult* BaseResult = Baseline.Find(Result.Name);
+		if (!BaseResult)
+			continue;
+
+		if (BaseResult->NsPerOp > 0.0)
+		{
+			const double ChangePercent = (Result.NsPerOp - BaseResult->NsPerOp) / BaseResult->NsPerOp * 100.0;
+			if (ChangePercent > RegressionThresholdPercent)
+			{
+				UE_LOG(LogTemp, Error, TEXT("UTPSMicroBenchCommandlet::CompareWithBaseline - %s regressed %.1f%% (%.1f -> %.1f ns/op)"), *Result.Name, ChangePercent, BaseResult->NsPerOp, Result.NsPerOp);
+				bIsSuccess = false;
+			}
+		}
+		//counts do not depend on the machine, half an allocation per op absorbs amortized array growth
+		if (BaseResult->AllocsPerOp >= 0.0 && Result.AllocsPerOp > BaseResult->AllocsPerOp + 0.5)
+		{
+			UE_LOG(LogTemp, Error, TEXT("UTPSMicroBenchCommandlet::CompareWithBaseline - %s allocates more (%.2f -> %.2f allocs/op)"), *Result.Name, BaseResult->AllocsPerOp, Result.AllocsPerOp);
+			bIsSuccess = false;
+		}
+	}
+	return bIsSuccess;
+}
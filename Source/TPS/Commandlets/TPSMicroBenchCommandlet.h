@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TPSMicroBenchCommandlet.generated.h"
+
+struct FTPSMicroBenchResult
+{
+	FString Name;
+	int64 Iterations = 0;
+	double NsPerOp = 0.0;
+	double AllocsPerOp = 0.0;
+};
+
+class FTPSCountingMalloc;
+
+/**
+ * Map-less micro benchmarks for linear scans in inventory, data table lookups, effects and FTPSWeaponSim.
+ * UE4Editor-Cmd TPS.uproject -run=TPSMicroBench [-Filter=Inventory] [-Rows=4000] [-MinTime=0.25] [-Output=<csv>]
+ *     [-Baseline=<csv>] [-Threshold=10] [-MinShotsPerSecond=1000000]
+ * Reports ns/op and allocations/op. Returns 1 when a seeded WeaponSim replay differs from the expected batches, shots and rounds,
+ * when WeaponSim.Step.MaxBatch fires fewer than -MinShotsPerSecond shots per second, or when a case is slower
+ * than the -Baseline csv (written earlier with -Output) by more than -Threshold percent or allocates more per op.
+ */
+UCLASS()
+class UTPSMicroBenchCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UTPSMicroBenchCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	void BenchInventorySwitch(class UWorld* World, class UTPSGameInstance* GameInstance);
+	void BenchDataTableLookup(class UTPSGameInstance* GameInstance);
+	void BenchAddEffectBySurface(class UWorld* World);
+	void BenchWeaponSim();
+
+	//adds the result to Results and returns it
+	template<typename FuncType>
+	FTPSMicroBenchResult RunBench(const FString& Name, FuncType&& Func);
+	//untimed calls before each bench
+	static constexpr int32 NumWarmupIterations = 16;
+
+	bool ShouldRun(const TCHAR* Group) const;
+	void WriteOutput() const;
+	bool CompareWithBaseline() const;
+
+	//GMalloc for the whole run, counts only allocations of the thread running the cases
+	FTPSCountingMalloc* CountingMalloc = nullptr;
+
+	TArray<FTPSMicroBenchResult> Results;
+	FString Filter;
+	FString OutputFile;
+	FString BaselineFile;
+	float RegressionThresholdPercent = 10.0f;
+	//WeaponSim.Step.MaxBatch throughput below this fails the run
+	float MinWeaponSimShotsPerSecond = 1.0e6f;
+	int32 NumRows = 4000;
+	float MinTime = 0.25f;
+	bool bFailed = false;
+};
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSTelemetryToCsvCommandlet.h"
+#include "../FuncLibrary/TPSTelemetry.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+UTPSTelemetryToCsvCommandlet::UTPSTelemetryToCsvCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+FString UTPSTelemetryToCsvCommandlet::FindNewestRecording() const
+{
+	const FString Dir = FTPSTelemetry::GetTelemetryDir();
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *(Dir / TEXT("*.tpstlm")), true, false);
+
+	FString Newest;
+	FDateTime NewestTime = FDateTime::MinValue();
+	for (const FString& File : Files)
+	{
+		const FString Path = Dir / File;
+		const FDateTime Time = IFileManager::Get().GetTimeStamp(*Path);
+		if (Time > NewestTime)
+		{
+			NewestTime = Time;
+			Newest = Path;
+		}
+	}
+	return Newest;
+}
+
+int32 UTPSTelemetryToCsvCommandlet::Main(const FString& Params)
+{
+	FString InputFile;
+	FString OutputFile;
+	FParse::Value(*Params, TEXT("Input="), InputFile);
+	FParse::Value(*Params, TEXT("Output="), OutputFile);
+
+	if (InputFile.IsEmpty())
+		InputFile = FindNewestRecording();
+	if (InputFile.IsEmpty())
+	{
+		UE_LOG(LogTemp, Error, TEXT("UTPSTelemetryToCsvCommandlet::Main - No recordings in %s"), *FTPSTelemetry::GetTelemetryDir());
+		return 1;
+	}
+	if (OutputFile.IsEmpty())
+		OutputFile = FPaths::ChangeExtension(InputFile, TEXT("csv"));
+
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *InputFile))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UTPSTelemetryToCsvCommandlet::Main - Can't read %s"), *InputFile);
+		return 1;
+	}
+
+	FTPSTelemetryFileHeader Header;
+	if (Data.Num() < (int32)sizeof(Header))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UTPSTelemetryToCsvCommandlet::Main - %s is too short"), *InputFile);
+		return 1;
+	}
+	FMemory::Memcpy(&Header, Data.GetData(), sizeof(Header));
+	if (Header.Magic != FTPSTelemetryFileHeader::FileMagic || Header.Version != FTPSTelemetryFileHeader::FileVersion
+		|| Header.RecordSize != sizeof(FTPSTelemetryRecord))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UTPSTelemetryToCsvCommandlet::Main - %s has unknown format (version %u, record size %u)"), *InputFile, Header.Version, Header.RecordSize);
+		return 1;
+	}
+
+	const TCHAR* TypeNames[] = { TEXT("Shot"), TEXT("ProjectileHit"), TEXT("Explosion"), TEXT("Damage") };
+	const UEnum* SurfaceEnum = StaticEnum<EPhysicalSurface>();
+
+	//a recording cut by a crash ends with a partial record, it is skipped
+	const int32 NumRecords = (Data.Num() - (int32)sizeof(Header)) / (int32)sizeof(FTPSTelemetryRecord);
+	FString Text = TEXT("Type,Frame,Time,Weapon,OriginX,OriginY,OriginZ,DirX,DirY,DirZ,HitActor,Surface,Damage,Effect\n");
+	Text.Reserve(Text.Len() + NumRecords * 160);
+	for (int32 i = 0; i < NumRecords; i++)
+	{
+		FTPSTelemetryRecord Record;
+		FMemory::Memcpy(&Record, Data.GetData() + sizeof(Header) + i * sizeof(FTPSTelemetryRecord), sizeof(Record));
+		//names are zero terminated by the writer, keep it safe for damaged files
+		Record.WeaponName[FTPSTelemetryRecord::NameSize - 1] = 0;
+		Record.HitActor[FTPSTelemetryRecord::NameSize - 1] = 0;
+		Record.Effect[FTPSTelemetryRecord::NameSize - 1] = 0;
+
+		Text += FString::Printf(TEXT("%s,%u,%f,%s,%f,%f,%f,%f,%f,%f,%s,%s,%f,%s\n"),
+			Record.Type < UE_ARRAY_COUNT(TypeNames) ? TypeNames[Record.Type] : TEXT("Unknown"),
+			Record.Frame, Record.Time, ANSI_TO_TCHAR(Record.WeaponName),
+			Record.Origin.X, Record.Origin.Y, Record.Origin.Z,
+			Record.Direction.X, Record.Direction.Y, Record.Direction.Z,
+			ANSI_TO_TCHAR(Record.HitActor),
+			SurfaceEnum ? *SurfaceEnum->GetNameStringByValue(Record.Surface) : *FString::FromInt(Record.Surface),
+			Record.Damage, ANSI_TO_TCHAR(Record.Effect));
+	}
+
+	if (!FFileHelper::SaveStringToFile(Text, *OutputFile))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UTPSTelemetryToCsvCommandlet::Main - Can't write %s"), *OutputFile);
+		return 1;
+	}
+	UE_LOG(LogTemp, Display, TEXT("UTPSTelemetryToCsvCommandlet::Main - %d records from %s written to %s"), NumRecords, *InputFile, *OutputFile);
+	return 0;
+}
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TPSTelemetryToCsvCommandlet.generated.h"
+
+/**
+ * Converts a TPS.Telemetry recording (Saved/Telemetry/*.tpstlm) to CSV.
+ * UE4Editor-Cmd TPS.uproject -run=TPSTelemetryToCsv [-Input=<tpstlm>] [-Output=<csv>]
+ * Without -Input the newest recording is used, without -Output the CSV is written next to it.
+ */
+UCLASS()
+class UTPSTelemetryToCsvCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UTPSTelemetryToCsvCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	FString FindNewestRecording() const;
+};
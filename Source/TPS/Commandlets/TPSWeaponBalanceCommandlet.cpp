@@ -0,0 +1,288 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSWeaponBalanceCommandlet.h"
+#include "../Weapon/TPSWeaponSim.h"
+#include "../Weapon/ProjectileDefault_Grenade.h"
+#include "Engine/DataTable.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+//AProjectileDefault_Grenade::Explose passes the same to ApplyRadialDamageWithFalloff
+static const float BalanceExplodeFalloff = 5.0f;
+static const float BalanceExplodeMinDamageScale = 0.2f;
+
+UTPSWeaponBalanceCommandlet::UTPSWeaponBalanceCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UTPSWeaponBalanceCommandlet::Main(const FString& Params)
+{
+	FString RowFilter;
+	FString OutputFile = FPaths::ProjectSavedDir() / ResultsFile;
+	FParse::Value(*Params, TEXT("Row="), RowFilter);
+	FParse::Value(*Params, TEXT("Output="), OutputFile);
+
+	UDataTable* myTable = Cast<UDataTable>(WeaponTable.TryLoad());
+	if (!myTable || myTable->GetRowStruct() != FWeaponInfo::StaticStruct())
+	{
+		UE_LOG(LogTemp, Error, TEXT("UTPSWeaponBalanceCommandlet::Main - Can't load weapon table %s"), *WeaponTable.ToString());
+		return 1;
+	}
+
+	TArray<FRowInfo> Rows;
+	for (const TPair<FName, uint8*>& Pair : myTable->GetRowMap())
+	{
+		if (!RowFilter.IsEmpty() && Pair.Key.ToString() != RowFilter)
+			continue;
+
+		FRowInfo& Row = Rows.AddDefaulted_GetRef();
+		Row.Name = Pair.Key;
+		Row.Info = *reinterpret_cast<const FWeaponInfo*>(Pair.Value);
+		const FProjectileInfo& myProjectile = Row.Info.ProjectileSetting;
+		Row.bProjectile = myProjectile.Projectile != nullptr;
+		if (Row.bProjectile)
+		{
+			Row.Range = myProjectile.ProjectileInitSpeed * myProjectile.ProjectileLifeTime;
+			const AProjectileDefault_Grenade* myGrenade = Cast<AProjectileDefault_Grenade>(myProjectile.Projectile->GetDefaultObject());
+			Row.bExplodes = myGrenade != nullptr;
+			Row.ExplodeDelay = myGrenade ? myGrenade->TimeToExplose : 0.0f;
+		}
+		else
+		{
+			Row.Range = Row.Info.DistacneTrace;
+		}
+	}
+	if (Rows.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UTPSWeaponBalanceCommandlet::Main - No rows to simulate"));
+		return 1;
+	}
+
+	if (Distances.Num() == 0)
+		Distances = { 500.0f, 1000.0f, 2000.0f };
+	if (MovementStates.Num() == 0)
+		MovementStates = { EMovementState::Aim_State, EMovementState::Walk_State, EMovementState::Run_State };
+
+	//row x movement state x distance, every case writes only its own slot
+	const int32 NumCases = Rows.Num() * MovementStates.Num() * Distances.Num();
+	TArray<FTPSWeaponBalanceResult> Results;
+	Results.SetNum(NumCases);
+	const double StartTime = FPlatformTime::Seconds();
+	ParallelFor(NumCases, [this, &Rows, &Results](int32 Index)
+	{
+		const int32 DistanceIndex = Index % Distances.Num();
+		const int32 StateIndex = (Index / Distances.Num()) % MovementStates.Num();
+		const int32 RowIndex = Index / (Distances.Num() * MovementStates.Num());
+		SimulateCase(Rows[RowIndex], MovementStates[StateIndex], Distances[DistanceIndex], Results[Index]);
+	});
+	UE_LOG(LogTemp, Display, TEXT("UTPSWeaponBalanceCommandlet::Main - %d cases x %d trials in %.2f s"), NumCases, NumTrials, FPlatformTime::Seconds() - StartTime);
+
+	int32 NumOutOfBand = 0;
+	for (FTPSWeaponBalanceResult& Result : Results)
+	{
+		if (!CheckBands(Result))
+			NumOutOfBand++;
+	}
+
+	WriteResults(Results, OutputFile);
+
+	if (NumOutOfBand > 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UTPSWeaponBalanceCommandlet::Main - %d of %d cases out of band, see %s"), NumOutOfBand, NumCases, *OutputFile);
+		return 1;
+	}
+	return 0;
+}
+
+float UTPSWeaponBalanceCommandlet::GetPelletDamage(const FRowInfo& Row, float OffsetFromTarget) const
+{
+	const FProjectileInfo& myProjectile = Row.Info.ProjectileSetting;
+	const bool bDirectHit = OffsetFromTarget <= TargetRadius;
+	float Damage = bDirectHit ? myProjectile.ProjectileDamage : 0.0f;
+
+	//missed grenades are assumed to land as far from the target as they passed it
+	if (Row.bExplodes)
+	{
+		const float Dist = FMath::Max(0.0f, OffsetFromTarget - TargetRadius);
+		const float Inner = FMath::Max(0.0f, myProjectile.ProjectileMinRadiusDamage);
+		const float Outer = FMath::Max(myProjectile.ProjectileMaxRadiusDamage, Inner);
+		if (Dist < Outer)
+		{
+			float Scale = 1.0f;
+			if (Dist > Inner)
+				Scale = FMath::Pow(1.0f - (Dist - Inner) / (Outer - Inner), BalanceExplodeFalloff);
+			Damage += FMath::Lerp(myProjectile.ExplodeMaxDamage * BalanceExplodeMinDamageScale, myProjectile.ExplodeMaxDamage, Scale);
+		}
+	}
+	return Damage;
+}
+
+void UTPSWeaponBalanceCommandlet::SimulateCase(const FRowInfo& Row, EMovementState MovementState, float Distance, FTPSWeaponBalanceResult& OutResult) const
+{
+	OutResult.Row = Row.Name;
+	OutResult.MovementState = MovementState;
+	OutResult.Distance = Distance;
+
+	const FWeaponInfo& Info = Row.Info;
+	const bool bInRange = Distance <= Row.Range;
+	const float TravelTime = Row.bProjectile ? Distance / FMath::Max(Info.ProjectileSetting.ProjectileInitSpeed, 1.0f) + Row.ExplodeDelay : 0.0f;
+	const int32 NumSteps = FMath::CeilToInt(SimulateTime / FMath::Max(StepTime, 0.001f));
+	const int32 Trials = FMath::Max(NumTrials, 1);
+
+	int64 NumPellets = 0;
+	int64 NumHits = 0;
+	double SumSustained = 0.0;
+	double SumBurst = 0.0;
+	double SumTimeToKill = 0.0;
+	double SumShotsToKill = 0.0;
+	int32 NumKills = 0;
+	float WorstTimeToKill = -1.0f;
+
+	TArray<FTPSWeaponShotEvent> Shots;
+	for (int32 Trial = 0; Trial < Trials; Trial++)
+	{
+		FTPSWeaponSim mySim;
+		mySim.Init(Info, Info.MaxRound, RandomSeed + Trial);
+		mySim.SetMovementState(Info, MovementState);
+		mySim.bReduceDispersion = MovementState == EMovementState::Aim_State || MovementState == EMovementState::AimWalk_State;
+		//target engaged with settled aim
+		mySim.Dispersion = mySim.DispersionMin;
+		mySim.SetFiring(true);
+
+		float Health = TargetHealth;
+		float Shield = TargetShield;
+		double TotalDamage = 0.0;
+		double MagazineDamage = 0.0;
+		float FirstShotTime = -1.0f;
+		float LastMagazineShotTime = 0.0f;
+		bool bMagazineDone = false;
+		bool bKilled = false;
+		int32 ShotsFired = 0;
+
+		for (int32 Step = 0; Step < NumSteps; Step++)
+		{
+			Shots.Reset();
+			mySim.Step(Info, StepTime, Shots);
+			for (const FTPSWeaponShotEvent& Shot : Shots)
+			{
+				if (FirstShotTime < 0.0f)
+					FirstShotTime = Shot.Time;
+				ShotsFired += Shot.ShotCount;
+
+				FRandomStream PelletStream(Shot.Seed);
+				float BatchDamage = 0.0f;
+				const int32 BatchPellets = Shot.ShotCount * Info.NumberProjectileByShot;
+				for (int32 Pellet = 0; Pellet < BatchPellets; Pellet++)
+				{
+					const FVector Dir = FTPSWeaponSim::ApplyDispersion(FVector::ForwardVector, Shot.Dispersion, PelletStream);
+					if (!bInRange || Dir.X <= KINDA_SMALL_NUMBER)
+						continue;
+
+					//lateral miss at target distance
+					const float Offset = Distance * FMath::Sqrt(FMath::Max(0.0f, 1.0f - Dir.X * Dir.X)) / Dir.X;
+					const float Damage = GetPelletDamage(Row, Offset);
+					if (Damage <= 0.0f)
+						continue;
+
+					NumHits++;
+					BatchDamage += Damage;
+					//same split as UTPSCharacterHealthComponent::ChangeHealthValue, shield takes the whole hit
+					if (Shield > 0.0f)
+						Shield = FMath::Max(0.0f, Shield - Damage);
+					else if (Health > 0.0f)
+						Health -= Damage * TargetCoefDamage;
+				}
+				NumPellets += BatchPellets;
+				TotalDamage += BatchDamage;
+				if (!bMagazineDone)
+				{
+					MagazineDamage += BatchDamage;
+					LastMagazineShotTime = Shot.Time;
+				}
+
+				if (Health <= 0.0f && !bKilled)
+				{
+					bKilled = true;
+					const float TimeToKill = Shot.Time - FirstShotTime + TravelTime;
+					SumTimeToKill += TimeToKill;
+					SumShotsToKill += ShotsFired;
+					WorstTimeToKill = FMath::Max(WorstTimeToKill, TimeToKill);
+					NumKills++;
+				}
+			}
+			if (mySim.bReloading)
+				bMagazineDone = true;
+		}
+
+		if (FirstShotTime >= 0.0f)
+		{
+			SumSustained += TotalDamage / FMath::Max(SimulateTime - FirstShotTime, StepTime);
+			SumBurst += MagazineDamage / FMath::Max(LastMagazineShotTime - FirstShotTime + Info.RateOfFire, StepTime);
+		}
+	}
+
+	OutResult.HitChance = NumPellets > 0 ? (float)NumHits / NumPellets : 0.0f;
+	OutResult.SustainedDps = SumSustained / Trials;
+	OutResult.BurstDps = SumBurst / Trials;
+	//one trial that never kills makes the case a fail for MaxTimeToKill bands
+	if (NumKills == Trials)
+	{
+		OutResult.TimeToKill = SumTimeToKill / NumKills;
+		OutResult.MaxTimeToKill = WorstTimeToKill;
+		OutResult.ShotsToKill = SumShotsToKill / NumKills;
+	}
+}
+
+bool UTPSWeaponBalanceCommandlet::CheckBands(FTPSWeaponBalanceResult& Result) const
+{
+	Result.bInBand = true;
+	for (const FTPSWeaponBalanceBand& Band : Bands)
+	{
+		if (!Band.Row.IsNone() && Band.Row != Result.Row)
+			continue;
+		if (Band.Distance > 0.0f && !FMath::IsNearlyEqual(Band.Distance, Result.Distance, 1.0f))
+			continue;
+
+		bool bFailed = false;
+		if (Band.MinSustainedDps > 0.0f && Result.SustainedDps < Band.MinSustainedDps)
+			bFailed = true;
+		if (Band.MaxSustainedDps > 0.0f && Result.SustainedDps > Band.MaxSustainedDps)
+			bFailed = true;
+		if (Band.MinTimeToKill > 0.0f && Result.TimeToKill >= 0.0f && Result.TimeToKill < Band.MinTimeToKill)
+			bFailed = true;
+		if (Band.MaxTimeToKill > 0.0f && (Result.MaxTimeToKill < 0.0f || Result.MaxTimeToKill > Band.MaxTimeToKill))
+			bFailed = true;
+
+		if (bFailed)
+		{
+			UE_LOG(LogTemp, Error, TEXT("UTPSWeaponBalanceCommandlet::CheckBands - %s %s at %.0f: DPS %.1f, TTK %.2f (max %.2f), band DPS %.1f..%.1f, TTK %.2f..%.2f"),
+				*Result.Row.ToString(), *UEnum::GetValueAsString(Result.MovementState), Result.Distance, Result.SustainedDps, Result.TimeToKill, Result.MaxTimeToKill,
+				Band.MinSustainedDps, Band.MaxSustainedDps, Band.MinTimeToKill, Band.MaxTimeToKill);
+			Result.bInBand = false;
+		}
+	}
+	return Result.bInBand;
+}
+
+void UTPSWeaponBalanceCommandlet::WriteResults(const TArray<FTPSWeaponBalanceResult>& Results, const FString& FileName) const
+{
+	FString Text = TEXT("Row,MovementState,Distance,HitChance,SustainedDps,BurstDps,TimeToKill,MaxTimeToKill,ShotsToKill,InBand\n");
+	for (const FTPSWeaponBalanceResult& Result : Results)
+	{
+		Text += FString::Printf(TEXT("%s,%s,%.0f,%.3f,%.2f,%.2f,%.3f,%.3f,%.1f,%d\n"),
+			*Result.Row.ToString(), *UEnum::GetDisplayValueAsText(Result.MovementState).ToString(), Result.Distance, Result.HitChance,
+			Result.SustainedDps, Result.BurstDps, Result.TimeToKill, Result.MaxTimeToKill, Result.ShotsToKill, Result.bInBand ? 1 : 0);
+	}
+	if (!FFileHelper::SaveStringToFile(Text, *FileName))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UTPSWeaponBalanceCommandlet::WriteResults - Can't write %s"), *FileName);
+		return;
+	}
+	UE_LOG(LogTemp, Display, TEXT("UTPSWeaponBalanceCommandlet::WriteResults - %d cases written to %s"), Results.Num(), *FileName);
+}
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "../FuncLibrary/Types.h"
+#include "TPSWeaponBalanceCommandlet.generated.h"
+
+//Allowed range for one row (None - every row), 0 - no limit
+USTRUCT()
+struct FTPSWeaponBalanceBand
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FName Row;
+	//<= 0 - every distance
+	UPROPERTY()
+	float Distance = 0.0f;
+	UPROPERTY()
+	float MinSustainedDps = 0.0f;
+	UPROPERTY()
+	float MaxSustainedDps = 0.0f;
+	UPROPERTY()
+	float MinTimeToKill = 0.0f;
+	UPROPERTY()
+	float MaxTimeToKill = 0.0f;
+};
+
+struct FTPSWeaponBalanceResult
+{
+	FName Row;
+	EMovementState MovementState = EMovementState::Run_State;
+	float Distance = 0.0f;
+	float HitChance = 0.0f;
+	float SustainedDps = 0.0f;
+	float BurstDps = 0.0f;
+	//mean and worst over trials, < 0 - target never killed in SimulateTime
+	float TimeToKill = -1.0f;
+	float MaxTimeToKill = -1.0f;
+	float ShotsToKill = 0.0f;
+	bool bInBand = true;
+};
+
+/**
+ * DPS and time to kill of every DT_WeaponInfo row, simulated with FTPSWeaponSim in parallel.
+ * UE4Editor-Cmd TPS.uproject -run=TPSWeaponBalance [-Row=<name>] [-Output=<csv>]
+ * Target, distances, movement states and bands are in DefaultGame.ini [/Script/TPS.TPSWeaponBalanceCommandlet].
+ * Returns 1 when a result is outside its band.
+ */
+UCLASS(config = Game)
+class UTPSWeaponBalanceCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UTPSWeaponBalanceCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+	UPROPERTY(Config)
+	FSoftObjectPath WeaponTable;
+	UPROPERTY(Config)
+	TArray<float> Distances;
+	UPROPERTY(Config)
+	TArray<EMovementState> MovementStates;
+	UPROPERTY(Config)
+	float TargetHealth = 100.0f;
+	UPROPERTY(Config)
+	float TargetShield = 100.0f;
+	//capsule radius, pellets inside the cone it covers hit
+	UPROPERTY(Config)
+	float TargetRadius = 42.0f;
+	UPROPERTY(Config)
+	float TargetCoefDamage = 1.0f;
+	UPROPERTY(Config)
+	float StepTime = 1.0f / 60.0f;
+	//sustained DPS window, reloads included
+	UPROPERTY(Config)
+	float SimulateTime = 60.0f;
+	UPROPERTY(Config)
+	int32 NumTrials = 16;
+	UPROPERTY(Config)
+	int32 RandomSeed = 1337;
+	UPROPERTY(Config)
+	TArray<FTPSWeaponBalanceBand> Bands;
+	UPROPERTY(Config)
+	FString ResultsFile = TEXT("Benchmark/WeaponBalance.csv");
+
+protected:
+	//row data read on the game thread, simulation only reads it
+	struct FRowInfo
+	{
+		FName Name;
+		FWeaponInfo Info;
+		bool bProjectile = false;
+		bool bExplodes = false;
+		float ExplodeDelay = 0.0f;
+		float Range = 0.0f;
+	};
+
+	void SimulateCase(const FRowInfo& Row, EMovementState MovementState, float Distance, FTPSWeaponBalanceResult& OutResult) const;
+	float GetPelletDamage(const FRowInfo& Row, float OffsetFromTarget) const;
+	bool CheckBands(FTPSWeaponBalanceResult& Result) const;
+	void WriteResults(const TArray<FTPSWeaponBalanceResult>& Results, const FString& FileName) const;
+};
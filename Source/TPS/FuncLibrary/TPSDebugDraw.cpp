@@ -0,0 +1,192 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSDebugDraw.h"
+
+#if TPS_DEBUG_DRAW
+
+#include "Components/LineBatchComponent.h"
+#include "Engine/World.h"
+
+int32 DebugWeaponTrace = 0;
+FAutoConsoleVariableRef CVARDebugWeaponTrace{
+	TEXT("TPS.Debug.WeaponTrace"),
+	DebugWeaponTrace,
+	TEXT("Draw hitscan traces and impacts"),
+	ECVF_Cheat
+};
+
+int32 DebugDispersion = 0;
+FAutoConsoleVariableRef CVARDebugDispersion{
+	TEXT("TPS.Debug.Dispersion"),
+	DebugDispersion,
+	TEXT("Draw dispersion cone of fire batches"),
+	ECVF_Cheat
+};
+
+int32 DebugExplosion = 0;
+FAutoConsoleVariableRef CVARDebugExplosion{
+	TEXT("TPS.Debug.Explosion"),
+	DebugExplosion,
+	TEXT("Draw explosion min and max damage radius"),
+	ECVF_Cheat
+};
+
+int32 DebugCursorTrace = 0;
+FAutoConsoleVariableRef CVARDebugCursorTrace{
+	TEXT("TPS.Debug.CursorTrace"),
+	DebugCursorTrace,
+	TEXT("Draw aim point under cursor"),
+	ECVF_Cheat
+};
+
+int32 DebugEffect = 0;
+FAutoConsoleVariableRef CVARDebugEffect{
+	TEXT("TPS.Debug.Effect"),
+	DebugEffect,
+	TEXT("Draw state effect application"),
+	ECVF_Cheat
+};
+
+struct FTPSDebugBatch
+{
+	TArray<FBatchedLine> Lines;
+	TArray<FBatchedLine> PersistentLines;
+};
+
+static TMap<const UWorld*, FTPSDebugBatch> DebugBatches;
+static bool bDebugDelegatesBound = false;
+
+static const int32 DebugCircleSegments = 16;
+
+bool FTPSDebugDraw::IsEnabled(ETPSDebugCategory Category)
+{
+	switch (Category)
+	{
+	case ETPSDebugCategory::WeaponTrace:
+		return DebugWeaponTrace != 0;
+	case ETPSDebugCategory::Dispersion:
+		return DebugDispersion != 0;
+	case ETPSDebugCategory::Explosion:
+		return DebugExplosion != 0;
+	case ETPSDebugCategory::CursorTrace:
+		return DebugCursorTrace != 0;
+	case ETPSDebugCategory::Effect:
+		return DebugEffect != 0;
+	default:
+		return false;
+	}
+}
+
+void FTPSDebugDraw::AddLine(const UWorld* World, const FVector& Start, const FVector& End, const FColor& Color, float Duration)
+{
+	if (!bDebugDelegatesBound)
+	{
+		bDebugDelegatesBound = true;
+		FWorldDelegates::OnWorldPostActorTick.AddStatic(&FTPSDebugDraw::Flush);
+		FWorldDelegates::OnWorldCleanup.AddStatic(&FTPSDebugDraw::WorldCleanup);
+	}
+
+	FTPSDebugBatch& Batch = DebugBatches.FindOrAdd(World);
+	if (Duration > 0.0f)
+	{
+		Batch.PersistentLines.Emplace(Start, End, FLinearColor(Color), Duration, 0.0f, SDPG_World);
+	}
+	else
+	{
+		Batch.Lines.Emplace(Start, End, FLinearColor(Color), 0.0f, 0.0f, SDPG_World);
+	}
+}
+
+void FTPSDebugDraw::Line(const UWorld* World, ETPSDebugCategory Category, const FVector& Start, const FVector& End, const FColor& Color, float Duration)
+{
+	if (!World || !IsEnabled(Category))
+		return;
+
+	AddLine(World, Start, End, Color, Duration);
+}
+
+void FTPSDebugDraw::Point(const UWorld* World, ETPSDebugCategory Category, const FVector& Location, float Size, const FColor& Color, float Duration)
+{
+	if (!World || !IsEnabled(Category))
+		return;
+
+	const float Half = Size * 0.5f;
+	AddLine(World, Location - FVector(Half, 0.0f, 0.0f), Location + FVector(Half, 0.0f, 0.0f), Color, Duration);
+	AddLine(World, Location - FVector(0.0f, Half, 0.0f), Location + FVector(0.0f, Half, 0.0f), Color, Duration);
+	AddLine(World, Location - FVector(0.0f, 0.0f, Half), Location + FVector(0.0f, 0.0f, Half), Color, Duration);
+}
+
+void FTPSDebugDraw::Sphere(const UWorld* World, ETPSDebugCategory Category, const FVector& Center, float Radius, const FColor& Color, float Duration)
+{
+	if (!World || !IsEnabled(Category))
+		return;
+
+	//three great circles
+	const FVector Axes[3][2] = {
+		{ FVector::ForwardVector, FVector::RightVector },
+		{ FVector::ForwardVector, FVector::UpVector },
+		{ FVector::RightVector, FVector::UpVector } };
+	for (const FVector* Axis : Axes)
+	{
+		FVector Prev = Center + Axis[0] * Radius;
+		for (int32 i = 1; i <= DebugCircleSegments; i++)
+		{
+			const float Angle = 2.0f * PI * i / DebugCircleSegments;
+			const FVector Next = Center + (Axis[0] * FMath::Cos(Angle) + Axis[1] * FMath::Sin(Angle)) * Radius;
+			AddLine(World, Prev, Next, Color, Duration);
+			Prev = Next;
+		}
+	}
+}
+
+void FTPSDebugDraw::Cone(const UWorld* World, ETPSDebugCategory Category, const FVector& Origin, const FVector& Direction, float Length, float AngleDegrees, const FColor& Color, float Duration)
+{
+	if (!World || !IsEnabled(Category))
+		return;
+
+	const FVector Dir = Direction.GetSafeNormal();
+	FVector Y, Z;
+	Dir.FindBestAxisVectors(Y, Z);
+	const FVector EndCenter = Origin + Dir * Length;
+	const float EndRadius = Length * FMath::Tan(FMath::DegreesToRadians(FMath::Clamp(AngleDegrees, 0.0f, 89.0f)));
+
+	AddLine(World, Origin, EndCenter, Color, Duration);
+	FVector Prev = EndCenter + Y * EndRadius;
+	for (int32 i = 1; i <= DebugCircleSegments; i++)
+	{
+		const float Angle = 2.0f * PI * i / DebugCircleSegments;
+		const FVector Next = EndCenter + (Y * FMath::Cos(Angle) + Z * FMath::Sin(Angle)) * EndRadius;
+		AddLine(World, Prev, Next, Color, Duration);
+		if (i % 4 == 0)
+		{
+			AddLine(World, Origin, Next, Color, Duration);
+		}
+		Prev = Next;
+	}
+}
+
+void FTPSDebugDraw::Flush(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	FTPSDebugBatch* Batch = DebugBatches.Find(World);
+	if (!Batch)
+		return;
+
+	if (Batch->Lines.Num() > 0 && World->LineBatcher)
+	{
+		World->LineBatcher->DrawLines(Batch->Lines);
+	}
+	if (Batch->PersistentLines.Num() > 0 && World->PersistentLineBatcher)
+	{
+		World->PersistentLineBatcher->DrawLines(Batch->PersistentLines);
+	}
+	Batch->Lines.Reset();
+	Batch->PersistentLines.Reset();
+}
+
+void FTPSDebugDraw::WorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	DebugBatches.Remove(World);
+}
+
+#endif
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//debug draw is compiled out of shipping, TPS_DEBUG_* macros do not evaluate their arguments there
+#define TPS_DEBUG_DRAW !UE_BUILD_SHIPPING
+
+enum class ETPSDebugCategory : uint8
+{
+	//TPS.Debug.WeaponTrace - hitscan traces and impacts
+	WeaponTrace,
+	//TPS.Debug.Dispersion - dispersion cone of every fire batch
+	Dispersion,
+	//TPS.Debug.Explosion - min and max damage radius
+	Explosion,
+	//TPS.Debug.CursorTrace - aim point under cursor
+	CursorTrace,
+	//TPS.Debug.Effect - state effect applied to an actor
+	Effect,
+
+	Num
+};
+
+#if TPS_DEBUG_DRAW
+
+/**
+ * Category gated debug shapes, turned into lines and sent to the world line batchers
+ * once per frame (FWorldDelegates::OnWorldPostActorTick). Game thread only.
+ * Duration <= 0 - one frame.
+ */
+class TPS_API FTPSDebugDraw
+{
+public:
+	static bool IsEnabled(ETPSDebugCategory Category);
+
+	static void Line(const UWorld* World, ETPSDebugCategory Category, const FVector& Start, const FVector& End, const FColor& Color, float Duration);
+	static void Point(const UWorld* World, ETPSDebugCategory Category, const FVector& Location, float Size, const FColor& Color, float Duration);
+	static void Sphere(const UWorld* World, ETPSDebugCategory Category, const FVector& Center, float Radius, const FColor& Color, float Duration);
+	static void Cone(const UWorld* World, ETPSDebugCategory Category, const FVector& Origin, const FVector& Direction, float Length, float AngleDegrees, const FColor& Color, float Duration);
+
+protected:
+	static void AddLine(const UWorld* World, const FVector& Start, const FVector& End, const FColor& Color, float Duration);
+	static void Flush(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+	static void WorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+};
+
+#define TPS_DEBUG_LINE(World, Category, Start, End, Color, Duration) FTPSDebugDraw::Line(World, ETPSDebugCategory::Category, Start, End, Color, Duration)
+#define TPS_DEBUG_POINT(World, Category, Location, Size, Color, Duration) FTPSDebugDraw::Point(World, ETPSDebugCategory::Category, Location, Size, Color, Duration)
+#define TPS_DEBUG_SPHERE(World, Category, Center, Radius, Color, Duration) FTPSDebugDraw::Sphere(World, ETPSDebugCategory::Category, Center, Radius, Color, Duration)
+#define TPS_DEBUG_CONE(World, Category, Origin, Direction, Length, AngleDegrees, Color, Duration) FTPSDebugDraw::Cone(World, ETPSDebugCategory::Category, Origin, Direction, Length, AngleDegrees, Color, Duration)
+
+#else
+
+#define TPS_DEBUG_LINE(World, Category, Start, End, Color, Duration)
+#define TPS_DEBUG_POINT(World, Category, Location, Size, Color, Duration)
+#define TPS_DEBUG_SPHERE(World, Category, Center, Radius, Color, Duration)
+#define TPS_DEBUG_CONE(World, Category, Origin, Direction, Length, AngleDegrees, Color, Duration)
+
+#endif
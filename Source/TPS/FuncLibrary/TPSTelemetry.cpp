@@ -0,0 +1,336 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSTelemetry.h"
+#include "Containers/Queue.h"
+#include "Containers/LockFreeList.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/PlatformAtomics.h"
+#include "Misc/Paths.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+int32 TelemetryEnable = 0;
+FAutoConsoleVariableRef CVARTelemetryEnable{
+	TEXT("TPS.Telemetry.Enable"),
+	TelemetryEnable,
+	TEXT("Record shots, hits, explosions and damage to Saved/Telemetry, 0 - off (closes the file)"),
+	ECVF_Default
+};
+
+float TelemetryFlushInterval = 1.0f;
+FAutoConsoleVariableRef CVARTelemetryFlushInterval{
+	TEXT("TPS.Telemetry.FlushInterval"),
+	TelemetryFlushInterval,
+	TEXT("Seconds between hand overs of a partly filled game thread chunk to the writer"),
+	ECVF_Default
+};
+
+static_assert(sizeof(FTPSTelemetryRecord) == 136, "FTPSTelemetryRecord is written as is, change FileVersion with layout");
+
+struct FTPSTelemetryChunk
+{
+	static constexpr int32 ChunkSize = 256;
+
+	int32 Num = 0;
+	//marker, writer closes the file and opens a new one on next records
+	bool bCloseFile = false;
+	FTPSTelemetryRecord Records[ChunkSize];
+};
+
+static TQueue<FTPSTelemetryChunk*, EQueueMode::Mpsc> PendingChunks;
+static TLockFreePointerListUnordered<FTPSTelemetryChunk, PLATFORM_CACHE_LINE_SIZE> FreeChunks;
+//chunk being filled by one thread, the owner takes it out with an exchange for every record,
+//close and exit take it the same way, whatever the owner is in the middle of stays with it
+struct FTPSTelemetryThreadSlot
+{
+	FTPSTelemetryChunk* Chunk = nullptr;
+	//owner only, last TelemetryFlushGeneration handled
+	int32 FlushGeneration = 0;
+};
+
+//every thread that recorded, slots live until exit, lock only for adding and walking the list
+static FCriticalSection TelemetrySlotsLock;
+static TArray<FTPSTelemetryThreadSlot*> TelemetrySlots;
+static thread_local FTPSTelemetryThreadSlot* ThreadSlot = nullptr;
+//bumped every TPS.Telemetry.FlushInterval, a thread that sees it moved hands over its partly filled chunk
+static volatile int32 TelemetryFlushGeneration = 0;
+
+class FTPSTelemetryWriter : public FRunnable
+{
+public:
+	FTPSTelemetryWriter()
+	{
+		WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	}
+	virtual ~FTPSTelemetryWriter()
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	}
+
+	virtual uint32 Run() override
+	{
+		while (!bStopRequested)
+		{
+			WakeEvent->Wait(100);
+			Drain();
+		}
+		Drain();
+		CloseFile();
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		bStopRequested = true;
+		WakeEvent->Trigger();
+	}
+
+	void Drain()
+	{
+		FTPSTelemetryChunk* Chunk = nullptr;
+		bool bWritten = false;
+		while (PendingChunks.Dequeue(Chunk))
+		{
+			if (Chunk->bCloseFile)
+			{
+				CloseFile();
+			}
+			else if (Chunk->Num > 0)
+			{
+				if (!File)
+					OpenFile();
+				if (File)
+				{
+					File->Write((const uint8*)Chunk->Records, Chunk->Num * sizeof(FTPSTelemetryRecord));
+					bWritten = true;
+				}
+			}
+			Chunk->Num = 0;
+			Chunk->bCloseFile = false;
+			FreeChunks.Push(Chunk);
+		}
+		if (bWritten)
+			File->Flush();
+	}
+
+	FEvent* WakeEvent = nullptr;
+	FThreadSafeBool bStopRequested = false;
+
+protected:
+	void OpenFile()
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		const FString Dir = FTPSTelemetry::GetTelemetryDir();
+		PlatformFile.CreateDirectoryTree(*Dir);
+		const FString FileName = Dir / FString::Printf(TEXT("TPS_%s.tpstlm"), *FDateTime::Now().ToString());
+		File.Reset(PlatformFile.OpenWrite(*FileName));
+		if (!File)
+		{
+			UE_LOG(LogTemp, Error, TEXT("FTPSTelemetryWriter::OpenFile - Can't open %s"), *FileName);
+			return;
+		}
+		const FTPSTelemetryFileHeader Header;
+		File->Write((const uint8*)&Header, sizeof(Header));
+		UE_LOG(LogTemp, Display, TEXT("FTPSTelemetryWriter::OpenFile - Recording to %s"), *FileName);
+	}
+
+	void CloseFile()
+	{
+		File.Reset();
+	}
+
+	TUniquePtr<IFileHandle> File;
+};
+
+static FCriticalSection TelemetryStartLock;
+static FTPSTelemetryWriter* TelemetryWriter = nullptr;
+static FRunnableThread* TelemetryThread = nullptr;
+//game thread only
+static bool bTelemetryFileOpen = false;
+static double TelemetryLastHandOver = 0.0;
+static FDelegateHandle TelemetryEndFrameHandle;
+static FDelegateHandle TelemetryPreExitHandle;
+
+static FTPSTelemetryChunk* AllocTelemetryChunk()
+{
+	FTPSTelemetryChunk* Chunk = FreeChunks.Pop();
+	return Chunk ? Chunk : new FTPSTelemetryChunk();
+}
+
+static void HandOverTelemetryChunk(FTPSTelemetryChunk* Chunk)
+{
+	PendingChunks.Enqueue(Chunk);
+	if (TelemetryWriter)
+		TelemetryWriter->WakeEvent->Trigger();
+}
+
+static FTPSTelemetryThreadSlot& GetTelemetryThreadSlot()
+{
+	if (!ThreadSlot)
+	{
+		ThreadSlot = new FTPSTelemetryThreadSlot();
+		ThreadSlot->FlushGeneration = FPlatformAtomics::AtomicRead(&TelemetryFlushGeneration);
+		FScopeLock Lock(&TelemetrySlotsLock);
+		TelemetrySlots.Add(ThreadSlot);
+	}
+	return *ThreadSlot;
+}
+
+static void HandOverTelemetrySlot(FTPSTelemetryThreadSlot& Slot)
+{
+	FTPSTelemetryChunk* Chunk = FPlatformAtomics::InterlockedExchangePtr(&Slot.Chunk, (FTPSTelemetryChunk*)nullptr);
+	if (!Chunk)
+		return;
+
+	if (Chunk->Num > 0)
+	{
+		HandOverTelemetryChunk(Chunk);
+	}
+	else
+	{
+		FreeChunks.Push(Chunk);
+	}
+}
+
+//partly filled chunks of worker threads too, before a file is closed
+static void HandOverAllTelemetrySlots()
+{
+	FScopeLock Lock(&TelemetrySlotsLock);
+	for (FTPSTelemetryThreadSlot* Slot : TelemetrySlots)
+	{
+		HandOverTelemetrySlot(*Slot);
+	}
+}
+
+static void CopyTelemetryName(ANSICHAR(&Out)[FTPSTelemetryRecord::NameSize], FName Name)
+{
+	if (Name.IsNone())
+		return;
+
+	FNameBuilder Builder;
+	Name.AppendString(Builder);
+	const TCHAR* Src = Builder.ToString();
+	int32 i = 0;
+	for (; i < FTPSTelemetryRecord::NameSize - 1 && Src[i]; i++)
+	{
+		Out[i] = Src[i] < 128 ? (ANSICHAR)Src[i] : '?';
+	}
+	Out[i] = 0;
+}
+
+bool FTPSTelemetry::IsEnabled()
+{
+	return TelemetryEnable != 0;
+}
+
+FString FTPSTelemetry::GetTelemetryDir()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Telemetry");
+}
+
+void FTPSTelemetry::Start()
+{
+	FScopeLock Lock(&TelemetryStartLock);
+	if (TelemetryWriter)
+		return;
+
+	TelemetryWriter = new FTPSTelemetryWriter();
+	TelemetryThread = FRunnableThread::Create(TelemetryWriter, TEXT("TPSTelemetryWriter"), 0, TPri_BelowNormal);
+	TelemetryEndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&FTPSTelemetry::EndFrame);
+	TelemetryPreExitHandle = FCoreDelegates::OnPreExit.AddStatic(&FTPSTelemetry::Shutdown);
+}
+
+void FTPSTelemetry::Record(const UWorld* World, ETPSTelemetryType Type, FName WeaponName, const FVector& Origin, const FVector& Direction,
+	const AActor* HitActor, EPhysicalSurface Surface, float Damage, const UClass* Effect)
+{
+	if (!IsEnabled())
+		return;
+
+	if (!TelemetryWriter)
+		Start();
+	if (IsInGameThread())
+		bTelemetryFileOpen = true;
+
+	FTPSTelemetryThreadSlot& mySlot = GetTelemetryThreadSlot();
+	FTPSTelemetryChunk* myChunk = FPlatformAtomics::InterlockedExchangePtr(&mySlot.Chunk, (FTPSTelemetryChunk*)nullptr);
+	if (!myChunk)
+		myChunk = AllocTelemetryChunk();
+
+	FTPSTelemetryRecord& myRecord = myChunk->Records[myChunk->Num++];
+	myRecord = FTPSTelemetryRecord();
+	myRecord.Type = (uint8)Type;
+	myRecord.Surface = (uint8)Surface;
+	myRecord.Frame = (uint32)GFrameCounter;
+	myRecord.Time = World ? World->GetTimeSeconds() : 0.0f;
+	myRecord.Damage = Damage;
+	myRecord.Origin = Origin;
+	myRecord.Direction = Direction;
+	CopyTelemetryName(myRecord.WeaponName, WeaponName);
+	if (HitActor)
+		CopyTelemetryName(myRecord.HitActor, HitActor->GetFName());
+	if (Effect)
+		CopyTelemetryName(myRecord.Effect, Effect->GetFName());
+
+	const int32 Generation = FPlatformAtomics::AtomicRead(&TelemetryFlushGeneration);
+	if (myChunk->Num == FTPSTelemetryChunk::ChunkSize || Generation != mySlot.FlushGeneration)
+	{
+		mySlot.FlushGeneration = Generation;
+		HandOverTelemetryChunk(myChunk);
+		myChunk = nullptr;
+	}
+	FPlatformAtomics::InterlockedExchangePtr(&mySlot.Chunk, myChunk);
+}
+
+void FTPSTelemetry::EndFrame()
+{
+	const double Now = FPlatformTime::Seconds();
+	const bool bClose = !IsEnabled() && bTelemetryFileOpen;
+	if (bClose)
+	{
+		HandOverAllTelemetrySlots();
+		FTPSTelemetryChunk* Marker = AllocTelemetryChunk();
+		Marker->bCloseFile = true;
+		HandOverTelemetryChunk(Marker);
+		bTelemetryFileOpen = false;
+	}
+	else if (Now - TelemetryLastHandOver >= TelemetryFlushInterval)
+	{
+		//other threads on their next record
+		FPlatformAtomics::InterlockedIncrement(&TelemetryFlushGeneration);
+		if (ThreadSlot)
+		{
+			HandOverTelemetrySlot(*ThreadSlot);
+			ThreadSlot->FlushGeneration = FPlatformAtomics::AtomicRead(&TelemetryFlushGeneration);
+		}
+		TelemetryLastHandOver = Now;
+	}
+}
+
+void FTPSTelemetry::Shutdown()
+{
+	FScopeLock Lock(&TelemetryStartLock);
+	if (!TelemetryWriter)
+		return;
+
+	FCoreDelegates::OnEndFrame.Remove(TelemetryEndFrameHandle);
+	FCoreDelegates::OnPreExit.Remove(TelemetryPreExitHandle);
+	HandOverAllTelemetrySlots();
+
+	//writer drains the queue before it returns
+	TelemetryThread->Kill(true);
+	delete TelemetryThread;
+	TelemetryThread = nullptr;
+	delete TelemetryWriter;
+	TelemetryWriter = nullptr;
+	bTelemetryFileOpen = false;
+
+	while (FTPSTelemetryChunk* Chunk = FreeChunks.Pop())
+	{
+		delete Chunk;
+	}
+}
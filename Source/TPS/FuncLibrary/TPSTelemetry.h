@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+
+enum class ETPSTelemetryType : uint8
+{
+	//hitscan trace or projectile spawn, one per pellet
+	Shot,
+	ProjectileHit,
+	Explosion,
+	Damage,
+};
+
+//Fixed size record, written to disk as is (native endianness), names are cut to NameSize - 1 chars
+struct FTPSTelemetryRecord
+{
+	static constexpr int32 NameSize = 32;
+
+	uint8 Type = 0;
+	uint8 Surface = 0;
+	uint16 Reserved = 0;
+	uint32 Frame = 0;
+	//world time seconds
+	float Time = 0.0f;
+	float Damage = 0.0f;
+	FVector Origin = FVector::ZeroVector;
+	FVector Direction = FVector::ZeroVector;
+	ANSICHAR WeaponName[NameSize] = {};
+	ANSICHAR HitActor[NameSize] = {};
+	ANSICHAR Effect[NameSize] = {};
+};
+
+struct FTPSTelemetryFileHeader
+{
+	//'TPST'
+	static constexpr uint32 FileMagic = 0x54535054;
+	static constexpr uint32 FileVersion = 1;
+
+	uint32 Magic = FileMagic;
+	uint32 Version = FileVersion;
+	uint32 RecordSize = sizeof(FTPSTelemetryRecord);
+	uint32 Reserved = 0;
+};
+
+/**
+ * Shot and damage recorder (TPS.Telemetry.Enable).
+ * Every thread fills its own chunk of records without locks, full chunks go to a queue
+ * drained by a writer thread into Saved/Telemetry/TPS_<date>.tpstlm.
+ * Every TPS.Telemetry.FlushInterval seconds the game thread hands over its chunk and other threads theirs on their
+ * next record, partly filled chunks of all threads are taken when recording stops and on exit.
+ * UE4Editor-Cmd TPS.uproject -run=TPSTelemetryToCsv converts recordings to CSV.
+ */
+class TPS_API FTPSTelemetry
+{
+public:
+	static bool IsEnabled();
+
+	static void Record(const UWorld* World, ETPSTelemetryType Type, FName WeaponName, const FVector& Origin, const FVector& Direction,
+		const AActor* HitActor, EPhysicalSurface Surface, float Damage, const UClass* Effect);
+
+	//hands over the chunks of all threads and stops the writer, called on exit
+	static void Shutdown();
+
+	static FString GetTelemetryDir();
+
+protected:
+	static void Start();
+	static void EndFrame();
+};
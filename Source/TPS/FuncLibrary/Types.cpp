@@ -4,6 +4,7 @@
 #include "Types.h"
 #include "../TPS.h"
 #include "../Interface/TPS_IGameActor.h"
+#include "TPSDebugDraw.h"
 
 
 void UTypes::AddEffectBySurfaceType(AActor* TakeEffectActor, TSubclassOf<UTPS_StateEffect> AddEffectClass, EPhysicalSurface SurfaceType)
@@ -14,7 +15,7 @@ void UTypes::AddEffectBySurfaceType(AActor* TakeEffectActor, TSubclassOf<UTPS_St
 		if (myEffect)
 		{
 			bool bIsHavePossibleSurface = false;
-			int8 i = 0;
+			int32 i = 0;
 			while (i < myEffect->PossibleInteractSurface.Num() && !bIsHavePossibleSurface)
 			{
 				if (myEffect->PossibleInteractSurface[i] == SurfaceType)
@@ -23,7 +24,7 @@ void UTypes::AddEffectBySurfaceType(AActor* TakeEffectActor, TSubclassOf<UTPS_St
 					bool bIsCanAddEffect = false;
 					if (!myEffect->bIsStakable)
 					{
-						int8 j = 0;
+						int32 j = 0;
 						TArray<UTPS_StateEffect*> CurrentEffects;
 						ITPS_IGameActor* myInterface = Cast<ITPS_IGameActor>(TakeEffectActor);
 						if (myInterface)
@@ -60,6 +61,7 @@ void UTypes::AddEffectBySurfaceType(AActor* TakeEffectActor, TSubclassOf<UTPS_St
 						if (NewEffect)
 						{
 							NewEffect->InitObject(TakeEffectActor);
+							TPS_DEBUG_SPHERE(TakeEffectActor->GetWorld(), Effect, TakeEffectActor->GetActorLocation(), 60.0f, FColor::Purple, 2.0f);
 						}
 					}
 
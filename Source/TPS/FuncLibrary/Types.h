@@ -188,6 +188,31 @@ struct FDropMeshInfo
 	float CustomMass = 0.0f;
 };
 
+USTRUCT(BlueprintType)
+struct FWeaponAudioInfo
+{
+	GENERATED_BODY()
+
+	//automatic weapons: one looping voice while firing instead of SoundFireWeapon per round
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sound")
+	USoundBase* FireLoop = nullptr;
+	//played once when the loop stops
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sound")
+	USoundBase* FireTail = nullptr;
+	//loop stops after RateOfFire + LoopStopDelay without a shot, covers net update gaps on proxies
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sound")
+	float LoopStopDelay = 0.2f;
+	//engine concurrency group for this weapon class
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sound")
+	class USoundConcurrency* Concurrency = nullptr;
+	//voices of this weapon row playing at once, 0 - no limit
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sound")
+	int32 MaxVoices = 4;
+	//no voice farther from the listener, 0 - no culling
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sound")
+	float CullDistance = 5000.0f;
+};
+
 USTRUCT(BlueprintType)
 struct FWeaponInfo : public FTableRowBase
 {
@@ -212,6 +237,8 @@ struct FWeaponInfo : public FTableRowBase
 	USoundBase* SoundFireWeapon = nullptr;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sound ")
 	USoundBase* SoundReloadWeapon = nullptr;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sound ")
+	FWeaponAudioInfo FireAudio;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "FX ")
 	UParticleSystem* EffectFireWeapon = nullptr;
 	//if null use trace logic (TSubclassOf<class AProjectileDefault> Projectile = nullptr), use projectile setting damage, FX and other for trace logic
@@ -292,6 +319,22 @@ struct FDropItem : public FTableRowBase
 	FWeaponSlot WeaponInfo;
 };
 
+//Active state effect as seen by clients: id from UTPSGameInstance::EffectClasses and server expiry time
+USTRUCT(BlueprintType)
+struct FTPSActiveEffectRep
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Effect")
+	uint8 EffectId = 0;
+	//unique per character, stackable effects share EffectId
+	UPROPERTY(BlueprintReadOnly, Category = "Effect")
+	int32 InstanceId = 0;
+	//server world time, < 0 - until removed
+	UPROPERTY(BlueprintReadOnly, Category = "Effect")
+	float ExpireTime = -1.0f;
+};
+
 UCLASS()
 class TPS_API UTypes : public UBlueprintFunctionLibrary
 {
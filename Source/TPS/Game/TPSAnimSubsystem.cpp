@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSAnimSubsystem.h"
+#include "../TPS.h"
+#include "Animation/AnimInstance.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+
+int32 AnimUpdateRateOptimizations = 1;
+FAutoConsoleVariableRef CVARAnimUpdateRateOptimizations{
+	TEXT("TPS.Anim.URO"),
+	AnimUpdateRateOptimizations,
+	TEXT("Frame skip for distant and off screen characters and weapons, applied on next mesh register"),
+	ECVF_Default
+};
+
+FString AnimRateTable = TEXT("0.4,0.2,0.1,0.05");
+FAutoConsoleVariableRef CVARAnimRateTable{
+	TEXT("TPS.Anim.RateTable"),
+	AnimRateTable,
+	TEXT("Screen sizes, bigger than 1st - every frame, than 2nd - every 2nd frame ... smaller than last - 1 in N+1 frames. Applied on next mesh register"),
+	ECVF_Default
+};
+
+int32 AnimNonRenderedRate = 4;
+FAutoConsoleVariableRef CVARAnimNonRenderedRate{
+	TEXT("TPS.Anim.NonRenderedRate"),
+	AnimNonRenderedRate,
+	TEXT("Off screen meshes are evaluated 1 in N frames, applied on next mesh register"),
+	ECVF_Default
+};
+
+int32 AnimInterpolate = 1;
+FAutoConsoleVariableRef CVARAnimInterpolate{
+	TEXT("TPS.Anim.Interpolate"),
+	AnimInterpolate,
+	TEXT("Interpolate bones on skipped frames, applied on next mesh register"),
+	ECVF_Default
+};
+
+int32 AnimMaxInterpolatedRate = 4;
+FAutoConsoleVariableRef CVARAnimMaxInterpolatedRate{
+	TEXT("TPS.Anim.MaxInterpolatedRate"),
+	AnimMaxInterpolatedRate,
+	TEXT("Slower rates than 1 in N frames snap instead of interpolating, applied on next mesh register"),
+	ECVF_Default
+};
+
+int32 AnimVisibilityTick = 1;
+FAutoConsoleVariableRef CVARAnimVisibilityTick{
+	TEXT("TPS.Anim.VisibilityTick"),
+	AnimVisibilityTick,
+	TEXT("No pose tick for off screen meshes (characters keep montages), applied on next mesh register"),
+	ECVF_Default
+};
+
+void UTPSAnimSubsystem::Deinitialize()
+{
+	Meshes.Empty();
+	Super::Deinitialize();
+}
+
+TStatId UTPSAnimSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTPSAnimSubsystem, STATGROUP_Tickables);
+}
+
+void UTPSAnimSubsystem::SetupMesh(USkeletalMeshComponent* Mesh)
+{
+	if (!Mesh)
+		return;
+
+	Mesh->bEnableUpdateRateOptimizations = true;
+	Mesh->OnAnimUpdateRateParamsCreated.BindStatic(&UTPSAnimSubsystem::OnUpdateRateParamsCreated);
+}
+
+void UTPSAnimSubsystem::OnUpdateRateParamsCreated(FAnimUpdateRateParameters* Params)
+{
+	TArray<FString> myEntries;
+	AnimRateTable.ParseIntoArray(myEntries, TEXT(","));
+
+	TArray<float> myThresholds;
+	for (const FString& Entry : myEntries)
+	{
+		const float Threshold = FCString::Atof(*Entry);
+		//descending screen sizes only, the engine walks them in order
+		if (Threshold > 0.0f && (myThresholds.Num() == 0 || Threshold < myThresholds.Last()))
+		{
+			myThresholds.Add(Threshold);
+		}
+	}
+	if (myThresholds.Num() > 0)
+	{
+		Params->BaseVisibleDistanceFactorThesholds = MoveTemp(myThresholds);
+	}
+
+	Params->BaseNonRenderedUpdateRate = FMath::Max(AnimNonRenderedRate, 1);
+	Params->bInterpolateSkippedFrames = AnimInterpolate != 0;
+	Params->MaxEvalRateForInterpolation = FMath::Max(AnimMaxInterpolatedRate, 1);
+}
+
+void UTPSAnimSubsystem::StopAnimation(USkeletalMeshComponent* Mesh)
+{
+	if (!IsValid(Mesh))
+		return;
+
+	if (UAnimInstance* myAnim = Mesh->GetAnimInstance())
+	{
+		myAnim->StopAllMontages(0.0f);
+	}
+	//no anim graph left to evaluate, physics writes the bones of a ragdoll
+	Mesh->SetAnimInstanceClass(nullptr);
+	Mesh->bPauseAnims = true;
+	if (!Mesh->IsSimulatingPhysics())
+	{
+		Mesh->SetComponentTickEnabled(false);
+	}
+}
+
+void UTPSAnimSubsystem::Register(USkeletalMeshComponent* Mesh, bool bFullRate, bool bKeepMontages)
+{
+	if (!IsValid(Mesh))
+		return;
+
+	if (bFullRate || AnimUpdateRateOptimizations == 0)
+	{
+		Mesh->bEnableUpdateRateOptimizations = false;
+	}
+
+	if (bFullRate)
+	{
+		Mesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+	}
+	else if (AnimVisibilityTick != 0)
+	{
+		Mesh->VisibilityBasedAnimTickOption = bKeepMontages
+			? EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered
+			: EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+	}
+
+	Meshes.AddUnique(Mesh);
+}
+
+void UTPSAnimSubsystem::Unregister(USkeletalMeshComponent* Mesh)
+{
+	Meshes.RemoveSingleSwap(Mesh);
+}
+
+void UTPSAnimSubsystem::Tick(float DeltaTime)
+{
+	//after all tick groups, parallel evaluation of this frame is done
+	int32 NumBones = 0;
+	int32 NumEvaluated = 0;
+	int32 NumInterpolated = 0;
+	for (int32 i = Meshes.Num() - 1; i >= 0; i--)
+	{
+		USkeletalMeshComponent* myMesh = Meshes[i].Get();
+		if (!myMesh || myMesh->IsPendingKill())
+		{
+			Meshes.RemoveAtSwap(i);
+			continue;
+		}
+
+		if (!myMesh->GetAnimInstance() || myMesh->bNoSkeletonUpdate || !myMesh->PoseTickedThisFrame())
+			continue;
+
+		if (myMesh->ShouldUseUpdateRateOptimizations() && myMesh->AnimUpdateRateParams->ShouldSkipEvaluation())
+		{
+			NumInterpolated++;
+			continue;
+		}
+
+		NumEvaluated++;
+		NumBones += myMesh->GetNumComponentSpaceTransforms();
+	}
+
+	CSV_CUSTOM_STAT(TPS, AnimBonesEvaluated, NumBones, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(TPS, AnimMeshesEvaluated, NumEvaluated, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(TPS, AnimMeshesInterpolated, NumInterpolated, ECsvCustomStatOp::Set);
+}
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "TPSAnimSubsystem.generated.h"
+
+class USkeletalMeshComponent;
+struct FAnimUpdateRateParameters;
+
+/**
+ * Animation cost of characters and weapons.
+ * Meshes set up with SetupMesh use update rate optimizations: frame skip by screen size (TPS.Anim.RateTable),
+ * skipped frames interpolated, TPS.Anim.NonRenderedRate when off screen.
+ * Registered meshes are counted every frame into CSV stats AnimBonesEvaluated, AnimMeshesEvaluated and AnimMeshesInterpolated.
+ * Server side characters rewound by lag compensation keep full rate bones.
+ */
+UCLASS()
+class TPS_API UTPSAnimSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Meshes.Num() > 0; }
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	//End FTickableGameObject
+
+	//from the owner constructor, rate parameters are created when the mesh registers
+	static void SetupMesh(USkeletalMeshComponent* Mesh);
+	//ragdoll or dropped - montages stopped, anim instance released, tick off unless simulating
+	static void StopAnimation(USkeletalMeshComponent* Mesh);
+
+	//bFullRate - bones needed every frame even when not rendered (lag compensation hit boxes)
+	//bKeepMontages - montages tick off screen, their notifies drive gameplay
+	void Register(USkeletalMeshComponent* Mesh, bool bFullRate, bool bKeepMontages);
+	void Unregister(USkeletalMeshComponent* Mesh);
+
+protected:
+	static void OnUpdateRateParamsCreated(FAnimUpdateRateParameters* Params);
+
+	TArray<TWeakObjectPtr<USkeletalMeshComponent>> Meshes;
+};
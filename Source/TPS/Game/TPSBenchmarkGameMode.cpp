@@ -0,0 +1,400 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSBenchmarkGameMode.h"
+#include "TPSGameInstance.h"
+#include "../TPS.h"
+#include "../Character/TPSCharacter.h"
+#include "Engine/World.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/CommandLine.h"
+#include "RenderCore.h"
+
+ATPSBenchmarkGameMode::ATPSBenchmarkGameMode()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+}
+
+void ATPSBenchmarkGameMode::BeginPlay()
+{
+	Super::BeginPlay();
+
+	FParse::Value(FCommandLine::Get(), TEXT("TPSBenchmarkCharacters="), NumCharacters);
+	FParse::Value(FCommandLine::Get(), TEXT("TPSBenchmarkDuration="), Duration);
+	FParse::Value(FCommandLine::Get(), TEXT("TPSBenchmarkBaseline="), BaselineFile);
+	FParse::Value(FCommandLine::Get(), TEXT("TPSBenchmarkThreshold="), RegressionThresholdPercent);
+
+	//same dispersion and same script on every run
+	FMath::RandInit(RandomSeed);
+
+	UTPSGameInstance* myGI = Cast<UTPSGameInstance>(GetGameInstance());
+	if (myGI && myGI->WeaponInfoTable)
+	{
+		WeaponRows = myGI->WeaponInfoTable->GetRowNames();
+	}
+	if (WeaponRows.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("ATPSBenchmarkGameMode::BeginPlay - WeaponInfoTable empty or NULL"));
+	}
+
+	for (const FSoftClassPath& EffectPath : EffectClasses)
+	{
+		UClass* EffectClass = EffectPath.TryLoadClass<UTPS_StateEffect>();
+		if (EffectClass)
+		{
+			LoadedEffectClasses.Add(EffectClass);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ATPSBenchmarkGameMode::BeginPlay - Effect class not found - %s"), *EffectPath.ToString());
+		}
+	}
+
+	FrameTimes.Reserve(FMath::CeilToInt(Duration * 240.0f));
+	GameThreadTimes.Reserve(FMath::CeilToInt(Duration * 240.0f));
+
+	SpawnBenchmarkCharacters();
+}
+
+void ATPSBenchmarkGameMode::SpawnBenchmarkCharacters()
+{
+	if (!DefaultPawnClass)
+	{
+		UE_LOG(LogTemp, Error, TEXT("ATPSBenchmarkGameMode::SpawnBenchmarkCharacters - DefaultPawnClass -NULL"));
+		return;
+	}
+
+	FVector Center = FVector::ZeroVector;
+	AActor* Start = FindPlayerStart(nullptr);
+	if (Start)
+	{
+		Center = Start->GetActorLocation();
+	}
+
+	for (int32 i = 0; i < NumCharacters; i++)
+	{
+		//ring around the start, every character aims outwards
+		const float Angle = 2.0f * PI * i / FMath::Max(NumCharacters, 1);
+		const FVector Dir(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f);
+		const FVector SpawnLocation = Center + Dir * SpawnRadius;
+		const FRotator SpawnRotation = Dir.Rotation();
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+		ATPSCharacter* myChar = Cast<ATPSCharacter>(GetWorld()->SpawnActor(DefaultPawnClass, &SpawnLocation, &SpawnRotation, SpawnParams));
+		if (myChar)
+		{
+			myChar->SpawnDefaultController();
+
+			//never run dry, reload and switch logic still runs
+			if (myChar->InventoryComponent)
+			{
+				myChar->InventoryComponent->AmmoSlots.Empty();
+				for (EWeaponType Type : { EWeaponType::Pistol, EWeaponType::RifleType, EWeaponType::ShotGunType, EWeaponType::GrenadeLauncher })
+				{
+					FAmmoSlot Slot;
+					Slot.WeaponType = Type;
+					Slot.Cout = 100000;
+					Slot.MaxCout = 100000;
+					myChar->InventoryComponent->AmmoSlots.Add(Slot);
+				}
+				myChar->InventoryComponent->MarkAllSlotsDirty();
+			}
+
+			FBenchmarkCharacterScript Script;
+			Script.Character = myChar;
+			Script.Phase = (float)i / FMath::Max(NumCharacters, 1);
+			Script.AimDirection = Dir;
+			Script.WeaponRowIndex = WeaponRows.Num() > 0 ? i % WeaponRows.Num() : 0;
+			Script.NextReloadTime = ReloadInterval * (1.0f + Script.Phase);
+			Script.NextEffectTime = EffectInterval * Script.Phase;
+			Scripts.Add(Script);
+
+			SwitchCharacterWeapon(Scripts.Last());
+		}
+	}
+}
+
+void ATPSBenchmarkGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (bIsFinished)
+		return;
+
+	BenchmarkTime += DeltaSeconds;
+
+	for (FBenchmarkCharacterScript& Script : Scripts)
+	{
+		UpdateCharacterScript(Script, BenchmarkTime);
+	}
+
+	if (!bIsCapturing)
+	{
+		if (BenchmarkTime >= WarmupTime)
+		{
+			bIsCapturing = true;
+			BenchmarkTime = 0.0f;
+			for (FBenchmarkCharacterScript& Script : Scripts)
+			{
+				Script.NextWeaponTime = 0.0f;
+				Script.NextReloadTime = ReloadInterval * (1.0f + Script.Phase);
+				Script.NextEffectTime = EffectInterval * Script.Phase;
+			}
+			ShotsFired = 0;
+			ReloadsStarted = 0;
+			EffectsApplied = 0;
+			WeaponSwitches = 0;
+#if CSV_PROFILER
+			FCsvProfiler::Get()->BeginCapture(-1, FPaths::ProjectSavedDir() / TEXT("Benchmark"));
+#endif
+		}
+		return;
+	}
+
+	FrameTimes.Add(FApp::GetDeltaTime() * 1000.0f);
+	GameThreadTimes.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+
+	if (BenchmarkTime >= Duration)
+	{
+		FinishBenchmark();
+	}
+}
+
+void ATPSBenchmarkGameMode::UpdateCharacterScript(FBenchmarkCharacterScript& Script, float BenchTime)
+{
+	ATPSCharacter* myChar = Script.Character;
+	if (!myChar || myChar->CharHealthComponent->CharIsDead)
+		return;
+
+	//strafe in a small circle so movement and dispersion states change
+	const float T = BenchTime + Script.Phase * 10.0f;
+	myChar->AxisX = FMath::Sin(T * 0.7f);
+	myChar->AxisY = FMath::Cos(T * 0.7f);
+
+	const bool bAim = FMath::Fmod(T, 6.0f) > 3.0f;
+	if (myChar->AimEnabled != bAim)
+	{
+		myChar->AimEnabled = bAim;
+		myChar->ChangeMovementState();
+	}
+
+	AWeaponDefault* myWeapon = myChar->GetCurrentWeapon();
+	if (myWeapon)
+	{
+		myChar->SetActorRotation(Script.AimDirection.Rotation());
+		myWeapon->ShootEndLocation = myChar->GetActorLocation() + Script.AimDirection * 2000.0f;
+
+		//fire 2 sec, pause 0.5 sec
+		const bool bFire = FMath::Fmod(T, 2.5f) < 2.0f;
+		if (myWeapon->WeaponFiring != bFire)
+		{
+			myChar->AttackCharEvent(bFire);
+		}
+
+		const int32 Round = myWeapon->GetWeaponRound();
+		if (Round < Script.LastRound)
+		{
+			ShotsFired += Script.LastRound - Round;
+		}
+		Script.LastRound = Round;
+	}
+
+	if (BenchTime >= Script.NextWeaponTime)
+	{
+		Script.NextWeaponTime = BenchTime + WeaponCycleTime;
+		SwitchCharacterWeapon(Script);
+	}
+	if (BenchTime >= Script.NextReloadTime)
+	{
+		Script.NextReloadTime = BenchTime + ReloadInterval;
+		myChar->TryReloadWeapon();
+	}
+	if (BenchTime >= Script.NextEffectTime)
+	{
+		Script.NextEffectTime = BenchTime + EffectInterval;
+		ApplyCharacterEffect(Script);
+	}
+}
+
+void ATPSBenchmarkGameMode::SwitchCharacterWeapon(FBenchmarkCharacterScript& Script)
+{
+	if (WeaponRows.Num() == 0 || !Script.Character)
+		return;
+
+	Script.WeaponRowIndex = (Script.WeaponRowIndex + 1) % WeaponRows.Num();
+
+	UTPSGameInstance* myGI = Cast<UTPSGameInstance>(GetGameInstance());
+	FWeaponInfo myInfo;
+	if (myGI && myGI->GetWeaponInfoByName(WeaponRows[Script.WeaponRowIndex], myInfo))
+	{
+		FAdditionalWeaponInfo AdditionalInfo;
+		AdditionalInfo.Round = myInfo.MaxRound;
+		Script.Character->InitWeapon(WeaponRows[Script.WeaponRowIndex], AdditionalInfo, 0);
+		Script.LastRound = AdditionalInfo.Round;
+		WeaponSwitches++;
+
+		AWeaponDefault* myWeapon = Script.Character->GetCurrentWeapon();
+		if (myWeapon)
+		{
+			myWeapon->OnWeaponReloadStart.AddDynamic(this, &ATPSBenchmarkGameMode::BenchmarkWeaponReloadStart);
+		}
+	}
+}
+
+void ATPSBenchmarkGameMode::ApplyCharacterEffect(FBenchmarkCharacterScript& Script)
+{
+	if (LoadedEffectClasses.Num() == 0 || !Script.Character)
+		return;
+
+	Script.EffectIndex = (Script.EffectIndex + 1) % LoadedEffectClasses.Num();
+
+	UTPS_StateEffect* NewEffect = NewObject<UTPS_StateEffect>(Script.Character, LoadedEffectClasses[Script.EffectIndex]);
+	if (NewEffect)
+	{
+		NewEffect->InitObject(Script.Character);
+		EffectsApplied++;
+	}
+}
+
+void ATPSBenchmarkGameMode::BenchmarkWeaponReloadStart(UAnimMontage* Anim)
+{
+	ReloadsStarted++;
+}
+
+void ATPSBenchmarkGameMode::FinishBenchmark()
+{
+	bIsFinished = true;
+
+	for (FBenchmarkCharacterScript& Script : Scripts)
+	{
+		if (Script.Character)
+		{
+			Script.Character->AttackCharEvent(false);
+		}
+	}
+
+#if CSV_PROFILER
+	FCsvProfiler::Get()->EndCapture();
+#endif
+
+	TArray<TPair<FString, float>> Results;
+	CollectResults(Results);
+
+	bool bIsSuccess = WriteResults(Results);
+	if (bIsSuccess && !BaselineFile.IsEmpty())
+	{
+		bIsSuccess = CompareWithBaseline(Results);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("ATPSBenchmarkGameMode::FinishBenchmark - %s"), bIsSuccess ? TEXT("PASSED") : TEXT("FAILED"));
+	FPlatformMisc::RequestExitWithStatus(false, bIsSuccess ? 0 : 1);
+}
+
+static float GetPercentile(const TArray<float>& Sorted, float Percent)
+{
+	if (Sorted.Num() == 0)
+		return 0.0f;
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Percent / 100.0f * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+	return Sorted[Index];
+}
+
+void ATPSBenchmarkGameMode::CollectResults(TArray<TPair<FString, float>>& OutResults) const
+{
+	TArray<float> SortedFrames = FrameTimes;
+	SortedFrames.Sort();
+	TArray<float> SortedGameThread = GameThreadTimes;
+	SortedGameThread.Sort();
+
+	float FrameSum = 0.0f;
+	for (float Time : SortedFrames)
+	{
+		FrameSum += Time;
+	}
+	float GameThreadSum = 0.0f;
+	for (float Time : SortedGameThread)
+	{
+		GameThreadSum += Time;
+	}
+
+	//only *Ms metrics are compared with the baseline
+	OutResults.Add(TPair<FString, float>(TEXT("FrameAvgMs"), SortedFrames.Num() > 0 ? FrameSum / SortedFrames.Num() : 0.0f));
+	OutResults.Add(TPair<FString, float>(TEXT("FrameP50Ms"), GetPercentile(SortedFrames, 50.0f)));
+	OutResults.Add(TPair<FString, float>(TEXT("FrameP90Ms"), GetPercentile(SortedFrames, 90.0f)));
+	OutResults.Add(TPair<FString, float>(TEXT("FrameP99Ms"), GetPercentile(SortedFrames, 99.0f)));
+	OutResults.Add(TPair<FString, float>(TEXT("FrameMaxMs"), GetPercentile(SortedFrames, 100.0f)));
+	OutResults.Add(TPair<FString, float>(TEXT("GameThreadAvgMs"), SortedGameThread.Num() > 0 ? GameThreadSum / SortedGameThread.Num() : 0.0f));
+	OutResults.Add(TPair<FString, float>(TEXT("GameThreadP50Ms"), GetPercentile(SortedGameThread, 50.0f)));
+	OutResults.Add(TPair<FString, float>(TEXT("GameThreadP90Ms"), GetPercentile(SortedGameThread, 90.0f)));
+	OutResults.Add(TPair<FString, float>(TEXT("GameThreadP99Ms"), GetPercentile(SortedGameThread, 99.0f)));
+	OutResults.Add(TPair<FString, float>(TEXT("Frames"), SortedFrames.Num()));
+	OutResults.Add(TPair<FString, float>(TEXT("Characters"), Scripts.Num()));
+	OutResults.Add(TPair<FString, float>(TEXT("ShotsFired"), ShotsFired));
+	OutResults.Add(TPair<FString, float>(TEXT("ReloadsStarted"), ReloadsStarted));
+	OutResults.Add(TPair<FString, float>(TEXT("WeaponSwitches"), WeaponSwitches));
+	OutResults.Add(TPair<FString, float>(TEXT("EffectsApplied"), EffectsApplied));
+}
+
+bool ATPSBenchmarkGameMode::WriteResults(const TArray<TPair<FString, float>>& Results) const
+{
+	FString Text = TEXT("Metric,Value\n");
+	for (const TPair<FString, float>& Result : Results)
+	{
+		Text += FString::Printf(TEXT("%s,%f\n"), *Result.Key, Result.Value);
+		UE_LOG(LogTemp, Display, TEXT("ATPSBenchmarkGameMode - %s = %f"), *Result.Key, Result.Value);
+	}
+
+	const FString FilePath = FPaths::ProjectSavedDir() / ResultsFile;
+	if (!FFileHelper::SaveStringToFile(Text, *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("ATPSBenchmarkGameMode::WriteResults - Can't write %s"), *FilePath);
+		return false;
+	}
+	return true;
+}
+
+bool ATPSBenchmarkGameMode::CompareWithBaseline(const TArray<TPair<FString, float>>& Results) const
+{
+	FString FilePath = BaselineFile;
+	if (FPaths::IsRelative(FilePath))
+	{
+		FilePath = FPaths::ProjectDir() / FilePath;
+	}
+
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("ATPSBenchmarkGameMode::CompareWithBaseline - Baseline not found - %s"), *FilePath);
+		return false;
+	}
+
+	TMap<FString, float> Baseline;
+	for (const FString& Line : Lines)
+	{
+		FString Key, Value;
+		if (Line.Split(TEXT(","), &Key, &Value) && Value.IsNumeric())
+		{
+			Baseline.Add(Key, FCString::Atof(*Value));
+		}
+	}
+
+	bool bIsSuccess = true;
+	for (const TPair<FString, float>& Result : Results)
+	{
+		const float* BaseValue = Baseline.Find(Result.Key);
+		if (!BaseValue || !Result.Key.EndsWith(TEXT("Ms")) || *BaseValue <= 0.0f)
+			continue;
+
+		const float ChangePercent = (Result.Value - *BaseValue) / *BaseValue * 100.0f;
+		if (ChangePercent > RegressionThresholdPercent)
+		{
+			UE_LOG(LogTemp, Error, TEXT("ATPSBenchmarkGameMode::CompareWithBaseline - %s regressed %.1f%% (%f -> %f)"), *Result.Key, ChangePercent, *BaseValue, Result.Value);
+			bIsSuccess = false;
+		}
+	}
+	return bIsSuccess;
+}
@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TPSGameMode.h"
+#include "../StateEffects/TPS_StateEffect.h"
+#include "TPSBenchmarkGameMode.generated.h"
+
+class ATPSCharacter;
+
+USTRUCT()
+struct FBenchmarkCharacterScript
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	ATPSCharacter* Character = nullptr;
+
+	//phase offset so characters do not fire and reload on the same frame
+	float Phase = 0.0f;
+	FVector AimDirection = FVector::ForwardVector;
+	int32 WeaponRowIndex = 0;
+	int32 LastRound = 0;
+	float NextWeaponTime = 0.0f;
+	float NextReloadTime = 0.0f;
+	float NextEffectTime = 0.0f;
+	int32 EffectIndex = 0;
+};
+
+/**
+ * Headless gameplay benchmark (-nullrhi):
+ * TPS <Map>?game=Benchmark -nullrhi -unattended -TPSBenchmarkBaseline=<file>
+ * Spawns scripted characters, cycles all DT_WeaponInfo rows, applies state effects
+ * and writes frame time percentiles to Saved/Benchmark. Exit code 1 on regression.
+ */
+UCLASS(config = Game)
+class TPS_API ATPSBenchmarkGameMode : public ATPSGameMode
+{
+	GENERATED_BODY()
+
+public:
+	ATPSBenchmarkGameMode();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	int32 NumCharacters = 8;
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	float SpawnRadius = 600.0f;
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	float WarmupTime = 3.0f;
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	float Duration = 60.0f;
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	float WeaponCycleTime = 4.0f;
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	float ReloadInterval = 2.5f;
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	float EffectInterval = 3.0f;
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	int32 RandomSeed = 1337;
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	TArray<FSoftClassPath> EffectClasses;
+
+	//relative to Saved/
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	FString ResultsFile = TEXT("Benchmark/TPSBenchmark.csv");
+	//relative to project dir, empty - no compare
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	FString BaselineFile;
+	//allowed grow of every metric over baseline in percent
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "Benchmark")
+	float RegressionThresholdPercent = 10.0f;
+
+protected:
+	virtual void BeginPlay() override;
+
+	void SpawnBenchmarkCharacters();
+	void UpdateCharacterScript(FBenchmarkCharacterScript& Script, float BenchTime);
+	void SwitchCharacterWeapon(FBenchmarkCharacterScript& Script);
+	void ApplyCharacterEffect(FBenchmarkCharacterScript& Script);
+
+	UFUNCTION()
+	void BenchmarkWeaponReloadStart(UAnimMontage* Anim);
+
+	void FinishBenchmark();
+	void CollectResults(TArray<TPair<FString, float>>& OutResults) const;
+	bool WriteResults(const TArray<TPair<FString, float>>& Results) const;
+	bool CompareWithBaseline(const TArray<TPair<FString, float>>& Results) const;
+
+	UPROPERTY()
+	TArray<FBenchmarkCharacterScript> Scripts;
+	UPROPERTY()
+	TArray<TSubclassOf<UTPS_StateEffect>> LoadedEffectClasses;
+
+	TArray<FName> WeaponRows;
+	TArray<float> FrameTimes;
+	TArray<float> GameThreadTimes;
+
+	float BenchmarkTime = 0.0f;
+	bool bIsCapturing = false;
+	bool bIsFinished = false;
+
+	int32 ShotsFired = 0;
+	int32 ReloadsStarted = 0;
+	int32 EffectsApplied = 0;
+	int32 WeaponSwitches = 0;
+};
@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSBotController.h"
+#include "../Character/TPSCharacter.h"
+#include "../Weapon/WeaponDefault.h"
+
+void FTPSBotScript::Init(int32 Seed)
+{
+	Stream.Initialize(Seed);
+	BotTime = 0.0f;
+	//spread first actions so bots do not act on the same frame
+	NextMoveTime = Stream.FRandRange(0.0f, 1.0f);
+	NextAimTime = Stream.FRandRange(0.0f, 1.0f);
+	NextBurstTime = Stream.FRandRange(0.5f, 2.0f);
+	NextSwitchTime = Stream.FRandRange(4.0f, 10.0f);
+	NextReloadTime = Stream.FRandRange(3.0f, 8.0f);
+	bIsFiring = false;
+}
+
+void FTPSBotScript::Tick(ATPSCharacter* Character, float DeltaTime)
+{
+	if (!Character || !Character->CharHealthComponent || Character->CharHealthComponent->CharIsDead)
+		return;
+
+	BotTime += DeltaTime;
+
+	if (BotTime >= NextMoveTime)
+	{
+		//one of 8 directions or stand still
+		const int32 Dir = Stream.RandRange(0, 8);
+		if (Dir == 8)
+		{
+			MoveDirection = FVector::ZeroVector;
+		}
+		else
+		{
+			const float Angle = Dir * PI * 0.25f;
+			MoveDirection = FVector(FMath::RoundToFloat(FMath::Cos(Angle)), FMath::RoundToFloat(FMath::Sin(Angle)), 0.0f);
+		}
+		NextMoveTime = BotTime + Stream.FRandRange(1.0f, 3.0f);
+	}
+	Character->AxisX = MoveDirection.X;
+	Character->AxisY = MoveDirection.Y;
+
+	if (BotTime >= NextAimTime)
+	{
+		const float Angle = Stream.FRandRange(0.0f, 2.0f * PI);
+		AimDirection = FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f);
+		NextAimTime = BotTime + Stream.FRandRange(0.5f, 2.0f);
+	}
+
+	if (bIsFiring && BotTime >= BurstEndTime)
+	{
+		bIsFiring = false;
+		NextBurstTime = BotTime + Stream.FRandRange(0.3f, 1.5f);
+	}
+	else if (!bIsFiring && BotTime >= NextBurstTime)
+	{
+		bIsFiring = true;
+		BurstEndTime = BotTime + Stream.FRandRange(0.5f, 2.5f);
+	}
+
+	AWeaponDefault* myWeapon = Character->GetCurrentWeapon();
+	if (myWeapon)
+	{
+		Character->SetActorRotation(AimDirection.Rotation());
+		myWeapon->ShootEndLocation = Character->GetActorLocation() + AimDirection * 2000.0f;
+
+		//new weapon after switch starts not firing
+		if (myWeapon->WeaponFiring != bIsFiring)
+		{
+			Character->AttackCharEvent(bIsFiring);
+		}
+	}
+
+	if (BotTime >= NextSwitchTime)
+	{
+		if (Stream.FRand() < 0.5f)
+			Character->TrySwicthNextWeapon();
+		else
+			Character->TrySwitchPreviosWeapon();
+		NextSwitchTime = BotTime + Stream.FRandRange(4.0f, 10.0f);
+	}
+	if (BotTime >= NextReloadTime)
+	{
+		Character->TryReloadWeapon();
+		NextReloadTime = BotTime + Stream.FRandRange(3.0f, 8.0f);
+	}
+}
+
+ATPSBotController::ATPSBotController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+}
+
+void ATPSBotController::InitBot(int32 Seed)
+{
+	BotSeed = Seed;
+	Script.Init(Seed);
+}
+
+void ATPSBotController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	Script.Tick(Cast<ATPSCharacter>(GetPawn()), DeltaSeconds);
+}
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "TPSBotController.generated.h"
+
+class ATPSCharacter;
+
+//Seeded behaviour of one bot, same seed - same sequence of moves, bursts, switches and reloads
+struct TPS_API FTPSBotScript
+{
+	void Init(int32 Seed);
+	void Tick(ATPSCharacter* Character, float DeltaTime);
+
+	FRandomStream Stream;
+	FVector MoveDirection = FVector::ZeroVector;
+	FVector AimDirection = FVector::ForwardVector;
+	float BotTime = 0.0f;
+	float NextMoveTime = 0.0f;
+	float NextAimTime = 0.0f;
+	float NextBurstTime = 0.0f;
+	float BurstEndTime = 0.0f;
+	float NextSwitchTime = 0.0f;
+	float NextReloadTime = 0.0f;
+	bool bIsFiring = false;
+};
+
+/**
+ * Server side bot for load tests (ATPSBotSwarmGameMode),
+ * drives the possessed ATPSCharacter through FTPSBotScript.
+ * Client process bots use ATPSPlayerController with -TPSBot instead.
+ */
+UCLASS()
+class TPS_API ATPSBotController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	ATPSBotController();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	void InitBot(int32 Seed);
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Bot")
+	int32 BotSeed = 0;
+
+protected:
+	FTPSBotScript Script;
+};
@@ -0,0 +1,191 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSBotSwarmGameMode.h"
+#include "TPSBotController.h"
+#include "../TPS.h"
+#include "../Character/TPSCharacter.h"
+#include "Engine/World.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/CommandLine.h"
+#include "RenderCore.h"
+
+ATPSBotSwarmGameMode::ATPSBotSwarmGameMode()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+}
+
+void ATPSBotSwarmGameMode::BeginPlay()
+{
+	Super::BeginPlay();
+
+	FParse::Value(FCommandLine::Get(), TEXT("TPSBotSwarmMax="), MaxBots);
+	FParse::Value(FCommandLine::Get(), TEXT("TPSBotSwarmStep="), BotsPerStep);
+	FParse::Value(FCommandLine::Get(), TEXT("TPSBotSwarmInterval="), StepInterval);
+	FParse::Value(FCommandLine::Get(), TEXT("TPSBotSwarmDuration="), Duration);
+	FParse::Value(FCommandLine::Get(), TEXT("TPSBotSwarmSeed="), RandomSeed);
+
+	FMath::RandInit(RandomSeed);
+	LastRPCCount = GTPSServerRPCCount;
+
+	const FString FilePath = FPaths::ProjectSavedDir() / ResultsFile;
+	if (!FFileHelper::SaveStringToFile(TEXT("Time,Bots,Connections,TickAvgMs,TickMaxMs,GameThreadAvgMs,OutKBpsPerConnection,InKBpsPerConnection,ServerRPCsPerSec\n"), *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("ATPSBotSwarmGameMode::BeginPlay - Can't write %s"), *FilePath);
+	}
+}
+
+void ATPSBotSwarmGameMode::SpawnBots(int32 Count)
+{
+	if (!DefaultPawnClass)
+	{
+		UE_LOG(LogTemp, Error, TEXT("ATPSBotSwarmGameMode::SpawnBots - DefaultPawnClass -NULL"));
+		return;
+	}
+
+	FVector Center = FVector::ZeroVector;
+	AActor* Start = FindPlayerStart(nullptr);
+	if (Start)
+	{
+		Center = Start->GetActorLocation();
+	}
+
+	for (int32 i = 0; i < Count && Bots.Num() < MaxBots; i++)
+	{
+		const int32 BotIndex = Bots.Num();
+		//golden angle spiral, new bots do not land on old ones
+		const float Angle = BotIndex * 2.39996f;
+		const float Radius = SpawnRadius * FMath::Sqrt((BotIndex + 0.5f) / FMath::Max(MaxBots, 1));
+		const FVector SpawnLocation = Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * Radius;
+		const FRotator SpawnRotation(0.0f, FMath::RadiansToDegrees(Angle), 0.0f);
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+		ATPSCharacter* myChar = Cast<ATPSCharacter>(GetWorld()->SpawnActor(DefaultPawnClass, &SpawnLocation, &SpawnRotation, SpawnParams));
+		if (!myChar)
+			continue;
+
+		ATPSBotController* myBot = GetWorld()->SpawnActor<ATPSBotController>(ATPSBotController::StaticClass(), SpawnLocation, SpawnRotation);
+		if (!myBot)
+		{
+			myChar->Destroy();
+			continue;
+		}
+		myBot->InitBot(RandomSeed + BotIndex);
+		myBot->Possess(myChar);
+
+		//never run dry, reload and switch logic still runs
+		if (myChar->InventoryComponent)
+		{
+			myChar->InventoryComponent->AmmoSlots.Empty();
+			for (EWeaponType Type : { EWeaponType::Pistol, EWeaponType::RifleType, EWeaponType::ShotGunType, EWeaponType::GrenadeLauncher })
+			{
+				FAmmoSlot Slot;
+				Slot.WeaponType = Type;
+				Slot.Cout = 100000;
+				Slot.MaxCout = 100000;
+				myChar->InventoryComponent->AmmoSlots.Add(Slot);
+			}
+			myChar->InventoryComponent->MarkAllSlotsDirty();
+		}
+
+		Bots.Add(myBot);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("ATPSBotSwarmGameMode::SpawnBots - %d bots"), Bots.Num());
+}
+
+void ATPSBotSwarmGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (bIsFinished)
+		return;
+
+	SwarmTime += DeltaSeconds;
+
+	const float TickMs = FApp::GetDeltaTime() * 1000.0f;
+	ReportFrames++;
+	ReportTickSum += TickMs;
+	ReportTickMax = FMath::Max(ReportTickMax, TickMs);
+	ReportGameThreadSum += FPlatformTime::ToMilliseconds(GGameThreadTime);
+
+	if (SwarmTime >= NextStepTime && Bots.Num() < MaxBots)
+	{
+		NextStepTime = SwarmTime + StepInterval;
+		SpawnBots(BotsPerStep);
+	}
+
+	if (SwarmTime >= NextReportTime)
+	{
+		NextReportTime = SwarmTime + ReportInterval;
+		WriteReport();
+	}
+
+	if (Duration > 0.0f && SwarmTime >= Duration)
+	{
+		FinishSwarm();
+	}
+}
+
+void ATPSBotSwarmGameMode::WriteReport()
+{
+	int32 NumConnections = 0;
+	float OutBytes = 0.0f;
+	float InBytes = 0.0f;
+	UNetDriver* myNetDriver = GetWorld()->GetNetDriver();
+	if (myNetDriver)
+	{
+		for (UNetConnection* Connection : myNetDriver->ClientConnections)
+		{
+			if (Connection)
+			{
+				NumConnections++;
+				OutBytes += Connection->OutBytesPerSecond;
+				InBytes += Connection->InBytesPerSecond;
+			}
+		}
+	}
+
+	const float ReportTime = FMath::Max(ReportInterval, KINDA_SMALL_NUMBER);
+	const float RPCsPerSec = (GTPSServerRPCCount - LastRPCCount) / ReportTime;
+	LastRPCCount = GTPSServerRPCCount;
+
+	const int32 Frames = FMath::Max(ReportFrames, 1);
+	const float PerConnection = 1.0f / (1024.0f * FMath::Max(NumConnections, 1));
+	const FString Line = FString::Printf(TEXT("%.2f,%d,%d,%.3f,%.3f,%.3f,%.2f,%.2f,%.1f\n"),
+		SwarmTime, Bots.Num(), NumConnections, ReportTickSum / Frames, ReportTickMax, ReportGameThreadSum / Frames,
+		OutBytes * PerConnection, InBytes * PerConnection, RPCsPerSec);
+
+	const FString FilePath = FPaths::ProjectSavedDir() / ResultsFile;
+	FFileHelper::SaveStringToFile(Line, *FilePath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+	UE_LOG(LogTemp, Display, TEXT("ATPSBotSwarmGameMode - %s"), *Line.TrimEnd());
+
+	ReportFrames = 0;
+	ReportTickSum = 0.0f;
+	ReportTickMax = 0.0f;
+	ReportGameThreadSum = 0.0f;
+}
+
+void ATPSBotSwarmGameMode::FinishSwarm()
+{
+	bIsFinished = true;
+
+	for (ATPSBotController* myBot : Bots)
+	{
+		ATPSCharacter* myChar = myBot ? Cast<ATPSCharacter>(myBot->GetPawn()) : nullptr;
+		if (myChar)
+		{
+			myChar->AttackCharEvent(false);
+		}
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("ATPSBotSwarmGameMode::FinishSwarm - %d bots, results in %s"), Bots.Num(), *(FPaths::ProjectSavedDir() / ResultsFile));
+	FPlatformMisc::RequestExit(false);
+}
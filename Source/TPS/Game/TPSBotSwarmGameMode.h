@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TPSGameMode.h"
+#include "TPSBotSwarmGameMode.generated.h"
+
+class ATPSBotController;
+
+/**
+ * Server load test: TPS <Map>?game=BotSwarm -server -nullrhi (or -nullrhi listen/standalone).
+ * Ramps server side ATPSBotController bots up to MaxBots, -TPSBot client processes may join too.
+ * Every ReportInterval writes tick time, per connection bandwidth and server RPC rate to Saved/ResultsFile.
+ */
+UCLASS(config = Game)
+class TPS_API ATPSBotSwarmGameMode : public ATPSGameMode
+{
+	GENERATED_BODY()
+
+public:
+	ATPSBotSwarmGameMode();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "BotSwarm")
+	int32 MaxBots = 64;
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "BotSwarm")
+	int32 BotsPerStep = 8;
+	//seconds between ramp steps
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "BotSwarm")
+	float StepInterval = 15.0f;
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "BotSwarm")
+	float ReportInterval = 1.0f;
+	//0 - run until closed
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "BotSwarm")
+	float Duration = 0.0f;
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "BotSwarm")
+	int32 RandomSeed = 1337;
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "BotSwarm")
+	float SpawnRadius = 1500.0f;
+	//relative to Saved/
+	UPROPERTY(Config, EditAnywhere, BlueprintReadWrite, Category = "BotSwarm")
+	FString ResultsFile = TEXT("Benchmark/BotSwarm.csv");
+
+protected:
+	virtual void BeginPlay() override;
+
+	void SpawnBots(int32 Count);
+	void WriteReport();
+	void FinishSwarm();
+
+	UPROPERTY()
+	TArray<ATPSBotController*> Bots;
+
+	float SwarmTime = 0.0f;
+	float NextStepTime = 0.0f;
+	float NextReportTime = 0.0f;
+	bool bIsFinished = false;
+
+	//accumulated since last report
+	int32 ReportFrames = 0;
+	float ReportTickSum = 0.0f;
+	float ReportTickMax = 0.0f;
+	float ReportGameThreadSum = 0.0f;
+	int32 LastRPCCount = 0;
+};
@@ -0,0 +1,269 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSCorpseSubsystem.h"
+#include "../Character/TPSCharacter.h"
+#include "../TPS.h"
+#include "Components/PoseableMeshComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Engine/World.h"
+
+int32 CorpseMaxSimulating = 8;
+FAutoConsoleVariableRef CVARCorpseMaxSimulating{
+	TEXT("TPS.Corpse.MaxSimulating"),
+	CorpseMaxSimulating,
+	TEXT("Ragdolls simulating at once, oldest is frozen when exceeded"),
+	ECVF_Default
+};
+
+int32 CorpseMaxCorpses = 24;
+FAutoConsoleVariableRef CVARCorpseMaxCorpses{
+	TEXT("TPS.Corpse.MaxCorpses"),
+	CorpseMaxCorpses,
+	TEXT("Corpses kept in the world, oldest fades and is recycled when exceeded"),
+	ECVF_Default
+};
+
+float CorpseMaxSimulateTime = 6.0f;
+FAutoConsoleVariableRef CVARCorpseMaxSimulateTime{
+	TEXT("TPS.Corpse.MaxSimulateTime"),
+	CorpseMaxSimulateTime,
+	TEXT("Seconds a ragdoll may simulate before freeze even if not settled"),
+	ECVF_Default
+};
+
+float CorpseSettleSpeed = 5.0f;
+FAutoConsoleVariableRef CVARCorpseSettleSpeed{
+	TEXT("TPS.Corpse.SettleSpeed"),
+	CorpseSettleSpeed,
+	TEXT("Pelvis speed cm/s under which a ragdoll counts as settled"),
+	ECVF_Default
+};
+
+float CorpseSettleTime = 0.5f;
+FAutoConsoleVariableRef CVARCorpseSettleTime{
+	TEXT("TPS.Corpse.SettleTime"),
+	CorpseSettleTime,
+	TEXT("Seconds settled (or asleep) before freeze"),
+	ECVF_Default
+};
+
+float CorpseFadeTime = 2.0f;
+FAutoConsoleVariableRef CVARCorpseFadeTime{
+	TEXT("TPS.Corpse.FadeTime"),
+	CorpseFadeTime,
+	TEXT("Seconds the oldest corpse sinks before recycle"),
+	ECVF_Default
+};
+
+static const float CorpseFadeDepth = 100.0f;
+
+void UTPSCorpseSubsystem::Deinitialize()
+{
+	Corpses.Empty();
+	Super::Deinitialize();
+}
+
+TStatId UTPSCorpseSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTPSCorpseSubsystem, STATGROUP_Tickables);
+}
+
+int32 UTPSCorpseSubsystem::GetNumSimulating() const
+{
+	int32 Result = 0;
+	for (const FTPSCorpse& Corpse : Corpses)
+	{
+		if (Corpse.State == ETPSCorpseState::Simulating)
+			Result++;
+	}
+	return Result;
+}
+
+void UTPSCorpseSubsystem::AddCorpse(ATPSCharacter* Character)
+{
+	if (!Character || !Character->GetMesh())
+		return;
+
+	FTPSCorpse& Corpse = Corpses.AddDefaulted_GetRef();
+	Corpse.Character = Character;
+
+	//nobody sees the ragdoll on a dedicated server
+	if (!TPSShouldPlayCosmetics(GetWorld()))
+	{
+		Freeze(Corpse);
+	}
+	else
+	{
+		StartSimulation(Corpse);
+	}
+
+	//over budget - freeze oldest simulating ragdolls
+	int32 NumSimulating = GetNumSimulating();
+	for (int32 i = 0; i < Corpses.Num() && NumSimulating > FMath::Max(CorpseMaxSimulating, 0); i++)
+	{
+		if (Corpses[i].State == ETPSCorpseState::Simulating)
+		{
+			Freeze(Corpses[i]);
+			NumSimulating--;
+		}
+	}
+
+	//over budget - fade oldest corpses not already fading
+	int32 NumKept = 0;
+	for (const FTPSCorpse& Each : Corpses)
+	{
+		if (Each.State != ETPSCorpseState::Fading)
+			NumKept++;
+	}
+	for (int32 i = 0; i < Corpses.Num() && NumKept > FMath::Max(CorpseMaxCorpses, 1); i++)
+	{
+		if (Corpses[i].State != ETPSCorpseState::Fading)
+		{
+			StartFade(Corpses[i]);
+			NumKept--;
+		}
+	}
+}
+
+void UTPSCorpseSubsystem::StartSimulation(FTPSCorpse& Corpse)
+{
+	USkeletalMeshComponent* myMesh = Corpse.Character->GetMesh();
+	myMesh->SetCollisionEnabled(ECollisionEnabled::PhysicsOnly);
+	myMesh->SetSimulatePhysics(true);
+
+	Corpse.State = ETPSCorpseState::Simulating;
+	Corpse.StateTime = 0.0f;
+	Corpse.SettledTime = 0.0f;
+}
+
+void UTPSCorpseSubsystem::Freeze(FTPSCorpse& Corpse)
+{
+	ATPSCharacter* myChar = Corpse.Character.Get();
+	USkeletalMeshComponent* myMesh = myChar ? myChar->GetMesh() : nullptr;
+	if (!myMesh)
+		return;
+
+	if (TPSShouldPlayCosmetics(GetWorld()) && myMesh->SkeletalMesh)
+	{
+		//bake the current (physics) pose, poseable mesh has no anim or physics tick
+		UPoseableMeshComponent* myPose = NewObject<UPoseableMeshComponent>(myChar, NAME_None, RF_Transient);
+		myPose->SetSkeletalMesh(myMesh->SkeletalMesh);
+		for (int32 i = 0; i < myMesh->GetNumMaterials(); i++)
+		{
+			myPose->SetMaterial(i, myMesh->GetMaterial(i));
+		}
+		myPose->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		myPose->SetCastShadow(myMesh->CastShadow);
+		myPose->SetComponentTickEnabled(false);
+		myPose->SetWorldTransform(myMesh->GetComponentTransform());
+		myPose->RegisterComponent();
+		myPose->CopyPoseFromSkeletalComponent(myMesh);
+		Corpse.PoseMesh = myPose;
+
+		myMesh->SetVisibility(false);
+	}
+
+	myMesh->SetSimulatePhysics(false);
+	myMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	myMesh->bNoSkeletonUpdate = true;
+	myMesh->SetComponentTickEnabled(false);
+	if (myChar->GetCharacterMovement())
+	{
+		myChar->GetCharacterMovement()->SetComponentTickEnabled(false);
+	}
+	myChar->SetActorTickEnabled(false);
+
+	Corpse.State = ETPSCorpseState::Frozen;
+	Corpse.StateTime = 0.0f;
+}
+
+void UTPSCorpseSubsystem::StartFade(FTPSCorpse& Corpse)
+{
+	if (Corpse.State == ETPSCorpseState::Simulating)
+	{
+		Freeze(Corpse);
+	}
+	Corpse.State = ETPSCorpseState::Fading;
+	Corpse.StateTime = 0.0f;
+}
+
+void UTPSCorpseSubsystem::Recycle(FTPSCorpse& Corpse)
+{
+	ATPSCharacter* myChar = Corpse.Character.Get();
+	if (Corpse.PoseMesh.IsValid())
+	{
+		Corpse.PoseMesh->DestroyComponent();
+	}
+	if (!myChar)
+		return;
+
+	if (myChar->HasAuthority())
+	{
+		myChar->Destroy();
+	}
+	else
+	{
+		//replicated actor, server destroys it, until then keep it hidden
+		myChar->SetActorHiddenInGame(true);
+		myChar->SetActorEnableCollision(false);
+	}
+}
+
+void UTPSCorpseSubsystem::Tick(float DeltaTime)
+{
+	int32 NumSimulating = 0;
+
+	for (int32 i = 0; i < Corpses.Num(); i++)
+	{
+		FTPSCorpse& Corpse = Corpses[i];
+		ATPSCharacter* myChar = Corpse.Character.Get();
+		if (!myChar || myChar->IsPendingKill())
+		{
+			Corpses.RemoveAt(i);
+			i--;
+			continue;
+		}
+
+		Corpse.StateTime += DeltaTime;
+		switch (Corpse.State)
+		{
+		case ETPSCorpseState::Simulating:
+		{
+			USkeletalMeshComponent* myMesh = myChar->GetMesh();
+			const bool bIsSettled = !myMesh->IsAnyRigidBodyAwake()
+				|| myMesh->GetPhysicsLinearVelocity().SizeSquared() < FMath::Square(CorpseSettleSpeed);
+			Corpse.SettledTime = bIsSettled ? Corpse.SettledTime + DeltaTime : 0.0f;
+
+			if (Corpse.SettledTime >= CorpseSettleTime || Corpse.StateTime >= CorpseMaxSimulateTime)
+			{
+				Freeze(Corpse);
+			}
+			else
+			{
+				NumSimulating++;
+			}
+			break;
+		}
+		case ETPSCorpseState::Fading:
+			if (Corpse.StateTime >= CorpseFadeTime)
+			{
+				Recycle(Corpse);
+				Corpses.RemoveAt(i);
+				i--;
+			}
+			else if (Corpse.PoseMesh.IsValid())
+			{
+				const float Sink = CorpseFadeDepth * DeltaTime / FMath::Max(CorpseFadeTime, KINDA_SMALL_NUMBER);
+				Corpse.PoseMesh->AddWorldOffset(FVector(0.0f, 0.0f, -Sink));
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	CSV_CUSTOM_STAT(TPS, RagdollsSimulating, NumSimulating, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(TPS, Corpses, Corpses.Num(), ECsvCustomStatOp::Set);
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "TPSCorpseSubsystem.generated.h"
+
+class ATPSCharacter;
+class UPoseableMeshComponent;
+
+enum class ETPSCorpseState : uint8
+{
+	Simulating,
+	//simulation off, pose kept in PoseMesh
+	Frozen,
+	//sinking before recycle
+	Fading
+};
+
+struct FTPSCorpse
+{
+	TWeakObjectPtr<ATPSCharacter> Character;
+	TWeakObjectPtr<UPoseableMeshComponent> PoseMesh;
+	ETPSCorpseState State = ETPSCorpseState::Simulating;
+	float StateTime = 0.0f;
+	//time below TPS.Corpse.SettleSpeed
+	float SettledTime = 0.0f;
+};
+
+/**
+ * Budget for dead characters.
+ * At most TPS.Corpse.MaxSimulating ragdolls simulate, settled or oldest ones are frozen:
+ * physics off and the pose baked into a UPoseableMeshComponent that never ticks.
+ * Over TPS.Corpse.MaxCorpses the oldest corpse sinks for TPS.Corpse.FadeTime and is recycled.
+ */
+UCLASS()
+class TPS_API UTPSCorpseSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Corpses.Num() > 0; }
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	//End FTickableGameObject
+
+	//called instead of enabling ragdoll on the character
+	void AddCorpse(ATPSCharacter* Character);
+
+	int32 GetNumSimulating() const;
+
+protected:
+	void StartSimulation(FTPSCorpse& Corpse);
+	void Freeze(FTPSCorpse& Corpse);
+	void StartFade(FTPSCorpse& Corpse);
+	void Recycle(FTPSCorpse& Corpse);
+
+	//oldest first
+	TArray<FTPSCorpse> Corpses;
+};
@@ -0,0 +1,258 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSDamageNumberSubsystem.h"
+#include "../TPS.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/UserInterfaceSettings.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "SceneView.h"
+#include "Styling/CoreStyle.h"
+#include "Widgets/SCanvas.h"
+#include "Widgets/Text/STextBlock.h"
+
+int32 DamageNumbersEnable = 1;
+FAutoConsoleVariableRef CVARDamageNumbersEnable{
+	TEXT("TPS.DamageNumbers.Enable"),
+	DamageNumbersEnable,
+	TEXT("Floating damage numbers over damaged actors"),
+	ECVF_Default
+};
+
+int32 DamageNumbersMaxVisible = 24;
+FAutoConsoleVariableRef CVARDamageNumbersMaxVisible{
+	TEXT("TPS.DamageNumbers.MaxVisible"),
+	DamageNumbersMaxVisible,
+	TEXT("Text widgets in the pool, created on first damage in a world"),
+	ECVF_Default
+};
+
+float DamageNumbersMergeWindow = 0.3f;
+FAutoConsoleVariableRef CVARDamageNumbersMergeWindow{
+	TEXT("TPS.DamageNumbers.MergeWindow"),
+	DamageNumbersMergeWindow,
+	TEXT("Seconds after a hit during which the next hit on the same target adds to its number"),
+	ECVF_Default
+};
+
+float DamageNumbersLifetime = 1.0f;
+FAutoConsoleVariableRef CVARDamageNumbersLifetime{
+	TEXT("TPS.DamageNumbers.Lifetime"),
+	DamageNumbersLifetime,
+	TEXT("Seconds a number stays after its last hit, fades out in the last third"),
+	ECVF_Default
+};
+
+float DamageNumbersRiseSpeed = 80.0f;
+FAutoConsoleVariableRef CVARDamageNumbersRiseSpeed{
+	TEXT("TPS.DamageNumbers.RiseSpeed"),
+	DamageNumbersRiseSpeed,
+	TEXT("World units per second a number floats up"),
+	ECVF_Default
+};
+
+static const FVector2D DamageNumberSize(120.0f, 30.0f);
+static const int32 DamageNumberFontSize = 18;
+static const int32 DamageNumberZOrder = 10;
+
+void UTPSDamageNumberSubsystem::Deinitialize()
+{
+	UGameViewportClient* myViewport = GetWorld() ? GetWorld()->GetGameViewport() : nullptr;
+	if (Canvas.IsValid() && myViewport)
+	{
+		myViewport->RemoveViewportWidgetContent(Canvas.ToSharedRef());
+	}
+	Canvas.Reset();
+	TextBlocks.Empty();
+	Numbers.Empty();
+	NumActive = 0;
+
+	Super::Deinitialize();
+}
+
+TStatId UTPSDamageNumberSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTPSDamageNumberSubsystem, STATGROUP_Tickables);
+}
+
+bool UTPSDamageNumberSubsystem::CreateWidgets()
+{
+	if (Canvas.IsValid())
+		return true;
+
+	UGameViewportClient* myViewport = GetWorld()->GetGameViewport();
+	if (!myViewport)
+	{
+		bWidgetsFailed = true;
+		return false;
+	}
+
+	const int32 PoolSize = FMath::Clamp(DamageNumbersMaxVisible, 1, 128);
+	Numbers.SetNum(PoolSize);
+	TextBlocks.SetNum(PoolSize);
+
+	SAssignNew(Canvas, SCanvas)
+		.Visibility(EVisibility::Collapsed);
+
+	for (int32 i = 0; i < PoolSize; i++)
+	{
+		SAssignNew(TextBlocks[i], STextBlock)
+			.Font(FCoreStyle::GetDefaultFontStyle("Bold", DamageNumberFontSize))
+			.ShadowOffset(FVector2D(1.0f, 1.0f))
+			.Justification(ETextJustify::Center)
+			.Visibility(TAttribute<EVisibility>::Create(TAttribute<EVisibility>::FGetter::CreateUObject(this, &UTPSDamageNumberSubsystem::GetNumberVisibility, i)))
+			.ColorAndOpacity(TAttribute<FSlateColor>::Create(TAttribute<FSlateColor>::FGetter::CreateUObject(this, &UTPSDamageNumberSubsystem::GetNumberColor, i)));
+
+		Canvas->AddSlot()
+			.Position(TAttribute<FVector2D>::Create(TAttribute<FVector2D>::FGetter::CreateUObject(this, &UTPSDamageNumberSubsystem::GetNumberPosition, i)))
+			.Size(DamageNumberSize)
+			.HAlign(HAlign_Center)
+			.VAlign(VAlign_Center)
+			[
+				TextBlocks[i].ToSharedRef()
+			];
+	}
+
+	myViewport->AddViewportWidgetContent(Canvas.ToSharedRef(), DamageNumberZOrder);
+	return true;
+}
+
+void UTPSDamageNumberSubsystem::AddDamage(AActor* Target, float Amount)
+{
+	if (DamageNumbersEnable == 0 || !Target || Amount <= 0.0f || bWidgetsFailed || !TPSShouldPlayCosmetics(GetWorld()))
+		return;
+
+	if (!CreateWidgets())
+		return;
+
+	//merge into a recent number of the same target
+	int32 Index = Numbers.IndexOfByPredicate([Target](const FTPSDamageNumber& Elem)
+	{
+		return Elem.bActive && Elem.Target == Target && Elem.Age <= DamageNumbersMergeWindow;
+	});
+	if (Index != INDEX_NONE)
+	{
+		CSV_CUSTOM_STAT(TPS, DamageNumbersMerged, 1, ECsvCustomStatOp::Accumulate);
+	}
+	else
+	{
+		//free entry, or the oldest one when all are shown
+		float OldestAge = -1.0f;
+		for (int32 i = 0; i < Numbers.Num(); i++)
+		{
+			if (!Numbers[i].bActive)
+			{
+				Index = i;
+				break;
+			}
+			if (Numbers[i].Age > OldestAge)
+			{
+				OldestAge = Numbers[i].Age;
+				Index = i;
+			}
+		}
+
+		FTPSDamageNumber& myNumber = Numbers[Index];
+		if (!myNumber.bActive)
+		{
+			NumActive++;
+		}
+		myNumber = FTPSDamageNumber();
+		myNumber.bActive = true;
+		myNumber.Target = Target;
+		myNumber.WorldLocation = Target->GetActorLocation() + FVector(0.0f, 0.0f, Target->GetSimpleCollisionHalfHeight());
+	}
+
+	FTPSDamageNumber& myNumber = Numbers[Index];
+	myNumber.Amount += Amount;
+	myNumber.Age = 0.0f;
+	TextBlocks[Index]->SetText(FText::AsNumber(FMath::CeilToInt(myNumber.Amount)));
+
+	Canvas->SetVisibility(EVisibility::HitTestInvisible);
+}
+
+void UTPSDamageNumberSubsystem::Tick(float DeltaTime)
+{
+	const float Lifetime = FMath::Max(DamageNumbersLifetime, KINDA_SMALL_NUMBER);
+	for (FTPSDamageNumber& Number : Numbers)
+	{
+		if (!Number.bActive)
+			continue;
+
+		Number.Age += DeltaTime;
+		if (Number.Age >= Lifetime)
+		{
+			Number.bActive = false;
+			Number.Target.Reset();
+			NumActive--;
+			continue;
+		}
+		Number.WorldLocation.Z += DamageNumbersRiseSpeed * DeltaTime;
+	}
+
+	ProjectNumbers();
+
+	if (NumActive == 0 && Canvas.IsValid())
+	{
+		Canvas->SetVisibility(EVisibility::Collapsed);
+	}
+	CSV_CUSTOM_STAT(TPS, DamageNumbersVisible, NumActive, ECsvCustomStatOp::Set);
+}
+
+void UTPSDamageNumberSubsystem::ProjectNumbers()
+{
+	APlayerController* myPC = GetWorld()->GetFirstPlayerController();
+	ULocalPlayer* myLocalPlayer = myPC ? myPC->GetLocalPlayer() : nullptr;
+	FSceneViewProjectionData ProjectionData;
+	if (!myLocalPlayer || !myLocalPlayer->ViewportClient
+		|| !myLocalPlayer->GetProjectionData(myLocalPlayer->ViewportClient->Viewport, eSSP_FULL, ProjectionData))
+	{
+		for (FTPSDamageNumber& Number : Numbers)
+		{
+			Number.bOnScreen = false;
+		}
+		return;
+	}
+
+	//one view for all numbers, viewport pixels to Slate units
+	const FMatrix ViewProjection = ProjectionData.ComputeViewProjectionMatrix();
+	const FIntRect ViewRect = ProjectionData.GetConstrainedViewRect();
+	FVector2D ViewportSize;
+	myLocalPlayer->ViewportClient->GetViewportSize(ViewportSize);
+	const float Scale = GetDefault<UUserInterfaceSettings>()->GetDPIScaleBasedOnSize(FIntPoint(ViewportSize.X, ViewportSize.Y));
+	const float InvScale = Scale > 0.0f ? 1.0f / Scale : 1.0f;
+
+	for (FTPSDamageNumber& Number : Numbers)
+	{
+		if (!Number.bActive)
+			continue;
+
+		FVector2D Pixel;
+		Number.bOnScreen = FSceneView::ProjectWorldToScreen(Number.WorldLocation, ViewRect, ViewProjection, Pixel)
+			&& ViewRect.Contains(FIntPoint(Pixel.X, Pixel.Y));
+		Number.ScreenPosition = Pixel * InvScale;
+	}
+}
+
+FVector2D UTPSDamageNumberSubsystem::GetNumberPosition(int32 Index) const
+{
+	return Numbers.IsValidIndex(Index) ? Numbers[Index].ScreenPosition : FVector2D::ZeroVector;
+}
+
+EVisibility UTPSDamageNumberSubsystem::GetNumberVisibility(int32 Index) const
+{
+	return Numbers.IsValidIndex(Index) && Numbers[Index].bActive && Numbers[Index].bOnScreen ? EVisibility::HitTestInvisible : EVisibility::Collapsed;
+}
+
+FSlateColor UTPSDamageNumberSubsystem::GetNumberColor(int32 Index) const
+{
+	if (!Numbers.IsValidIndex(Index))
+		return FSlateColor(FLinearColor::Transparent);
+
+	//fade out during the last third of the lifetime
+	const float Lifetime = FMath::Max(DamageNumbersLifetime, KINDA_SMALL_NUMBER);
+	const float Alpha = FMath::Clamp((Lifetime - Numbers[Index].Age) / (Lifetime / 3.0f), 0.0f, 1.0f);
+	return FSlateColor(FLinearColor(1.0f, 0.85f, 0.3f, Alpha));
+}
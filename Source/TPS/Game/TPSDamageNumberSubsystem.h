@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Styling/SlateColor.h"
+#include "Layout/Visibility.h"
+#include "TPSDamageNumberSubsystem.generated.h"
+
+class SCanvas;
+class STextBlock;
+
+struct FTPSDamageNumber
+{
+	TWeakObjectPtr<AActor> Target;
+	FVector WorldLocation = FVector::ZeroVector;
+	FVector2D ScreenPosition = FVector2D::ZeroVector;
+	float Amount = 0.0f;
+	//since last merged hit
+	float Age = 0.0f;
+	bool bActive = false;
+	bool bOnScreen = false;
+};
+
+/**
+ * Floating damage numbers from health and shield loss, cosmetic only.
+ * A fixed pool of TPS.DamageNumbers.MaxVisible Slate text blocks is created once in one viewport canvas.
+ * Hits on a target whose number is younger than TPS.DamageNumbers.MergeWindow add to it, over the cap the oldest number is reused.
+ * All numbers are projected in one batch per frame with the local player's view.
+ */
+UCLASS()
+class TPS_API UTPSDamageNumberSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return NumActive > 0; }
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	//End FTickableGameObject
+
+	//Amount > 0, lost health or shield of Target
+	void AddDamage(AActor* Target, float Amount);
+
+protected:
+	bool CreateWidgets();
+	void ProjectNumbers();
+
+	FVector2D GetNumberPosition(int32 Index) const;
+	EVisibility GetNumberVisibility(int32 Index) const;
+	FSlateColor GetNumberColor(int32 Index) const;
+
+	TArray<FTPSDamageNumber> Numbers;
+	TSharedPtr<SCanvas> Canvas;
+	TArray<TSharedPtr<STextBlock>> TextBlocks;
+	int32 NumActive = 0;
+	//widgets could not be created (no game viewport), do not retry every hit
+	bool bWidgetsFailed = false;
+};
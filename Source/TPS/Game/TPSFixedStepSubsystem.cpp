@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSFixedStepSubsystem.h"
+#include "../TPS.h"
+
+float FixedStepRate = 60.0f;
+FAutoConsoleVariableRef CVARFixedStepRate{
+	TEXT("TPS.FixedStep.Rate"),
+	FixedStepRate,
+	TEXT("Gameplay steps per second for stamina, dispersion, reload and state effects, applied on next world start"),
+	ECVF_Default
+};
+
+int32 FixedStepMaxSteps = 8;
+FAutoConsoleVariableRef CVARFixedStepMaxSteps{
+	TEXT("TPS.FixedStep.MaxSteps"),
+	FixedStepMaxSteps,
+	TEXT("Steps run at most in one frame, a longer hitch slows gameplay down instead of catching up"),
+	ECVF_Default
+};
+
+void UTPSFixedStepSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	StepTime = 1.0f / FMath::Clamp(FixedStepRate, 10.0f, 240.0f);
+}
+
+void UTPSFixedStepSubsystem::Deinitialize()
+{
+	Targets.Empty();
+	FreeHandles.Empty();
+	NumTargets = 0;
+	Accumulator = 0.0f;
+	Super::Deinitialize();
+}
+
+TStatId UTPSFixedStepSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTPSFixedStepSubsystem, STATGROUP_Tickables);
+}
+
+int32 UTPSFixedStepSubsystem::Register(ITPSFixedStepTarget* Target)
+{
+	if (!Target)
+		return INDEX_NONE;
+
+	int32 Handle = INDEX_NONE;
+	if (FreeHandles.Num() > 0)
+	{
+		Handle = FreeHandles.Pop(false);
+	}
+	else
+	{
+		Handle = Targets.AddDefaulted();
+	}
+
+	Targets[Handle] = Target;
+	NumTargets++;
+	return Handle;
+}
+
+void UTPSFixedStepSubsystem::Unregister(int32& Handle)
+{
+	if (Targets.IsValidIndex(Handle) && Targets[Handle] != nullptr)
+	{
+		Targets[Handle] = nullptr;
+		FreeHandles.Add(Handle);
+		NumTargets--;
+	}
+	Handle = INDEX_NONE;
+}
+
+void UTPSFixedStepSubsystem::Tick(float DeltaTime)
+{
+	CSV_SCOPED_TIMING_STAT(TPS, FixedStep);
+
+	Accumulator += DeltaTime;
+
+	const int32 MaxSteps = FMath::Max(FixedStepMaxSteps, 1);
+	int32 Steps = 0;
+	while (Accumulator >= StepTime && Steps < MaxSteps)
+	{
+		//targets may unregister (effect ended, actor destroyed) while stepping, Num is read every pass
+		for (int32 i = 0; i < Targets.Num(); i++)
+		{
+			if (Targets[i])
+			{
+				Targets[i]->FixedStep(StepTime);
+			}
+		}
+		Accumulator -= StepTime;
+		Steps++;
+		StepCount++;
+	}
+
+	if (Accumulator >= StepTime)
+	{
+		Accumulator = FMath::Fmod(Accumulator, StepTime);
+	}
+	CSV_CUSTOM_STAT(TPS, FixedSteps, Steps, ECsvCustomStatOp::Set);
+}
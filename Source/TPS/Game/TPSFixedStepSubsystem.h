@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "TPSFixedStepSubsystem.generated.h"
+
+//Gameplay advanced on the fixed clock, plain C++ so the step loop calls it without reflection
+class TPS_API ITPSFixedStepTarget
+{
+public:
+	virtual ~ITPSFixedStepTarget() {}
+	virtual void FixedStep(float StepTime) = 0;
+};
+
+/**
+ * Fixed-step gameplay clock. Frame time goes into an accumulator and every full step of 1 / TPS.FixedStep.Rate
+ * advances all targets by the same StepTime, whatever the frame rate. At most TPS.FixedStep.MaxSteps run per frame,
+ * time past that is dropped instead of catching up. GetAlpha is the part of a step left in the accumulator,
+ * presentation interpolates between the last two steps with it.
+ */
+UCLASS()
+class TPS_API UTPSFixedStepSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return NumTargets > 0; }
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	//End FTickableGameObject
+
+	//returns handle
+	int32 Register(ITPSFixedStepTarget* Target);
+	void Unregister(int32& Handle);
+
+	float GetStepTime() const { return StepTime; }
+	//0..1, accumulated time / StepTime
+	float GetAlpha() const { return StepTime > 0.0f ? Accumulator / StepTime : 0.0f; }
+	uint32 GetStepCount() const { return StepCount; }
+
+protected:
+	TArray<ITPSFixedStepTarget*> Targets;
+	TArray<int32> FreeHandles;
+	int32 NumTargets = 0;
+
+	float StepTime = 1.0f / 60.0f;
+	float Accumulator = 0.0f;
+	uint32 StepCount = 0;
+};
@@ -3,6 +3,24 @@
 
 #include "TPSGameInstance.h"
 
+void UTPSGameInstance::Init()
+{
+	Super::Init();
+
+	for (const FSoftClassPath& EffectPath : EffectClassPaths)
+	{
+		UClass* EffectClass = EffectPath.TryLoadClass<UTPS_StateEffect>();
+		if (EffectClass)
+		{
+			EffectClasses.AddUnique(EffectClass);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("UTPSGameInstance::Init - Can't load effect class %s"), *EffectPath.ToString());
+		}
+	}
+}
+
 bool UTPSGameInstance::GetWeaponInfoByName(FName NameWeapon, FWeaponInfo& OutInfo)
 {
 	bool bIsFind = false;
@@ -34,7 +52,7 @@ bool UTPSGameInstance::GetDropItemInfoByWeaponName(FName NameItem, FDropItem& Ou
 		FDropItem* DropItemInfoRow;
 		TArray<FName>RowNames = DropItemInfoTable->GetRowNames();
 
-		int8 i = 0;
+		int32 i = 0;
 		while (i < RowNames.Num() && !bIsFind)
 		{
 			DropItemInfoRow = DropItemInfoTable->FindRow<FDropItem>(RowNames[i], "");
@@ -75,3 +93,23 @@ bool UTPSGameInstance::GetDropItemInfoByName(FName NameItem, FDropItem& OutInfo)
 
 	return bIsFind;
 }
+
+int32 UTPSGameInstance::GetEffectIdByClass(TSubclassOf<UTPS_StateEffect> EffectClass) const
+{
+	int32 Result = EffectClasses.IndexOfByKey(EffectClass);
+	if (Result == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UTPSGameInstance::GetEffectIdByClass - %s not in EffectClasses"), *GetNameSafe(EffectClass));
+	}
+	return Result;
+}
+
+TSubclassOf<UTPS_StateEffect> UTPSGameInstance::GetEffectClassById(int32 EffectId) const
+{
+	TSubclassOf<UTPS_StateEffect> Result = nullptr;
+	if (EffectClasses.IsValidIndex(EffectId))
+	{
+		Result = EffectClasses[EffectId];
+	}
+	return Result;
+}
@@ -12,7 +12,7 @@
 /**
  * 
  */
-UCLASS()
+UCLASS(config = Game)
 class TPS_API UTPSGameInstance : public UGameInstance
 {
 	GENERATED_BODY()
@@ -30,4 +30,17 @@ public:
 	bool GetDropItemInfoByWeaponName(FName NameItem, FDropItem& OutInfo);
 	UFUNCTION(BlueprintCallable)
 	bool GetDropItemInfoByName(FName NameItem, FDropItem& OutInfo);
+
+	virtual void Init() override;
+
+	//effect definitions, index is the id replicated in FTPSActiveEffectRep
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = " EffectSetting ")
+	TArray<TSubclassOf<UTPS_StateEffect>> EffectClasses;
+	//appended to EffectClasses on Init, same order on server and clients
+	UPROPERTY(Config, EditAnywhere, Category = " EffectSetting ")
+	TArray<FSoftClassPath> EffectClassPaths;
+	UFUNCTION(BlueprintCallable)
+	int32 GetEffectIdByClass(TSubclassOf<UTPS_StateEffect> EffectClass) const;
+	UFUNCTION(BlueprintCallable)
+	TSubclassOf<UTPS_StateEffect> GetEffectClassById(int32 EffectId) const;
 };
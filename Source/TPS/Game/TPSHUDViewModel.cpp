@@ -0,0 +1,242 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSHUDViewModel.h"
+#include "../Character/TPSCharacter.h"
+#include "../TPS.h"
+
+UWorld* UTPSHUDViewModel::GetWorld() const
+{
+	//outer is the player controller, CDO has none
+	return GetOuter() && !HasAnyFlags(RF_ClassDefaultObject) ? GetOuter()->GetWorld() : nullptr;
+}
+
+void UTPSHUDViewModel::BeginDestroy()
+{
+	SetCharacter(nullptr);
+	Listeners.Empty();
+	DirtyMask = 0;
+	Super::BeginDestroy();
+}
+
+TStatId UTPSHUDViewModel::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTPSHUDViewModel, STATGROUP_Tickables);
+}
+
+void UTPSHUDViewModel::SetCharacter(ATPSCharacter* NewCharacter)
+{
+	ATPSCharacter* OldCharacter = Character.Get();
+	if (OldCharacter == NewCharacter)
+		return;
+
+	if (OldCharacter)
+	{
+		if (OldCharacter->CharHealthComponent)
+		{
+			OldCharacter->CharHealthComponent->OnHealthChange.RemoveAll(this);
+			OldCharacter->CharHealthComponent->OnShieldChange.RemoveAll(this);
+		}
+		if (OldCharacter->InventoryComponent)
+		{
+			OldCharacter->InventoryComponent->OnAmmoChange.RemoveAll(this);
+			OldCharacter->InventoryComponent->OnWeaponAdditionalInfoChange.RemoveAll(this);
+		}
+		OldCharacter->OnCurrentWeaponChanged.RemoveAll(this);
+		OldCharacter->OnActiveEffectsChanged.RemoveAll(this);
+	}
+
+	Character = NewCharacter;
+	if (!NewCharacter)
+		return;
+
+	if (NewCharacter->CharHealthComponent)
+	{
+		NewCharacter->CharHealthComponent->OnHealthChange.AddUniqueDynamic(this, &UTPSHUDViewModel::HandleHealthChange);
+		NewCharacter->CharHealthComponent->OnShieldChange.AddUniqueDynamic(this, &UTPSHUDViewModel::HandleShieldChange);
+		HandleHealthChange(NewCharacter->CharHealthComponent->GetCurrentHealth(), 0.0f);
+		HandleShieldChange(NewCharacter->CharHealthComponent->GetCurrentShield(), 0.0f);
+	}
+	if (NewCharacter->InventoryComponent)
+	{
+		NewCharacter->InventoryComponent->OnAmmoChange.AddUniqueDynamic(this, &UTPSHUDViewModel::HandleAmmoChange);
+		NewCharacter->InventoryComponent->OnWeaponAdditionalInfoChange.AddUniqueDynamic(this, &UTPSHUDViewModel::HandleWeaponAdditionalInfoChange);
+	}
+	NewCharacter->OnCurrentWeaponChanged.AddUObject(this, &UTPSHUDViewModel::HandleCurrentWeaponChanged);
+	NewCharacter->OnActiveEffectsChanged.AddUObject(this, &UTPSHUDViewModel::HandleActiveEffectsChanged);
+
+	HandleCurrentWeaponChanged();
+	HandleActiveEffectsChanged();
+
+	//new pawn, listeners refresh everything even where the value happens to match
+	for (int32 i = 0; i < (int32)ETPSHUDField::Num; i++)
+	{
+		MarkDirty((ETPSHUDField)i);
+	}
+}
+
+void UTPSHUDViewModel::AddListener(UObject* Listener)
+{
+	if (!Listener || !Listener->GetClass()->ImplementsInterface(UTPSHUDListener::StaticClass()))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UTPSHUDViewModel::AddListener - %s does not implement TPSHUDListener"), *GetNameSafe(Listener));
+		return;
+	}
+	if (Listeners.ContainsByPredicate([Listener](const FListener& Elem) { return Elem.Object == Listener; }))
+		return;
+
+	FListener& myListener = Listeners.AddDefaulted_GetRef();
+	myListener.Object = Listener;
+	for (int32 i = 0; i < (int32)ETPSHUDField::Num; i++)
+	{
+		if (Revisions[i] != 0)
+			DirtyMask |= 1u << i;
+	}
+}
+
+void UTPSHUDViewModel::RemoveListener(UObject* Listener)
+{
+	Listeners.RemoveAllSwap([Listener](const FListener& Elem) { return Elem.Object == Listener; });
+}
+
+int32 UTPSHUDViewModel::GetRevision(ETPSHUDField Field) const
+{
+	return Field < ETPSHUDField::Num ? (int32)Revisions[(int32)Field] : 0;
+}
+
+void UTPSHUDViewModel::MarkDirty(ETPSHUDField Field)
+{
+	Revisions[(int32)Field]++;
+	DirtyMask |= 1u << (int32)Field;
+}
+
+void UTPSHUDViewModel::Tick(float DeltaTime)
+{
+	const uint32 myDirtyMask = DirtyMask;
+	DirtyMask = 0;
+
+	int32 NumPushed = 0;
+	for (int32 i = Listeners.Num() - 1; i >= 0; i--)
+	{
+		UObject* myObject = Listeners[i].Object.Get();
+		if (!myObject)
+		{
+			Listeners.RemoveAtSwap(i);
+			continue;
+		}
+
+		for (int32 Field = 0; Field < (int32)ETPSHUDField::Num; Field++)
+		{
+			if ((myDirtyMask & (1u << Field)) == 0 || Listeners[i].SeenRevisions[Field] == Revisions[Field])
+				continue;
+
+			Listeners[i].SeenRevisions[Field] = Revisions[Field];
+			ITPSHUDListener::Execute_OnHUDFieldChanged(myObject, this, (ETPSHUDField)Field);
+			NumPushed++;
+		}
+	}
+
+	CSV_CUSTOM_STAT(TPS, HUDFieldsPushed, NumPushed, ECsvCustomStatOp::Accumulate);
+}
+
+void UTPSHUDViewModel::HandleHealthChange(float NewHealth, float Damage)
+{
+	if (Health == NewHealth)
+		return;
+
+	Health = NewHealth;
+	MarkDirty(ETPSHUDField::Health);
+}
+
+void UTPSHUDViewModel::HandleShieldChange(float NewShield, float Damage)
+{
+	if (Shield == NewShield)
+		return;
+
+	Shield = NewShield;
+	MarkDirty(ETPSHUDField::Shield);
+}
+
+void UTPSHUDViewModel::HandleAmmoChange(EWeaponType TypeAmmo, int32 Cout)
+{
+	if (!bHasWeapon || TypeAmmo != WeaponType || Ammo == Cout)
+		return;
+
+	Ammo = Cout;
+	MarkDirty(ETPSHUDField::Ammo);
+}
+
+void UTPSHUDViewModel::HandleWeaponAdditionalInfoChange(int32 IndexSlot, FAdditionalWeaponInfo AdditionalInfo)
+{
+	if (IndexSlot != WeaponIndex || Round == AdditionalInfo.Round)
+		return;
+
+	Round = AdditionalInfo.Round;
+	MarkDirty(ETPSHUDField::Round);
+}
+
+void UTPSHUDViewModel::HandleCurrentWeaponChanged()
+{
+	ATPSCharacter* myChar = Character.Get();
+	AWeaponDefault* myWeapon = myChar ? myChar->GetCurrentWeapon() : nullptr;
+
+	const FName NewWeaponIdName = myWeapon ? myWeapon->WeaponIdName : NAME_None;
+	const int32 NewWeaponIndex = myWeapon ? myChar->CurrentIndexWeapon : INDEX_NONE;
+	const int32 NewMaxRound = myWeapon ? myWeapon->WeaponSetting.MaxRound : 0;
+	if (WeaponIdName != NewWeaponIdName || WeaponIndex != NewWeaponIndex || MaxRound != NewMaxRound)
+	{
+		WeaponIdName = NewWeaponIdName;
+		WeaponIndex = NewWeaponIndex;
+		MaxRound = NewMaxRound;
+		MarkDirty(ETPSHUDField::Weapon);
+	}
+
+	bHasWeapon = myWeapon != nullptr;
+	if (myWeapon)
+	{
+		WeaponType = myWeapon->WeaponSetting.WeaponType;
+		HandleWeaponAdditionalInfoChange(WeaponIndex, myWeapon->AdditionalWeaponInfo);
+	}
+	UpdateAmmo();
+}
+
+void UTPSHUDViewModel::HandleActiveEffectsChanged()
+{
+	ATPSCharacter* myChar = Character.Get();
+	if (!myChar)
+		return;
+
+	const TArray<FTPSActiveEffectRep>& NewEffects = myChar->ActiveEffects;
+	bool bIsSame = NewEffects.Num() == ActiveEffects.Num();
+	for (int32 i = 0; bIsSame && i < NewEffects.Num(); i++)
+	{
+		bIsSame = NewEffects[i].InstanceId == ActiveEffects[i].InstanceId && NewEffects[i].ExpireTime == ActiveEffects[i].ExpireTime;
+	}
+	if (bIsSame)
+		return;
+
+	ActiveEffects = NewEffects;
+	MarkDirty(ETPSHUDField::Effects);
+}
+
+void UTPSHUDViewModel::UpdateAmmo()
+{
+	ATPSCharacter* myChar = Character.Get();
+	int32 NewAmmo = 0;
+	if (bHasWeapon && myChar && myChar->InventoryComponent)
+	{
+		for (const FAmmoSlot& Slot : myChar->InventoryComponent->AmmoSlots)
+		{
+			if (Slot.WeaponType == WeaponType)
+			{
+				NewAmmo = Slot.Cout;
+				break;
+			}
+		}
+	}
+	if (Ammo == NewAmmo)
+		return;
+
+	Ammo = NewAmmo;
+	MarkDirty(ETPSHUDField::Ammo);
+}
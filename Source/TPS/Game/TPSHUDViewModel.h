@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "Tickable.h"
+#include "../FuncLibrary/Types.h"
+#include "TPSHUDViewModel.generated.h"
+
+class ATPSCharacter;
+class UTPSHUDViewModel;
+
+UENUM(BlueprintType)
+enum class ETPSHUDField : uint8
+{
+	//WeaponIdName, WeaponIndex, MaxRound
+	Weapon,
+	Round,
+	//inventory ammo of the current weapon type
+	Ammo,
+	Health,
+	Shield,
+	Effects,
+
+	Num UMETA(Hidden)
+};
+
+UINTERFACE(Blueprintable)
+class UTPSHUDListener : public UInterface
+{
+	GENERATED_BODY()
+};
+
+//HUD widget, told about changed fields once per frame
+class TPS_API ITPSHUDListener
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintNativeEvent, Category = "HUD")
+	void OnHUDFieldChanged(UTPSHUDViewModel* ViewModel, ETPSHUDField Field);
+};
+
+/**
+ * HUD state of the local player's character, owned by ATPSPlayerController.
+ * Inventory, health and effect events write fields, a changed value bumps the field revision.
+ * At end of frame listeners get OnHUDFieldChanged for every field whose revision they have not seen yet;
+ * with nothing changed the view-model does not tick.
+ */
+UCLASS(BlueprintType)
+class TPS_API UTPSHUDViewModel : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual UWorld* GetWorld() const override;
+	virtual void BeginDestroy() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return DirtyMask != 0; }
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	//End FTickableGameObject
+
+	//nullptr - unbind, fields keep last values
+	void SetCharacter(ATPSCharacter* NewCharacter);
+
+	//Listener implements ITPSHUDListener, gets every field on next flush
+	UFUNCTION(BlueprintCallable, Category = "HUD")
+	void AddListener(UObject* Listener);
+	UFUNCTION(BlueprintCallable, Category = "HUD")
+	void RemoveListener(UObject* Listener);
+
+	UFUNCTION(BlueprintPure, Category = "HUD")
+	int32 GetRevision(ETPSHUDField Field) const;
+
+	UPROPERTY(BlueprintReadOnly, Category = "HUD")
+	FName WeaponIdName;
+	UPROPERTY(BlueprintReadOnly, Category = "HUD")
+	int32 WeaponIndex = INDEX_NONE;
+	UPROPERTY(BlueprintReadOnly, Category = "HUD")
+	int32 MaxRound = 0;
+	UPROPERTY(BlueprintReadOnly, Category = "HUD")
+	int32 Round = 0;
+	UPROPERTY(BlueprintReadOnly, Category = "HUD")
+	int32 Ammo = 0;
+	UPROPERTY(BlueprintReadOnly, Category = "HUD")
+	float Health = 0.0f;
+	UPROPERTY(BlueprintReadOnly, Category = "HUD")
+	float Shield = 0.0f;
+	UPROPERTY(BlueprintReadOnly, Category = "HUD")
+	TArray<FTPSActiveEffectRep> ActiveEffects;
+
+protected:
+	UFUNCTION()
+	void HandleHealthChange(float NewHealth, float Damage);
+	UFUNCTION()
+	void HandleShieldChange(float NewShield, float Damage);
+	UFUNCTION()
+	void HandleAmmoChange(EWeaponType TypeAmmo, int32 Cout);
+	UFUNCTION()
+	void HandleWeaponAdditionalInfoChange(int32 IndexSlot, FAdditionalWeaponInfo AdditionalInfo);
+	void HandleCurrentWeaponChanged();
+	void HandleActiveEffectsChanged();
+
+	void UpdateAmmo();
+	void MarkDirty(ETPSHUDField Field);
+
+	struct FListener
+	{
+		TWeakObjectPtr<UObject> Object;
+		uint32 SeenRevisions[(int32)ETPSHUDField::Num] = {};
+	};
+
+	TWeakObjectPtr<ATPSCharacter> Character;
+	EWeaponType WeaponType = EWeaponType::RifleType;
+	bool bHasWeapon = false;
+
+	//start at 1, a new listener has seen 0
+	uint32 Revisions[(int32)ETPSHUDField::Num] = {};
+	uint32 DirtyMask = 0;
+	TArray<FListener> Listeners;
+};
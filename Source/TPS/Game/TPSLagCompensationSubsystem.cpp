@@ -0,0 +1,356 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSLagCompensationSubsystem.h"
+#include "../Character/TPSCharacter.h"
+#include "../TPS.h"
+#include "Components/CapsuleComponent.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Engine/World.h"
+
+int32 LagCompEnable = 1;
+FAutoConsoleVariableRef CVARLagCompEnable{
+	TEXT("TPS.LagComp.Enable"),
+	LagCompEnable,
+	TEXT("Rewind characters for hitscan shots of remote clients"),
+	ECVF_Default
+};
+
+float LagCompMaxRewindMs = 250.0f;
+FAutoConsoleVariableRef CVARLagCompMaxRewindMs{
+	TEXT("TPS.LagComp.MaxRewindMs"),
+	LagCompMaxRewindMs,
+	TEXT("Oldest client time the server accepts, ms"),
+	ECVF_Default
+};
+
+int32 LagCompHistoryFrames = 32;
+FAutoConsoleVariableRef CVARLagCompHistoryFrames{
+	TEXT("TPS.LagComp.HistoryFrames"),
+	LagCompHistoryFrames,
+	TEXT("Frames kept per character, applied on next character register"),
+	ECVF_Default
+};
+
+int32 LagCompMaxBoxes = 16;
+FAutoConsoleVariableRef CVARLagCompMaxBoxes{
+	TEXT("TPS.LagComp.MaxBoxes"),
+	LagCompMaxBoxes,
+	TEXT("Capsule plus physics bodies recorded per character"),
+	ECVF_Default
+};
+
+float LagCompRecordHz = 60.0f;
+FAutoConsoleVariableRef CVARLagCompRecordHz{
+	TEXT("TPS.LagComp.RecordHz"),
+	LagCompRecordHz,
+	TEXT("Max history records per second, 0 - every tick"),
+	ECVF_Default
+};
+
+int32 LagCompMaxMemoryKB = 4096;
+FAutoConsoleVariableRef CVARLagCompMaxMemoryKB{
+	TEXT("TPS.LagComp.MaxMemoryKB"),
+	LagCompMaxMemoryKB,
+	TEXT("History memory cap for all characters, new characters get shorter history when reached"),
+	ECVF_Default
+};
+
+void UTPSLagCompensationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	bIsInitialized = true;
+}
+
+void UTPSLagCompensationSubsystem::Deinitialize()
+{
+	bIsInitialized = false;
+	Histories.Empty();
+	Super::Deinitialize();
+}
+
+bool UTPSLagCompensationSubsystem::IsEnabled() const
+{
+	return LagCompEnable != 0;
+}
+
+bool UTPSLagCompensationSubsystem::IsTickable() const
+{
+	const UWorld* myWorld = GetWorld();
+	return bIsInitialized && IsEnabled() && myWorld && myWorld->IsGameWorld()
+		&& (myWorld->GetNetMode() == NM_DedicatedServer || myWorld->GetNetMode() == NM_ListenServer);
+}
+
+TStatId UTPSLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTPSLagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+void UTPSLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	CSV_SCOPED_TIMING_STAT(TPS, LagCompRecord);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (LagCompRecordHz > 0.0f && LastRecordTime >= 0.0f && Now - LastRecordTime < 1.0f / LagCompRecordHz)
+		return;
+	LastRecordTime = Now;
+
+	for (int32 i = Histories.Num() - 1; i >= 0; i--)
+	{
+		if (!Histories[i].Character.IsValid())
+		{
+			Histories.RemoveAtSwap(i);
+			continue;
+		}
+		RecordFrame(Histories[i], Now);
+	}
+}
+
+void UTPSLagCompensationSubsystem::RegisterCharacter(ATPSCharacter* Character)
+{
+	if (!Character || Histories.ContainsByPredicate([Character](const FTPSHitboxHistory& Elem) { return Elem.Character == Character; }))
+		return;
+
+	FTPSHitboxHistory& History = Histories.AddDefaulted_GetRef();
+	History.Character = Character;
+
+	const int32 MaxBoxes = FMath::Max(LagCompMaxBoxes, 1);
+	UCapsuleComponent* myCapsule = Character->GetCapsuleComponent();
+	const float Radius = myCapsule ? myCapsule->GetUnscaledCapsuleRadius() : 42.0f;
+	const float HalfHeight = myCapsule ? myCapsule->GetUnscaledCapsuleHalfHeight() : 96.0f;
+	History.BoneNames.Add(NAME_None);
+	History.LocalBoxes.Add(FBox(FVector(-Radius, -Radius, -HalfHeight), FVector(Radius, Radius, HalfHeight)));
+
+	USkeletalMeshComponent* myMesh = Character->GetMesh();
+	UPhysicsAsset* myPhysicsAsset = myMesh ? myMesh->GetPhysicsAsset() : nullptr;
+	if (myPhysicsAsset)
+	{
+		for (USkeletalBodySetup* BodySetup : myPhysicsAsset->SkeletalBodySetups)
+		{
+			if (History.LocalBoxes.Num() >= MaxBoxes)
+				break;
+			if (!BodySetup || myMesh->GetBoneIndex(BodySetup->BoneName) == INDEX_NONE)
+				continue;
+
+			History.BoneNames.Add(BodySetup->BoneName);
+			History.LocalBoxes.Add(BodySetup->AggGeom.CalcAABB(FTransform::Identity));
+		}
+	}
+
+	//shorter history instead of going over the cap
+	const int32 FrameBytes = sizeof(float) + sizeof(FSphere) + History.GetNumBoxes() * sizeof(FTransform);
+	const int32 FreeBytes = FMath::Max(0, LagCompMaxMemoryKB * 1024 - FMath::RoundToInt(GetMemoryUsageKB() * 1024.0f));
+	const int32 HistorySize = FMath::Clamp(FreeBytes / FrameBytes, 2, FMath::Max(LagCompHistoryFrames, 2));
+
+	History.FrameTimes.SetNumZeroed(HistorySize);
+	History.FrameBounds.SetNumZeroed(HistorySize);
+	History.FrameBoxes.SetNum(HistorySize * History.GetNumBoxes());
+}
+
+void UTPSLagCompensationSubsystem::UnregisterCharacter(ATPSCharacter* Character)
+{
+	const int32 Index = Histories.IndexOfByPredicate([Character](const FTPSHitboxHistory& Elem) { return Elem.Character == Character; });
+	if (Index != INDEX_NONE)
+	{
+		Histories.RemoveAtSwap(Index);
+	}
+}
+
+void UTPSLagCompensationSubsystem::GetCompensatedActors(TArray<AActor*>& OutActors) const
+{
+	for (const FTPSHitboxHistory& History : Histories)
+	{
+		if (History.Character.IsValid())
+			OutActors.Add(History.Character.Get());
+	}
+}
+
+float UTPSLagCompensationSubsystem::GetMemoryUsageKB() const
+{
+	int32 Bytes = 0;
+	for (const FTPSHitboxHistory& History : Histories)
+	{
+		Bytes += History.FrameTimes.GetAllocatedSize() + History.FrameBounds.GetAllocatedSize() + History.FrameBoxes.GetAllocatedSize();
+	}
+	return Bytes / 1024.0f;
+}
+
+void UTPSLagCompensationSubsystem::RecordFrame(FTPSHitboxHistory& History, float Now)
+{
+	ATPSCharacter* myChar = History.Character.Get();
+	USkeletalMeshComponent* myMesh = myChar->GetMesh();
+	UCapsuleComponent* myCapsule = myChar->GetCapsuleComponent();
+	if (!myMesh || !myCapsule)
+		return;
+
+	History.Head = (History.Head + 1) % History.GetHistorySize();
+	History.NumFrames = FMath::Min(History.NumFrames + 1, History.GetHistorySize());
+	History.FrameTimes[History.Head] = Now;
+
+	FSphere Bounds(myCapsule->GetComponentLocation(), myCapsule->GetScaledCapsuleHalfHeight());
+	Bounds += myMesh->Bounds.GetSphere();
+	History.FrameBounds[History.Head] = Bounds;
+
+	FTransform* Boxes = &History.FrameBoxes[History.Head * History.GetNumBoxes()];
+	Boxes[0] = myCapsule->GetComponentTransform();
+	for (int32 i = 1; i < History.GetNumBoxes(); i++)
+	{
+		Boxes[i] = myMesh->GetSocketTransform(History.BoneNames[i]);
+	}
+}
+
+//segment Start + (End - Start) * t, t in [0,1], against Box in Transform space
+static bool TPSSegmentBoxIntersect(const FTransform& Transform, const FBox& Box, const FVector& Start, const FVector& End, float& OutTime, FVector& OutNormal)
+{
+	const FVector LocalStart = Transform.InverseTransformPosition(Start);
+	const FVector LocalDir = Transform.InverseTransformPosition(End) - LocalStart;
+
+	float TimeMin = 0.0f;
+	float TimeMax = 1.0f;
+	int32 HitAxis = INDEX_NONE;
+	float HitSign = 1.0f;
+	for (int32 Axis = 0; Axis < 3; Axis++)
+	{
+		if (FMath::Abs(LocalDir[Axis]) < KINDA_SMALL_NUMBER)
+		{
+			if (LocalStart[Axis] < Box.Min[Axis] || LocalStart[Axis] > Box.Max[Axis])
+				return false;
+			continue;
+		}
+
+		const float InvDir = 1.0f / LocalDir[Axis];
+		float TimeNear = (Box.Min[Axis] - LocalStart[Axis]) * InvDir;
+		float TimeFar = (Box.Max[Axis] - LocalStart[Axis]) * InvDir;
+		float Sign = -1.0f;
+		if (TimeNear > TimeFar)
+		{
+			Swap(TimeNear, TimeFar);
+			Sign = 1.0f;
+		}
+		if (TimeNear > TimeMin)
+		{
+			TimeMin = TimeNear;
+			HitAxis = Axis;
+			HitSign = Sign;
+		}
+		TimeMax = FMath::Min(TimeMax, TimeFar);
+		if (TimeMin > TimeMax)
+			return false;
+	}
+
+	OutTime = TimeMin;
+	FVector LocalNormal = -LocalDir.GetSafeNormal();
+	if (HitAxis != INDEX_NONE)
+	{
+		LocalNormal = FVector::ZeroVector;
+		LocalNormal[HitAxis] = HitSign;
+	}
+	OutNormal = Transform.TransformVectorNoScale(LocalNormal).GetSafeNormal();
+	return true;
+}
+
+bool UTPSLagCompensationSubsystem::TraceHistory(const FTPSHitboxHistory& History, const FVector& Start, const FVector& End, float Timestamp, float& InOutTime, FHitResult& OutHit) const
+{
+	if (History.NumFrames == 0)
+		return false;
+
+	//newest frame not newer than Timestamp and the one after it
+	const int32 Size = History.GetHistorySize();
+	int32 Older = History.Head;
+	int32 Newer = History.Head;
+	for (int32 k = 0; k < History.NumFrames; k++)
+	{
+		Older = (History.Head - k + Size) % Size;
+		if (History.FrameTimes[Older] <= Timestamp)
+			break;
+		Newer = Older;
+	}
+
+	float Alpha = 0.0f;
+	const float Span = History.FrameTimes[Newer] - History.FrameTimes[Older];
+	if (Span > KINDA_SMALL_NUMBER)
+	{
+		Alpha = FMath::Clamp((Timestamp - History.FrameTimes[Older]) / Span, 0.0f, 1.0f);
+	}
+
+	//broad phase on bounds, most characters stop here
+	const FSphere& OlderBounds = History.FrameBounds[Older];
+	const FSphere& NewerBounds = History.FrameBounds[Newer];
+	const FVector BoundsCenter = FMath::Lerp(OlderBounds.Center, NewerBounds.Center, Alpha);
+	const float BoundsRadius = FMath::Max(OlderBounds.W, NewerBounds.W);
+	if (FMath::PointDistToSegmentSquared(BoundsCenter, Start, End) > FMath::Square(BoundsRadius))
+		return false;
+
+	const int32 NumBoxes = History.GetNumBoxes();
+	const FTransform* OlderBoxes = &History.FrameBoxes[Older * NumBoxes];
+	const FTransform* NewerBoxes = &History.FrameBoxes[Newer * NumBoxes];
+
+	//capsule first, bones only when capsule is hit
+	int32 HitBox = INDEX_NONE;
+	float HitTime = InOutTime;
+	FVector HitNormal = FVector::ZeroVector;
+	for (int32 i = 0; i < NumBoxes; i++)
+	{
+		FTransform BoxTransform;
+		BoxTransform.Blend(OlderBoxes[i], NewerBoxes[i], Alpha);
+
+		float Time = 0.0f;
+		FVector Normal;
+		if (!TPSSegmentBoxIntersect(BoxTransform, History.LocalBoxes[i], Start, End, Time, Normal))
+		{
+			if (i == 0)
+				return false;
+			continue;
+		}
+		//capsule hit alone is enough when there are no bone boxes
+		if ((i > 0 || NumBoxes == 1) && Time < HitTime)
+		{
+			HitTime = Time;
+			HitBox = i;
+			HitNormal = Normal;
+		}
+	}
+
+	if (HitBox == INDEX_NONE)
+		return false;
+
+	ATPSCharacter* myChar = History.Character.Get();
+	InOutTime = HitTime;
+
+	OutHit = FHitResult(myChar, HitBox == 0 ? (UPrimitiveComponent*)myChar->GetCapsuleComponent() : (UPrimitiveComponent*)myChar->GetMesh(), Start + (End - Start) * HitTime, HitNormal);
+	OutHit.bBlockingHit = true;
+	OutHit.Time = HitTime;
+	OutHit.Distance = (End - Start).Size() * HitTime;
+	OutHit.TraceStart = Start;
+	OutHit.TraceEnd = End;
+	OutHit.BoneName = History.BoneNames[HitBox];
+	if (myChar->GetMesh())
+	{
+		UMaterialInterface* myMaterial = myChar->GetMesh()->GetMaterial(0);
+		if (myMaterial)
+			OutHit.PhysMaterial = myMaterial->GetPhysicalMaterial();
+	}
+	return true;
+}
+
+bool UTPSLagCompensationSubsystem::RewindLineTrace(const FVector& Start, const FVector& End, float Timestamp, const AActor* IgnoredActor, FHitResult& OutHit) const
+{
+	CSV_SCOPED_TIMING_STAT(TPS, LagCompRewind);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float RewindTime = FMath::Clamp(Timestamp, Now - LagCompMaxRewindMs / 1000.0f, Now);
+
+	bool bIsHit = false;
+	float NearestTime = 1.0f;
+	for (const FTPSHitboxHistory& History : Histories)
+	{
+		if (!History.Character.IsValid() || History.Character.Get() == IgnoredActor)
+			continue;
+
+		if (TraceHistory(History, Start, End, RewindTime, NearestTime, OutHit))
+			bIsHit = true;
+	}
+	return bIsHit;
+}
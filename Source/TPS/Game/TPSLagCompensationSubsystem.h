@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "TPSLagCompensationSubsystem.generated.h"
+
+class ATPSCharacter;
+
+//Hitbox history of one character, ring buffer of NumBoxes transforms per frame
+struct FTPSHitboxHistory
+{
+	TWeakObjectPtr<ATPSCharacter> Character;
+
+	//box 0 - capsule, others - physics asset bodies
+	TArray<FName> BoneNames;
+	TArray<FBox> LocalBoxes;
+
+	TArray<float> FrameTimes;
+	TArray<FSphere> FrameBounds;
+	TArray<FTransform> FrameBoxes;
+
+	int32 Head = INDEX_NONE;
+	int32 NumFrames = 0;
+
+	int32 GetNumBoxes() const { return LocalBoxes.Num(); }
+	int32 GetHistorySize() const { return FrameTimes.Num(); }
+};
+
+/**
+ * Server side lag compensation for hitscan weapons.
+ * Records capsule and bone boxes of every ATPSCharacter each server tick and
+ * traces rays against the boxes rewound to the shooter's time.
+ * TPS.LagComp.* console variables set the rewind window and memory per character.
+ */
+UCLASS()
+class TPS_API UTPSLagCompensationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	//End FTickableGameObject
+
+	bool IsEnabled() const;
+
+	void RegisterCharacter(ATPSCharacter* Character);
+	void UnregisterCharacter(ATPSCharacter* Character);
+
+	//characters to ignore in world trace, they are tested rewound instead
+	void GetCompensatedActors(TArray<AActor*>& OutActors) const;
+
+	//nearest rewound character hit on segment, Timestamp in server world time
+	bool RewindLineTrace(const FVector& Start, const FVector& End, float Timestamp, const AActor* IgnoredActor, FHitResult& OutHit) const;
+
+	float GetMemoryUsageKB() const;
+
+protected:
+	void RecordFrame(FTPSHitboxHistory& History, float Now);
+	bool TraceHistory(const FTPSHitboxHistory& History, const FVector& Start, const FVector& End, float Timestamp, float& InOutTime, FHitResult& OutHit) const;
+
+	TArray<FTPSHitboxHistory> Histories;
+	float LastRecordTime = -1.0f;
+	bool bIsInitialized = false;
+};
@@ -0,0 +1,249 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSPathSubsystem.h"
+#include "../TPS.h"
+#include "GameFramework/Controller.h"
+#include "NavigationData.h"
+
+int32 PathCacheSize = 16;
+FAutoConsoleVariableRef CVARPathCacheSize{
+	TEXT("TPS.Path.CacheSize"),
+	PathCacheSize,
+	TEXT("Recent click-to-move paths kept per world, 0 - no cache"),
+	ECVF_Default
+};
+
+float PathCacheGrid = 50.0f;
+FAutoConsoleVariableRef CVARPathCacheGrid{
+	TEXT("TPS.Path.CacheGrid"),
+	PathCacheGrid,
+	TEXT("Start and goal are quantized to this many units for the path cache key"),
+	ECVF_Default
+};
+
+float PathCacheLifetime = 5.0f;
+FAutoConsoleVariableRef CVARPathCacheLifetime{
+	TEXT("TPS.Path.CacheLifetime"),
+	PathCacheLifetime,
+	TEXT("Seconds a cached path is reused, paths invalidated by a navmesh rebuild are never reused"),
+	ECVF_Default
+};
+
+static const float PartialPathMinLength = 50.0f;
+
+void UTPSPathSubsystem::Deinitialize()
+{
+	UNavigationSystemV1* myNavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	for (const FPathRequest& Request : Requests)
+	{
+		if (myNavSys && Request.QueryId != INVALID_NAVQUERYID)
+		{
+			myNavSys->AbortAsyncFindPathRequest(Request.QueryId);
+		}
+	}
+	Requests.Empty();
+	Cache.Empty();
+	Super::Deinitialize();
+}
+
+FIntVector UTPSPathSubsystem::GetKey(const FVector& Location) const
+{
+	const float Grid = FMath::Max(PathCacheGrid, 1.0f);
+	return FIntVector(FMath::FloorToInt(Location.X / Grid), FMath::FloorToInt(Location.Y / Grid), FMath::FloorToInt(Location.Z / Grid));
+}
+
+FNavPathSharedPtr UTPSPathSubsystem::FindCached(const FIntVector& StartKey, const FIntVector& GoalKey) const
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	for (const FCachedPath& Entry : Cache)
+	{
+		if (Entry.StartKey == StartKey && Entry.GoalKey == GoalKey && Now - Entry.Time <= PathCacheLifetime
+			&& Entry.Path.IsValid() && Entry.Path->IsValid())
+		{
+			return Entry.Path;
+		}
+	}
+	return nullptr;
+}
+
+void UTPSPathSubsystem::AddCached(const FIntVector& StartKey, const FIntVector& GoalKey, FNavPathSharedPtr Path)
+{
+	if (PathCacheSize <= 0)
+		return;
+
+	//same keys or the oldest entry when full
+	int32 Index = Cache.IndexOfByPredicate([&StartKey, &GoalKey](const FCachedPath& Elem) { return Elem.StartKey == StartKey && Elem.GoalKey == GoalKey; });
+	if (Index == INDEX_NONE)
+	{
+		if (Cache.Num() < PathCacheSize)
+		{
+			Index = Cache.AddDefaulted();
+		}
+		else
+		{
+			Index = 0;
+			for (int32 i = 1; i < Cache.Num(); i++)
+			{
+				if (Cache[i].Time < Cache[Index].Time)
+					Index = i;
+			}
+		}
+	}
+
+	FCachedPath& myEntry = Cache[Index];
+	myEntry.StartKey = StartKey;
+	myEntry.GoalKey = GoalKey;
+	myEntry.Path = Path;
+	myEntry.Time = GetWorld()->GetTimeSeconds();
+}
+
+bool UTPSPathSubsystem::RequestPath(AController* Requester, const FVector& Start, const FVector& Goal, FTPSPathReadyDelegate Callback)
+{
+	if (!Requester)
+		return false;
+
+	CSV_CUSTOM_STAT(TPS, PathRequests, 1, ECsvCustomStatOp::Accumulate);
+
+	FPathRequest* myRequest = Requests.FindByPredicate([Requester](const FPathRequest& Elem) { return Elem.Requester == Requester; });
+	if (!myRequest)
+	{
+		myRequest = &Requests.AddDefaulted_GetRef();
+		myRequest->Requester = Requester;
+	}
+	myRequest->Callback = Callback;
+
+	FNavPathSharedPtr myCached = FindCached(GetKey(Start), GetKey(Goal));
+	if (myCached.IsValid())
+	{
+		CSV_CUSTOM_STAT(TPS, PathCacheHits, 1, ECsvCustomStatOp::Accumulate);
+		//a query still in flight is older than this answer
+		myRequest->bDeliver = false;
+		myRequest->bHasPending = false;
+		Callback.ExecuteIfBound(myCached);
+		return true;
+	}
+
+	if (myRequest->QueryId != INVALID_NAVQUERYID)
+	{
+		CSV_CUSTOM_STAT(TPS, PathCoalesced, 1, ECsvCustomStatOp::Accumulate);
+		myRequest->bHasPending = true;
+		myRequest->PendingStart = Start;
+		myRequest->PendingGoal = Goal;
+		return false;
+	}
+
+	if (!StartQuery(*myRequest, Start, Goal))
+	{
+		Callback.ExecuteIfBound(nullptr);
+	}
+	return false;
+}
+
+bool UTPSPathSubsystem::StartQuery(FPathRequest& Request, const FVector& Start, const FVector& Goal)
+{
+	UNavigationSystemV1* myNavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	AController* myRequester = Request.Requester.Get();
+	if (!myNavSys || !myRequester)
+		return false;
+
+	const FNavAgentProperties& myAgent = myRequester->GetNavAgentPropertiesRef();
+	const ANavigationData* myNavData = myNavSys->GetNavDataForProps(myAgent);
+	if (!myNavData)
+		return false;
+
+	FPathFindingQuery Query(myRequester, *myNavData, Start, Goal);
+	Query.SetAllowPartialPaths(true);
+
+	Request.StartKey = GetKey(Start);
+	Request.GoalKey = GetKey(Goal);
+	Request.bDeliver = true;
+	Request.QueryId = myNavSys->FindPathAsync(myAgent, Query, FNavPathQueryDelegate::CreateUObject(this, &UTPSPathSubsystem::OnPathFound));
+	CSV_CUSTOM_STAT(TPS, PathQueries, 1, ECsvCustomStatOp::Accumulate);
+	return Request.QueryId != INVALID_NAVQUERYID;
+}
+
+void UTPSPathSubsystem::OnPathFound(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	const int32 Index = Requests.IndexOfByPredicate([QueryId](const FPathRequest& Elem) { return Elem.QueryId == QueryId; });
+	if (Index == INDEX_NONE)
+		return;
+
+	FPathRequest& myRequest = Requests[Index];
+	myRequest.QueryId = INVALID_NAVQUERYID;
+
+	const bool bFound = Result == ENavigationQueryResult::Success && Path.IsValid() && Path->IsValid();
+	if (bFound && !Path->IsPartial())
+	{
+		AddCached(myRequest.StartKey, myRequest.GoalKey, Path);
+	}
+
+	//copy, the callback or the next query may change Requests
+	FTPSPathReadyDelegate myCallback = myRequest.Callback;
+	const bool bDeliver = myRequest.bDeliver;
+	if (myRequest.bHasPending && myRequest.Requester.IsValid())
+	{
+		myRequest.bHasPending = false;
+		const FVector myStart = myRequest.PendingStart;
+		const FVector myGoal = myRequest.PendingGoal;
+		FNavPathSharedPtr myCached = FindCached(GetKey(myStart), GetKey(myGoal));
+		if (myCached.IsValid())
+		{
+			CSV_CUSTOM_STAT(TPS, PathCacheHits, 1, ECsvCustomStatOp::Accumulate);
+			//nothing in flight anymore, a stale request would block the next one
+			Requests.RemoveAtSwap(Index);
+			myCallback.ExecuteIfBound(myCached);
+			return;
+		}
+		StartQuery(myRequest, myStart, myGoal);
+	}
+	else
+	{
+		Requests.RemoveAtSwap(Index);
+	}
+
+	//newest finished path while the next one is searched
+	if (bDeliver)
+	{
+		myCallback.ExecuteIfBound(bFound ? Path : nullptr);
+	}
+}
+
+void UTPSPathSubsystem::CancelRequests(const AController* Requester)
+{
+	UNavigationSystemV1* myNavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	for (int32 i = Requests.Num() - 1; i >= 0; i--)
+	{
+		if (Requests[i].Requester != Requester && Requests[i].Requester.IsValid())
+			continue;
+
+		if (myNavSys && Requests[i].QueryId != INVALID_NAVQUERYID)
+		{
+			myNavSys->AbortAsyncFindPathRequest(Requests[i].QueryId);
+		}
+		Requests.RemoveAtSwap(i);
+	}
+}
+
+FNavPathSharedPtr UTPSPathSubsystem::MakePartialPath(AController* Requester, const FVector& Start, const FVector& Goal) const
+{
+	UNavigationSystemV1* myNavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* myNavData = myNavSys && Requester ? myNavSys->GetNavDataForProps(Requester->GetNavAgentPropertiesRef()) : nullptr;
+	if (!myNavData)
+		return nullptr;
+
+	//navmesh raycast is a walk over a few polygons, no search
+	FVector HitLocation = Goal;
+	myNavData->Raycast(Start, Goal, HitLocation, nullptr);
+	if (FVector::DistSquared2D(Start, HitLocation) < FMath::Square(PartialPathMinLength))
+		return nullptr;
+
+	TArray<FVector> Points;
+	Points.Add(Start);
+	Points.Add(HitLocation);
+	FNavPathSharedPtr Path = MakeShareable(new FNavigationPath(Points));
+	Path->SetNavigationDataUsed(const_cast<ANavigationData*>(myNavData));
+	Path->SetIsPartial(true);
+	Path->MarkReady();
+	return Path;
+}
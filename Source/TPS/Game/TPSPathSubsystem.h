@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NavigationSystem.h"
+#include "TPSPathSubsystem.generated.h"
+
+class AController;
+
+//nullptr Path - no path found
+DECLARE_DELEGATE_OneParam(FTPSPathReadyDelegate, FNavPathSharedPtr /*Path*/);
+
+/**
+ * Click-to-move paths found asynchronously by the navigation system, never on the game thread.
+ * One query per requester is in flight, requests made meanwhile only replace the pending start and goal,
+ * the newest one is sent when the query returns. Full paths go into a TPS.Path.CacheSize cache keyed by
+ * start and goal quantized to TPS.Path.CacheGrid, a click near the same spots reuses a path without a query.
+ */
+UCLASS()
+class TPS_API UTPSPathSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//Callback runs at once on a cache hit (returns true), else on a later frame with the newest request's path
+	bool RequestPath(AController* Requester, const FVector& Start, const FVector& Goal, FTPSPathReadyDelegate Callback);
+	void CancelRequests(const AController* Requester);
+
+	//straight reachable navmesh segment from Start towards Goal, to follow until the full path is found
+	FNavPathSharedPtr MakePartialPath(AController* Requester, const FVector& Start, const FVector& Goal) const;
+
+protected:
+	struct FCachedPath
+	{
+		FIntVector StartKey;
+		FIntVector GoalKey;
+		FNavPathSharedPtr Path;
+		float Time = 0.0f;
+	};
+
+	struct FPathRequest
+	{
+		TWeakObjectPtr<AController> Requester;
+		FTPSPathReadyDelegate Callback;
+		uint32 QueryId = INVALID_NAVQUERYID;
+		FIntVector StartKey;
+		FIntVector GoalKey;
+		//false when a newer request was answered from cache, the result is only cached
+		bool bDeliver = true;
+		bool bHasPending = false;
+		FVector PendingStart = FVector::ZeroVector;
+		FVector PendingGoal = FVector::ZeroVector;
+	};
+
+	FIntVector GetKey(const FVector& Location) const;
+	FNavPathSharedPtr FindCached(const FIntVector& StartKey, const FIntVector& GoalKey) const;
+	void AddCached(const FIntVector& StartKey, const FIntVector& GoalKey, FNavPathSharedPtr Path);
+	bool StartQuery(FPathRequest& Request, const FVector& Start, const FVector& Goal);
+	void OnPathFound(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+	TArray<FCachedPath> Cache;
+	TArray<FPathRequest> Requests;
+};
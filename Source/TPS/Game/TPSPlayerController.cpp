@@ -1,11 +1,13 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "TPSPlayerController.h"
-#include "Blueprint/AIBlueprintHelperLibrary.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "TPSPathSubsystem.h"
 #include "Runtime/Engine/Classes/Components/DecalComponent.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
 #include "../Character/TPSCharacter.h"
 #include "Engine/World.h"
+#include "Misc/CommandLine.h"
 
 ATPSPlayerController::ATPSPlayerController()
 {
@@ -13,15 +15,55 @@ ATPSPlayerController::ATPSPlayerController()
 	DefaultMouseCursor = EMouseCursor::Crosshairs;
 }
 
+void ATPSPlayerController::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (IsLocalController() && FParse::Param(FCommandLine::Get(), TEXT("TPSBot")))
+	{
+		int32 Seed = FPlatformProcess::GetCurrentProcessId();
+		FParse::Value(FCommandLine::Get(), TEXT("TPSBotSeed="), Seed);
+		BotScript.Init(Seed);
+		bIsBot = true;
+		UE_LOG(LogTemp, Display, TEXT("ATPSPlayerController::BeginPlay - bot client, seed %d"), Seed);
+	}
+}
+
 void ATPSPlayerController::PlayerTick(float DeltaTime)
 {
 	Super::PlayerTick(DeltaTime);
 
-	// keep updating the destination every tick while desired
-	//if (bMoveToMouseCursor)
-	//{
-	//	MoveToMouseCursor();
-	//}
+	if (bIsBot)
+	{
+		BotScript.Tick(Cast<ATPSCharacter>(GetPawn()), DeltaTime);
+	}
+
+	// keep updating the destination every tick while desired, requests coalesce in UTPSPathSubsystem
+	if (bMoveToMouseCursor)
+	{
+		MoveToMouseCursor();
+	}
+}
+
+UTPSHUDViewModel* ATPSPlayerController::GetHUDViewModel()
+{
+	if (!HUDViewModel && IsLocalController())
+	{
+		HUDViewModel = NewObject<UTPSHUDViewModel>(this);
+		HUDViewModel->SetCharacter(Cast<ATPSCharacter>(GetPawn()));
+	}
+	return HUDViewModel;
+}
+
+void ATPSPlayerController::SetPawn(APawn* InPawn)
+{
+	Super::SetPawn(InPawn);
+
+	//possess and unpossess, controllers of remote players have no view-model
+	if (HUDViewModel || IsLocalController())
+	{
+		GetHUDViewModel()->SetCharacter(Cast<ATPSCharacter>(InPawn));
+	}
 }
 
 void ATPSPlayerController::SetupInputComponent()
@@ -52,7 +94,7 @@ void ATPSPlayerController::MoveToMouseCursor()
 		{
 			if (MyPawn->GetCursorToWorld())
 			{
-				UAIBlueprintHelperLibrary::SimpleMoveToLocation(this, MyPawn->GetCursorToWorld()->GetComponentLocation());
+				MoveToLocationAsync(MyPawn->GetCursorToWorld()->GetComponentLocation());
 			}
 		}
 	}
@@ -94,11 +136,77 @@ void ATPSPlayerController::SetNewMoveDestination(const FVector DestLocation)
 		// We need to issue move command only if far enough in order for walk animation to play correctly
 		if ((Distance > 120.0f))
 		{
-			UAIBlueprintHelperLibrary::SimpleMoveToLocation(this, DestLocation);
+			MoveToLocationAsync(DestLocation);
 		}
 	}
 }
 
+void ATPSPlayerController::MoveToLocationAsync(const FVector& Goal)
+{
+	APawn* myPawn = GetPawn();
+	UTPSPathSubsystem* myPaths = GetWorld()->GetSubsystem<UTPSPathSubsystem>();
+	UPathFollowingComponent* myPathFollowing = GetPathFollowing();
+	if (!myPawn || !myPaths || !myPathFollowing || !myPathFollowing->IsPathFollowingAllowed())
+		return;
+
+	MoveGoal = Goal;
+	const FVector Start = myPawn->GetNavAgentLocation();
+	if (myPaths->RequestPath(this, Start, Goal, FTPSPathReadyDelegate::CreateUObject(this, &ATPSPlayerController::OnMovePathReady)))
+		return;
+
+	//full path not ready, walk the reachable straight part unless already heading there
+	const bool bHeadingToGoal = myPathFollowing->GetStatus() != EPathFollowingStatus::Idle && FVector::DistSquared2D(FollowingGoal, Goal) < FMath::Square(120.0f);
+	if (!bHeadingToGoal)
+	{
+		FNavPathSharedPtr myPartialPath = myPaths->MakePartialPath(this, Start, Goal);
+		if (myPartialPath.IsValid())
+		{
+			FollowPath(myPartialPath, Goal);
+		}
+	}
+}
+
+void ATPSPlayerController::OnMovePathReady(FNavPathSharedPtr Path)
+{
+	if (Path.IsValid() && GetPawn())
+	{
+		FollowPath(Path, MoveGoal);
+	}
+}
+
+void ATPSPlayerController::FollowPath(FNavPathSharedPtr Path, const FVector& Goal)
+{
+	UPathFollowingComponent* myPathFollowing = GetPathFollowing();
+	//same cached path every tick while the mouse is held still
+	if (!myPathFollowing || (myPathFollowing->GetPath() == Path && myPathFollowing->GetStatus() != EPathFollowingStatus::Idle))
+		return;
+
+	// keep only one move request at time, velocity carries over from the partial path
+	if (myPathFollowing->GetStatus() != EPathFollowingStatus::Idle)
+	{
+		myPathFollowing->AbortMove(*this, FPathFollowingResultFlags::ForcedScript | FPathFollowingResultFlags::NewRequest,
+			FAIRequestID::AnyRequest, EPathFollowingVelocityMode::Keep);
+	}
+	myPathFollowing->RequestMove(FAIMoveRequest(Goal), Path);
+	FollowingGoal = Goal;
+}
+
+UPathFollowingComponent* ATPSPlayerController::GetPathFollowing()
+{
+	//player controllers have none by default, same setup as SimpleMoveToLocation
+	if (!PathFollowing)
+	{
+		PathFollowing = FindComponentByClass<UPathFollowingComponent>();
+	}
+	if (!PathFollowing)
+	{
+		PathFollowing = NewObject<UPathFollowingComponent>(this);
+		PathFollowing->RegisterComponentWithWorld(GetWorld());
+		PathFollowing->Initialize();
+	}
+	return PathFollowing;
+}
+
 void ATPSPlayerController::OnSetDestinationPressed()
 {
 	// set flag to keep updating destination until released
@@ -113,5 +221,10 @@ void ATPSPlayerController::OnSetDestinationReleased()
 
 void ATPSPlayerController::OnUnPossess()
 {
+	UTPSPathSubsystem* myPaths = GetWorld()->GetSubsystem<UTPSPathSubsystem>();
+	if (myPaths)
+	{
+		myPaths->CancelRequests(this);
+	}
 	Super::OnUnPossess();
 }
@@ -4,6 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
+#include "TPSBotController.h"
+#include "TPSHUDViewModel.h"
+#include "AI/Navigation/NavigationTypes.h"
 #include "TPSPlayerController.generated.h"
 
 UCLASS()
@@ -14,11 +17,18 @@ class ATPSPlayerController : public APlayerController
 public:
 	ATPSPlayerController();
 
+	//local controllers only, nullptr on server for remote players
+	UFUNCTION(BlueprintCallable, Category = "HUD")
+	UTPSHUDViewModel* GetHUDViewModel();
+
+	virtual void SetPawn(APawn* InPawn) override;
+
 protected:
 	/** True if the controlled character should navigate to the mouse cursor. */
 	uint32 bMoveToMouseCursor : 1;
 
 	// Begin PlayerController interface
+	virtual void BeginPlay() override;
 	virtual void PlayerTick(float DeltaTime) override;
 	virtual void SetupInputComponent() override;
 	// End PlayerController interface
@@ -35,11 +45,30 @@ protected:
 	/** Navigate player to the given world location. */
 	void SetNewMoveDestination(const FVector DestLocation);
 
+	/** Path from UTPSPathSubsystem, follows a partial path meanwhile. */
+	void MoveToLocationAsync(const FVector& Goal);
+	void OnMovePathReady(FNavPathSharedPtr Path);
+	void FollowPath(FNavPathSharedPtr Path, const FVector& Goal);
+	class UPathFollowingComponent* GetPathFollowing();
+
 	/** Input handlers for SetDestination action. */
 	void OnSetDestinationPressed();
 	void OnSetDestinationReleased();
 
 	virtual void OnUnPossess()override;
+
+	/** Load test client (-TPSBot -TPSBotSeed=N), pawn is driven by BotScript instead of input. */
+	bool bIsBot = false;
+	FTPSBotScript BotScript;
+
+	UPROPERTY(Transient)
+	UTPSHUDViewModel* HUDViewModel = nullptr;
+
+	UPROPERTY(Transient)
+	class UPathFollowingComponent* PathFollowing = nullptr;
+	FVector MoveGoal = FVector::ZeroVector;
+	//goal of the path being followed, partial or full
+	FVector FollowingGoal = FVector::ZeroVector;
 };
 
 
@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSRegenSubsystem.h"
+#include "../TPS.h"
+#include "Engine/World.h"
+
+void UTPSRegenSubsystem::Deinitialize()
+{
+	Targets.Empty();
+	Channels.Empty();
+	CooldownUntil.Empty();
+	Rates.Empty();
+	StepIntervals.Empty();
+	StepAccumulators.Empty();
+	ActiveFlags.Empty();
+	FreeHandles.Empty();
+	NumActive = 0;
+	Super::Deinitialize();
+}
+
+TStatId UTPSRegenSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTPSRegenSubsystem, STATGROUP_Tickables);
+}
+
+int32 UTPSRegenSubsystem::Register(ITPSRegenTarget* Target, ETPSRegenChannel Channel, float Rate, float StepInterval, bool bStartActive)
+{
+	if (!Target)
+		return INDEX_NONE;
+
+	int32 Handle = INDEX_NONE;
+	if (FreeHandles.Num() > 0)
+	{
+		Handle = FreeHandles.Pop(false);
+	}
+	else
+	{
+		Handle = Targets.AddDefaulted();
+		Channels.AddDefaulted();
+		CooldownUntil.AddDefaulted();
+		Rates.AddDefaulted();
+		StepIntervals.AddDefaulted();
+		StepAccumulators.AddDefaulted();
+		ActiveFlags.AddDefaulted();
+	}
+
+	Targets[Handle] = Target;
+	Channels[Handle] = Channel;
+	CooldownUntil[Handle] = 0.0f;
+	Rates[Handle] = Rate;
+	StepIntervals[Handle] = FMath::Max(StepInterval, 0.0f);
+	StepAccumulators[Handle] = 0.0f;
+	ActiveFlags[Handle] = false;
+	SetActive(Handle, bStartActive);
+	return Handle;
+}
+
+void UTPSRegenSubsystem::Unregister(int32& Handle)
+{
+	if (IsValidHandle(Handle))
+	{
+		SetActive(Handle, false);
+		Targets[Handle] = nullptr;
+		FreeHandles.Add(Handle);
+	}
+	Handle = INDEX_NONE;
+}
+
+void UTPSRegenSubsystem::SetActive(int32 Handle, bool bNewActive)
+{
+	if (!IsValidHandle(Handle) || ActiveFlags[Handle] == bNewActive)
+		return;
+
+	ActiveFlags[Handle] = bNewActive;
+	NumActive += bNewActive ? 1 : -1;
+	StepAccumulators[Handle] = 0.0f;
+}
+
+void UTPSRegenSubsystem::SetCooldown(int32 Handle, float Seconds)
+{
+	if (!IsValidHandle(Handle))
+		return;
+
+	CooldownUntil[Handle] = GetWorld()->GetTimeSeconds() + Seconds;
+	StepAccumulators[Handle] = 0.0f;
+	SetActive(Handle, true);
+}
+
+void UTPSRegenSubsystem::SetRate(int32 Handle, float Rate, float StepInterval)
+{
+	if (!IsValidHandle(Handle))
+		return;
+
+	Rates[Handle] = Rate;
+	StepIntervals[Handle] = FMath::Max(StepInterval, 0.0f);
+}
+
+void UTPSRegenSubsystem::Tick(float DeltaTime)
+{
+	CSV_SCOPED_TIMING_STAT(TPS, RegenUpdate);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	const int32 Num = Targets.Num();
+	for (int32 i = 0; i < Num; i++)
+	{
+		if (!ActiveFlags[i] || Now < CooldownUntil[i])
+			continue;
+
+		float Elapsed = DeltaTime;
+		if (StepIntervals[i] > 0.0f)
+		{
+			StepAccumulators[i] += DeltaTime;
+			if (StepAccumulators[i] < StepIntervals[i])
+				continue;
+
+			const float Steps = FMath::FloorToFloat(StepAccumulators[i] / StepIntervals[i]);
+			Elapsed = Steps * StepIntervals[i];
+			StepAccumulators[i] -= Elapsed;
+		}
+
+		if (!Targets[i]->ApplyRegen(Channels[i], Rates[i] * Elapsed, Elapsed))
+		{
+			SetActive(i, false);
+		}
+	}
+}
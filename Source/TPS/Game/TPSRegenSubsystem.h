@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "TPSRegenSubsystem.generated.h"
+
+enum class ETPSRegenChannel : uint8
+{
+	Shield,
+	Health,
+	Stamina
+};
+
+//Owner of regenerated values, plain C++ so the batch loop calls it without reflection
+class TPS_API ITPSRegenTarget
+{
+public:
+	virtual ~ITPSRegenTarget() {}
+	//Amount = rate * elapsed, return false to stop until next SetCooldown/SetActive
+	virtual bool ApplyRegen(ETPSRegenChannel Channel, float Amount, float ElapsedTime) = 0;
+};
+
+/**
+ * Regeneration of all shields, health and stamina in one batch per frame.
+ * Entries are flat arrays, a hit only writes the entry's cooldown-until time,
+ * no timer is cleared or armed. StepInterval > 0 applies Rate * StepInterval per step, 0 - every frame.
+ */
+UCLASS()
+class TPS_API UTPSRegenSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return NumActive > 0; }
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	//End FTickableGameObject
+
+	//returns handle, Rate per second
+	int32 Register(ITPSRegenTarget* Target, ETPSRegenChannel Channel, float Rate, float StepInterval, bool bStartActive);
+	void Unregister(int32& Handle);
+
+	//no regen for Seconds, then active
+	void SetCooldown(int32 Handle, float Seconds);
+	void SetActive(int32 Handle, bool bNewActive);
+	void SetRate(int32 Handle, float Rate, float StepInterval);
+
+protected:
+	bool IsValidHandle(int32 Handle) const { return Targets.IsValidIndex(Handle) && Targets[Handle] != nullptr; }
+
+	TArray<ITPSRegenTarget*> Targets;
+	TArray<ETPSRegenChannel> Channels;
+	TArray<float> CooldownUntil;
+	TArray<float> Rates;
+	TArray<float> StepIntervals;
+	TArray<float> StepAccumulators;
+	TArray<bool> ActiveFlags;
+	TArray<int32> FreeHandles;
+	int32 NumActive = 0;
+};
@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSReplicationGraph.h"
+#include "../TPS.h"
+#include "../Character/TPSCharacter.h"
+#include "../Weapon/WeaponDefault.h"
+#include "../Weapon/ProjectileDefault.h"
+#include "../Structure/WorldItemDefault.h"
+#include "../Structure/TPS_EnvironmentStructure.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/PlayerState.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/LevelScriptActor.h"
+#include "Engine/NetConnection.h"
+
+int32 RepGraphLogConsider = 0;
+FAutoConsoleVariableRef CVARRepGraphLogConsider{
+	TEXT("TPS.RepGraph.LogConsider"),
+	RepGraphLogConsider,
+	TEXT("Log actors considered per connection every N replication frames, 0 - off"),
+	ECVF_Default
+};
+
+UTPSReplicationGraph::UTPSReplicationGraph()
+{
+}
+
+ETPSClassRepNodeMapping UTPSReplicationGraph::GetMappingPolicy(UClass* Class)
+{
+	ETPSClassRepNodeMapping* Policy = ClassRepNodePolicies.Get(Class);
+	return Policy ? *Policy : ETPSClassRepNodeMapping::NotRouted;
+}
+
+void UTPSReplicationGraph::InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class, bool bSpatialize) const
+{
+	AActor* CDO = Class->GetDefaultObject<AActor>();
+	if (bSpatialize)
+	{
+		Info.SetCullDistanceSquared(CDO->NetCullDistanceSquared);
+	}
+	const float ServerMaxTickRate = NetDriver ? NetDriver->NetServerMaxTickRate : 30.0f;
+	Info.ReplicationPeriodFrame = FMath::Max<uint32>((uint32)FMath::RoundToFloat(ServerMaxTickRate / FMath::Max(CDO->NetUpdateFrequency, 1.0f)), 1);
+}
+
+void UTPSReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	//anything not listed below moves and is culled by distance
+	ClassRepNodePolicies.Set(AActor::StaticClass(), ETPSClassRepNodeMapping::Spatialize_Dynamic);
+	ClassRepNodePolicies.Set(AInfo::StaticClass(), ETPSClassRepNodeMapping::RelevantAllConnections);
+	ClassRepNodePolicies.Set(APlayerState::StaticClass(), ETPSClassRepNodeMapping::RelevantAllConnections);
+	//own controller goes through UTPSReplicationGraphNode_AlwaysRelevant_ForConnection
+	ClassRepNodePolicies.Set(APlayerController::StaticClass(), ETPSClassRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(ALevelScriptActor::StaticClass(), ETPSClassRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(ATPSCharacter::StaticClass(), ETPSClassRepNodeMapping::Spatialize_Dynamic);
+	ClassRepNodePolicies.Set(AWeaponDefault::StaticClass(), ETPSClassRepNodeMapping::Spatialize_Dynamic);
+	ClassRepNodePolicies.Set(AProjectileDefault::StaticClass(), ETPSClassRepNodeMapping::Spatialize_Dynamic);
+	ClassRepNodePolicies.Set(AWorldItemDefault::StaticClass(), ETPSClassRepNodeMapping::Spatialize_Dormancy);
+	ClassRepNodePolicies.Set(ATPS_EnvironmentStructure::StaticClass(), ETPSClassRepNodeMapping::Spatialize_Dormancy);
+
+	for (UClass* Class : { ATPSCharacter::StaticClass(), AWeaponDefault::StaticClass(), AProjectileDefault::StaticClass(),
+		AWorldItemDefault::StaticClass(), ATPS_EnvironmentStructure::StaticClass() })
+	{
+		FClassReplicationInfo Info;
+		InitClassReplicationInfo(Info, Class, true);
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, Info);
+	}
+	for (UClass* Class : { AInfo::StaticClass(), APlayerState::StaticClass() })
+	{
+		FClassReplicationInfo Info;
+		InitClassReplicationInfo(Info, Class, false);
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, Info);
+	}
+}
+
+void UTPSReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = CellSize;
+	GridNode->SpatialBias = SpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UTPSReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	AddConnectionGraphNode(CreateNewNode<UTPSReplicationGraphNode_AlwaysRelevant_ForConnection>(), RepGraphConnection);
+	//last node, sees everything gathered before it
+	AddConnectionGraphNode(CreateNewNode<UTPSReplicationGraphNode_ConsiderCounter>(), RepGraphConnection);
+}
+
+void UTPSReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case ETPSClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case ETPSClassRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+	case ETPSClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	case ETPSClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+void UTPSReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case ETPSClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case ETPSClassRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+	case ETPSClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	case ETPSClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+void UTPSReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	ReplicationActorList.Reset();
+	for (const FNetViewer& Viewer : Params.Viewers)
+	{
+		ReplicationActorList.ConditionalAdd(Viewer.InViewer);
+		ReplicationActorList.ConditionalAdd(Viewer.ViewTarget);
+	}
+
+	Super::GatherActorListsForConnection(Params);
+}
+
+void UTPSReplicationGraphNode_ConsiderCounter::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	int32 Considered = 0;
+	const int32 NumLists = Params.OutGatheredReplicationLists.NumLists();
+	for (int32 i = 0; i < NumLists; i++)
+	{
+		Considered += Params.OutGatheredReplicationLists.GetList(EActorRepListTypeFlags::Default, i).Num();
+	}
+
+	LastConsidered = Considered;
+	TotalConsidered += Considered;
+	NumFrames++;
+	CSV_CUSTOM_STAT(TPS, RepConsidered, Considered, ECsvCustomStatOp::Accumulate);
+
+	if (RepGraphLogConsider > 0 && NumFrames % RepGraphLogConsider == 0)
+	{
+		UNetConnection* myConnection = Params.ConnectionManager.NetConnection;
+		UE_LOG(LogTemp, Display, TEXT("TPSReplicationGraph - %s considered %d actors (avg %.1f over %d frames)"),
+			myConnection ? *myConnection->LowLevelDescribe() : TEXT("None"), Considered, (float)TotalConsidered / NumFrames, NumFrames);
+	}
+}
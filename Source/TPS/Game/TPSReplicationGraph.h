@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "TPSReplicationGraph.generated.h"
+
+class UReplicationGraphNode_GridSpatialization2D;
+class UReplicationGraphNode_ActorList;
+
+UENUM()
+enum class ETPSClassRepNodeMapping : uint8
+{
+	NotRouted,
+	RelevantAllConnections,
+	//grid cell for static actors, never move
+	Spatialize_Static,
+	//grid cell updated every frame
+	Spatialize_Dynamic,
+	//static while dormant, dynamic after wake
+	Spatialize_Dormancy,
+};
+
+/**
+ * Replication graph for TPS (DefaultEngine.ini ReplicationDriverClassName):
+ * characters, weapons and projectiles in 2D grid cells, game state and player states
+ * relevant to all, world items and environment dormant until picked up, damaged or hit by an effect.
+ */
+UCLASS(Transient, config = Engine)
+class TPS_API UTPSReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	UTPSReplicationGraph();
+
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	UPROPERTY(Config)
+	float CellSize = 5000.0f;
+	//lowest world X/Y the grid covers without rebuild
+	UPROPERTY(Config)
+	FVector2D SpatialBias = FVector2D(-50000.0f, -50000.0f);
+
+	UPROPERTY()
+	UReplicationGraphNode_GridSpatialization2D* GridNode = nullptr;
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode = nullptr;
+
+protected:
+	ETPSClassRepNodeMapping GetMappingPolicy(UClass* Class);
+	void InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class, bool bSpatialize) const;
+
+	TClassMap<ETPSClassRepNodeMapping> ClassRepNodePolicies;
+};
+
+//Connection's own player controller and view target
+UCLASS()
+class TPS_API UTPSReplicationGraphNode_AlwaysRelevant_ForConnection : public UReplicationGraphNode_AlwaysRelevant_ForConnection
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+};
+
+//Added last to every connection, counts actors gathered for it (TPS.RepGraph.LogConsider)
+UCLASS()
+class TPS_API UTPSReplicationGraphNode_ConsiderCounter : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override {}
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override {}
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+	int32 LastConsidered = 0;
+	int64 TotalConsidered = 0;
+	int32 NumFrames = 0;
+};
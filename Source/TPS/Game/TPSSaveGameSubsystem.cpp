@@ -0,0 +1,340 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSSaveGameSubsystem.h"
+#include "../Character/TPSCharacter.h"
+#include "../StateEffects/TPS_StateEffect.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+static const uint32 TPSSaveMagic = 0x53535054; //TPSS
+
+void FTPSCharacterSaveData::Serialize(FArchive& Ar, int32 Version)
+{
+	//names as strings, FMemoryArchive writes no name table
+	int32 NumWeapons = WeaponSlots.Num();
+	Ar << NumWeapons;
+	if (Ar.IsLoading())
+	{
+		WeaponSlots.SetNum(FMath::Clamp(NumWeapons, 0, 64));
+	}
+	for (FWeaponSlot& Slot : WeaponSlots)
+	{
+		FString Name = Slot.NameItem.ToString();
+		Ar << Name;
+		Ar << Slot.AdditionalInfo.Round;
+		if (Ar.IsLoading())
+		{
+			Slot.NameItem = Name == TEXT("None") ? NAME_None : FName(*Name);
+		}
+	}
+
+	int32 NumAmmo = AmmoSlots.Num();
+	Ar << NumAmmo;
+	if (Ar.IsLoading())
+	{
+		AmmoSlots.SetNum(FMath::Clamp(NumAmmo, 0, 64));
+	}
+	for (FAmmoSlot& Slot : AmmoSlots)
+	{
+		uint8 Type = (uint8)Slot.WeaponType;
+		Ar << Type;
+		Ar << Slot.Cout;
+		Ar << Slot.MaxCout;
+		Slot.WeaponType = (EWeaponType)Type;
+	}
+
+	Ar << CurrentIndexWeapon;
+	Ar << Health;
+
+	if (Version >= (int32)ETPSSaveVersion::ShieldAndEffects)
+	{
+		Ar << Shield;
+
+		int32 NumEffects = Effects.Num();
+		Ar << NumEffects;
+		if (Ar.IsLoading())
+		{
+			Effects.SetNum(FMath::Clamp(NumEffects, 0, 256));
+		}
+		for (FTPSSavedEffect& Effect : Effects)
+		{
+			Ar << Effect.ClassPath;
+			Ar << Effect.RemainingTime;
+		}
+	}
+}
+
+void UTPSSaveGameSubsystem::Deinitialize()
+{
+	//files must be complete before exit
+	for (TFuture<void>& Task : Tasks)
+	{
+		Task.Wait();
+	}
+	Tasks.Empty();
+
+	//WriteFinished will not run anymore, newest queued data per slot goes out now
+	for (TPair<FString, FTPSCharacterSaveData>& Queued : QueuedSaves)
+	{
+		if (!WriteSaveFile(Queued.Key, Queued.Value))
+		{
+			UE_LOG(LogTemp, Error, TEXT("UTPSSaveGameSubsystem::Deinitialize - Can't write %s"), *GetSaveFilePath(Queued.Key));
+		}
+	}
+	QueuedSaves.Empty();
+	WritingSlots.Empty();
+
+	Super::Deinitialize();
+}
+
+FString UTPSSaveGameSubsystem::GetSaveFilePath(const FString& SlotName)
+{
+	return FPaths::ProjectSavedDir() / TEXT("SaveGames") / SlotName + TEXT(".tpssave");
+}
+
+bool UTPSSaveGameSubsystem::DoesSaveExist(const FString& SlotName) const
+{
+	return IFileManager::Get().FileExists(*GetSaveFilePath(SlotName));
+}
+
+void UTPSSaveGameSubsystem::GatherCharacter(ATPSCharacter* Character, FTPSCharacterSaveData& OutData)
+{
+	if (Character->InventoryComponent)
+	{
+		OutData.WeaponSlots = Character->InventoryComponent->WeaponSlots;
+		OutData.AmmoSlots = Character->InventoryComponent->AmmoSlots;
+	}
+	OutData.CurrentIndexWeapon = Character->CurrentIndexWeapon;
+
+	//rounds in the clip live on the weapon actor until switch
+	AWeaponDefault* myWeapon = Character->GetCurrentWeapon();
+	if (myWeapon && OutData.WeaponSlots.IsValidIndex(OutData.CurrentIndexWeapon))
+	{
+		OutData.WeaponSlots[OutData.CurrentIndexWeapon].AdditionalInfo = myWeapon->AdditionalWeaponInfo;
+	}
+
+	if (Character->CharHealthComponent)
+	{
+		OutData.Health = Character->CharHealthComponent->GetCurrentHealth();
+		OutData.Shield = Character->CharHealthComponent->GetCurrentShield();
+	}
+
+	for (UTPS_StateEffect* Effect : Character->GetAllCurrentEffects())
+	{
+		if (Effect)
+		{
+			FTPSSavedEffect& Saved = OutData.Effects.AddDefaulted_GetRef();
+			Saved.ClassPath = Effect->GetClass()->GetPathName();
+			Saved.RemainingTime = Effect->GetRemainingTime();
+		}
+	}
+}
+
+void UTPSSaveGameSubsystem::WriteSaveData(TArray<uint8>& OutBytes, FTPSCharacterSaveData& Data)
+{
+	FMemoryWriter Ar(OutBytes, true);
+	uint32 Magic = TPSSaveMagic;
+	int32 Version = (int32)ETPSSaveVersion::Latest;
+	Ar << Magic;
+	Ar << Version;
+	Data.Serialize(Ar, Version);
+}
+
+bool UTPSSaveGameSubsystem::ReadSaveData(const TArray<uint8>& Bytes, FTPSCharacterSaveData& OutData)
+{
+	FMemoryReader Ar(Bytes, true);
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Ar << Magic;
+	Ar << Version;
+	if (Ar.IsError() || Magic != TPSSaveMagic || Version < (int32)ETPSSaveVersion::Initial || Version > (int32)ETPSSaveVersion::Latest)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UTPSSaveGameSubsystem::ReadSaveData - bad header, version %d"), Version);
+		return false;
+	}
+
+	OutData.Serialize(Ar, Version);
+	return !Ar.IsError();
+}
+
+void UTPSSaveGameSubsystem::SaveCharacter(ATPSCharacter* Character, const FString& SlotName)
+{
+	if (!Character)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UTPSSaveGameSubsystem::SaveCharacter - Character -NULL"));
+		OnSaveFinished.Broadcast(SlotName, false);
+		return;
+	}
+
+	FTPSCharacterSaveData Data;
+	GatherCharacter(Character, Data);
+
+	if (WritingSlots.Contains(SlotName))
+	{
+		QueuedSaves.Add(SlotName, MoveTemp(Data));
+		return;
+	}
+	StartWrite(SlotName, MoveTemp(Data));
+}
+
+void UTPSSaveGameSubsystem::StartWrite(const FString& SlotName, FTPSCharacterSaveData&& Data)
+{
+	WritingSlots.Add(SlotName);
+	Tasks.RemoveAll([](const TFuture<void>& Task) { return Task.IsReady(); });
+
+	TWeakObjectPtr<UTPSSaveGameSubsystem> WeakThis(this);
+	Tasks.Add(Async(EAsyncExecution::ThreadPool, [WeakThis, SlotName, Data = MoveTemp(Data)]() mutable
+	{
+		const bool bSuccess = WriteSaveFile(SlotName, Data);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, SlotName, bSuccess]()
+		{
+			if (WeakThis.IsValid())
+			{
+				WeakThis->WriteFinished(SlotName, bSuccess);
+			}
+		});
+	}));
+}
+
+bool UTPSSaveGameSubsystem::WriteSaveFile(const FString& SlotName, FTPSCharacterSaveData& Data)
+{
+	TArray<uint8> Bytes;
+	WriteSaveData(Bytes, Data);
+
+	//temp file and move, a crash mid-write keeps the old save
+	const FString FilePath = GetSaveFilePath(SlotName);
+	const FString TempPath = FilePath + TEXT(".tmp");
+	return FFileHelper::SaveArrayToFile(Bytes, *TempPath) && IFileManager::Get().Move(*FilePath, *TempPath);
+}
+
+void UTPSSaveGameSubsystem::WriteFinished(const FString& SlotName, bool bSuccess)
+{
+	WritingSlots.Remove(SlotName);
+	if (!bSuccess)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UTPSSaveGameSubsystem::WriteFinished - Can't write %s"), *GetSaveFilePath(SlotName));
+	}
+	OnSaveFinished.Broadcast(SlotName, bSuccess);
+
+	FTPSCharacterSaveData Queued;
+	if (QueuedSaves.RemoveAndCopyValue(SlotName, Queued))
+	{
+		StartWrite(SlotName, MoveTemp(Queued));
+	}
+}
+
+void UTPSSaveGameSubsystem::LoadCharacter(ATPSCharacter* Character, const FString& SlotName)
+{
+	if (!Character || !Character->HasAuthority())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UTPSSaveGameSubsystem::LoadCharacter - Character -NULL or not authority"));
+		OnLoadFinished.Broadcast(SlotName, false);
+		return;
+	}
+
+	Tasks.RemoveAll([](const TFuture<void>& Task) { return Task.IsReady(); });
+
+	TWeakObjectPtr<UTPSSaveGameSubsystem> WeakThis(this);
+	TWeakObjectPtr<ATPSCharacter> WeakChar(Character);
+	Tasks.Add(Async(EAsyncExecution::ThreadPool, [WeakThis, WeakChar, SlotName]()
+	{
+		TArray<uint8> Bytes;
+		FTPSCharacterSaveData Data;
+		const bool bSuccess = FFileHelper::LoadFileToArray(Bytes, *GetSaveFilePath(SlotName), FILEREAD_Silent) && ReadSaveData(Bytes, Data);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, WeakChar, SlotName, bSuccess, Data = MoveTemp(Data)]()
+		{
+			if (WeakThis.IsValid())
+			{
+				WeakThis->ReadFinished(WeakChar, SlotName, bSuccess, Data);
+			}
+		});
+	}));
+}
+
+void UTPSSaveGameSubsystem::ReadFinished(TWeakObjectPtr<ATPSCharacter> Character, const FString& SlotName, bool bSuccess, const FTPSCharacterSaveData& Data)
+{
+	if (bSuccess && Character.IsValid())
+	{
+		ApplyCharacter(Character.Get(), Data);
+	}
+	else
+	{
+		bSuccess = false;
+		UE_LOG(LogTemp, Warning, TEXT("UTPSSaveGameSubsystem::ReadFinished - %s not loaded"), *SlotName);
+	}
+	OnLoadFinished.Broadcast(SlotName, bSuccess);
+}
+
+void UTPSSaveGameSubsystem::ApplyCharacter(ATPSCharacter* Character, const FTPSCharacterSaveData& Data)
+{
+	UTPSInventoryComponent* myInventory = Character->InventoryComponent;
+	if (myInventory)
+	{
+		//saved slots keep their rounds, only the equipped weapon reads WeaponInfoTable in InitWeapon
+		myInventory->WeaponSlots = Data.WeaponSlots;
+		myInventory->AmmoSlots = Data.AmmoSlots;
+		myInventory->MaxSlotsWeapon = FMath::Max(myInventory->MaxSlotsWeapon, Data.WeaponSlots.Num());
+		myInventory->MarkAllSlotsDirty();
+
+		for (int32 i = 0; i < myInventory->WeaponSlots.Num(); i++)
+		{
+			myInventory->OnUpdateWeaponSlots.Broadcast(i, myInventory->WeaponSlots[i]);
+		}
+		for (const FAmmoSlot& Slot : myInventory->AmmoSlots)
+		{
+			myInventory->OnAmmoChange.Broadcast(Slot.WeaponType, Slot.Cout);
+		}
+
+		const int32 Index = Data.WeaponSlots.IsValidIndex(Data.CurrentIndexWeapon) ? Data.CurrentIndexWeapon : 0;
+		if (myInventory->WeaponSlots.IsValidIndex(Index) && !myInventory->WeaponSlots[Index].NameItem.IsNone())
+		{
+			Character->InitWeapon(myInventory->WeaponSlots[Index].NameItem, myInventory->WeaponSlots[Index].AdditionalInfo, Index);
+		}
+	}
+
+	UTPSCharacterHealthComponent* myHealth = Character->CharHealthComponent;
+	if (myHealth)
+	{
+		myHealth->SetCurrentHealth(Data.Health);
+		myHealth->SetCurrentShield(Data.Shield);
+		myHealth->OnHealthChange.Broadcast(myHealth->GetCurrentHealth(), 0.0f);
+		myHealth->OnShieldChange.Broadcast(myHealth->GetCurrentShield(), 0.0f);
+	}
+
+	//replace running effects with the saved ones
+	TArray<UTPS_StateEffect*> OldEffects = Character->GetAllCurrentEffects();
+	for (UTPS_StateEffect* Effect : OldEffects)
+	{
+		if (Effect)
+		{
+			Effect->DestroyObject();
+		}
+	}
+	for (const FTPSSavedEffect& Saved : Data.Effects)
+	{
+		if (Saved.RemainingTime >= 0.0f && Saved.RemainingTime < KINDA_SMALL_NUMBER)
+			continue;
+
+		UClass* EffectClass = FSoftClassPath(Saved.ClassPath).TryLoadClass<UTPS_StateEffect>();
+		if (!EffectClass)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("UTPSSaveGameSubsystem::ApplyCharacter - Effect class not found - %s"), *Saved.ClassPath);
+			continue;
+		}
+
+		UTPS_StateEffect* NewEffect = NewObject<UTPS_StateEffect>(Character, EffectClass);
+		UTPS_StateEffect_ExecuteTimer* myTimerEffect = Cast<UTPS_StateEffect_ExecuteTimer>(NewEffect);
+		if (myTimerEffect && Saved.RemainingTime > 0.0f)
+		{
+			myTimerEffect->Timer = Saved.RemainingTime;
+		}
+		NewEffect->InitObject(Character);
+	}
+}
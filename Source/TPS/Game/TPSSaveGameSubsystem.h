@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Async/Future.h"
+#include "../FuncLibrary/Types.h"
+#include "TPSSaveGameSubsystem.generated.h"
+
+class ATPSCharacter;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnTPSSaveFinished, const FString&, SlotName, bool, bSuccess);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnTPSLoadFinished, const FString&, SlotName, bool, bSuccess);
+
+//Add new versions before VersionPlusOne, never reorder
+enum class ETPSSaveVersion : int32
+{
+	//inventory slots, current weapon, health
+	Initial = 1,
+	//shield and active state effects
+	ShieldAndEffects,
+
+	VersionPlusOne,
+	Latest = VersionPlusOne - 1
+};
+
+struct FTPSSavedEffect
+{
+	FString ClassPath;
+	//< 0 - until removed
+	float RemainingTime = -1.0f;
+};
+
+//Plain copy of the saved character state, safe to serialize on a worker thread
+struct TPS_API FTPSCharacterSaveData
+{
+	TArray<FWeaponSlot> WeaponSlots;
+	TArray<FAmmoSlot> AmmoSlots;
+	int32 CurrentIndexWeapon = 0;
+	float Health = 100.0f;
+	float Shield = 100.0f;
+	TArray<FTPSSavedEffect> Effects;
+
+	//Ar.IsLoading() - reads Version data, else writes ETPSSaveVersion::Latest
+	void Serialize(FArchive& Ar, int32 Version);
+};
+
+/**
+ * Versioned binary save of character inventory, health, shield and state effects.
+ * State is copied on the game thread, serialized with FMemoryWriter and written on the thread pool,
+ * results come back through OnSaveFinished/OnLoadFinished on the game thread.
+ * Files are Saved/SaveGames/<SlotName>.tpssave.
+ */
+UCLASS()
+class TPS_API UTPSSaveGameSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	UFUNCTION(BlueprintCallable, Category = "SaveGame")
+	void SaveCharacter(ATPSCharacter* Character, const FString& SlotName);
+	//server only, applied when the file is read
+	UFUNCTION(BlueprintCallable, Category = "SaveGame")
+	void LoadCharacter(ATPSCharacter* Character, const FString& SlotName);
+	UFUNCTION(BlueprintCallable, Category = "SaveGame")
+	bool DoesSaveExist(const FString& SlotName) const;
+
+	UPROPERTY(BlueprintAssignable, Category = "SaveGame")
+	FOnTPSSaveFinished OnSaveFinished;
+	UPROPERTY(BlueprintAssignable, Category = "SaveGame")
+	FOnTPSLoadFinished OnLoadFinished;
+
+	static FString GetSaveFilePath(const FString& SlotName);
+	static void GatherCharacter(ATPSCharacter* Character, FTPSCharacterSaveData& OutData);
+	static void ApplyCharacter(ATPSCharacter* Character, const FTPSCharacterSaveData& Data);
+	static void WriteSaveData(TArray<uint8>& OutBytes, FTPSCharacterSaveData& Data);
+	static bool WriteSaveFile(const FString& SlotName, FTPSCharacterSaveData& Data);
+	static bool ReadSaveData(const TArray<uint8>& Bytes, FTPSCharacterSaveData& OutData);
+
+protected:
+	void StartWrite(const FString& SlotName, FTPSCharacterSaveData&& Data);
+	void WriteFinished(const FString& SlotName, bool bSuccess);
+	void ReadFinished(TWeakObjectPtr<ATPSCharacter> Character, const FString& SlotName, bool bSuccess, const FTPSCharacterSaveData& Data);
+
+	//one write per slot in flight, newer saves of a busy slot replace each other
+	TSet<FString> WritingSlots;
+	TMap<FString, FTPSCharacterSaveData> QueuedSaves;
+	TArray<TFuture<void>> Tasks;
+};
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSWeaponAudioSubsystem.h"
+#include "Components/AudioComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/World.h"
+
+int32 WeaponAudioMaxVoices = 24;
+FAutoConsoleVariableRef CVARWeaponAudioMaxVoices{
+	TEXT("TPS.Audio.MaxWeaponVoices"),
+	WeaponAudioMaxVoices,
+	TEXT("Weapon fire voices playing at once for all weapons, 0 - no limit"),
+	ECVF_Default
+};
+
+void UTPSWeaponAudioSubsystem::Deinitialize()
+{
+	Voices.Empty();
+	VoiceRows.Empty();
+
+	Super::Deinitialize();
+}
+
+void UTPSWeaponAudioSubsystem::PruneVoices()
+{
+	for (int32 i = Voices.Num() - 1; i >= 0; i--)
+	{
+		if (!Voices[i].IsValid() || !Voices[i]->IsPlaying())
+		{
+			Voices.RemoveAtSwap(i, 1, false);
+			VoiceRows.RemoveAtSwap(i, 1, false);
+		}
+	}
+}
+
+bool UTPSWeaponAudioSubsystem::CanPlay(FName WeaponRow, const FWeaponAudioInfo& Info, const FVector& Location)
+{
+	if (Info.CullDistance > 0.0f)
+	{
+		APlayerController* myPC = UGameplayStatics::GetPlayerController(this, 0);
+		if (myPC)
+		{
+			FVector ListenerLocation, ListenerFront, ListenerRight;
+			myPC->GetAudioListenerPosition(ListenerLocation, ListenerFront, ListenerRight);
+			if (FVector::DistSquared(ListenerLocation, Location) > FMath::Square(Info.CullDistance))
+				return false;
+		}
+	}
+
+	PruneVoices();
+	if (WeaponAudioMaxVoices > 0 && Voices.Num() >= WeaponAudioMaxVoices)
+		return false;
+
+	if (Info.MaxVoices > 0)
+	{
+		int32 RowVoices = 0;
+		for (const FName& Row : VoiceRows)
+		{
+			if (Row == WeaponRow)
+				RowVoices++;
+		}
+		if (RowVoices >= Info.MaxVoices)
+			return false;
+	}
+	return true;
+}
+
+void UTPSWeaponAudioSubsystem::AddVoice(UAudioComponent* Voice, FName WeaponRow)
+{
+	if (Voice)
+	{
+		Voices.Add(Voice);
+		VoiceRows.Add(WeaponRow);
+	}
+}
+
+UAudioComponent* UTPSWeaponAudioSubsystem::PlayAtLocation(USoundBase* Sound, FName WeaponRow, const FWeaponAudioInfo& Info, const FVector& Location)
+{
+	if (!Sound || !CanPlay(WeaponRow, Info, Location))
+		return nullptr;
+
+	UAudioComponent* Voice = UGameplayStatics::SpawnSoundAtLocation(this, Sound, Location, FRotator::ZeroRotator, 1.0f, 1.0f, 0.0f, nullptr, Info.Concurrency);
+	AddVoice(Voice, WeaponRow);
+	return Voice;
+}
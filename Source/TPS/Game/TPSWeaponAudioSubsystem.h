@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "../FuncLibrary/Types.h"
+#include "TPSWeaponAudioSubsystem.generated.h"
+
+class UAudioComponent;
+
+/**
+ * Voice budget for weapon sounds of one world, game thread only.
+ * Per weapon row FWeaponAudioInfo::MaxVoices and CullDistance,
+ * TPS.Audio.MaxWeaponVoices for all weapons together.
+ */
+UCLASS()
+class TPS_API UTPSWeaponAudioSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//false - over budget or too far from the listener
+	bool CanPlay(FName WeaponRow, const FWeaponAudioInfo& Info, const FVector& Location);
+	//counted until the component stops or is destroyed
+	void AddVoice(UAudioComponent* Voice, FName WeaponRow);
+
+	UAudioComponent* PlayAtLocation(USoundBase* Sound, FName WeaponRow, const FWeaponAudioInfo& Info, const FVector& Location);
+
+protected:
+	void PruneVoices();
+
+	TArray<TWeakObjectPtr<UAudioComponent>> Voices;
+	TArray<FName> VoiceRows;
+};
@@ -0,0 +1,198 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSWeaponSubsystem.h"
+#include "../Weapon/WeaponDefault.h"
+#include "../TPS.h"
+#include "Async/ParallelFor.h"
+
+int32 WeaponsBatch = 1;
+FAutoConsoleVariableRef CVARWeaponsBatch{
+	TEXT("TPS.Weapons.Batch"),
+	WeaponsBatch,
+	TEXT("Weapons spawned from now on update in UTPSWeaponSubsystem instead of their own tick"),
+	ECVF_Default
+};
+
+int32 WeaponsParallelMinBatch = 64;
+FAutoConsoleVariableRef CVARWeaponsParallelMinBatch{
+	TEXT("TPS.Weapons.ParallelMinBatch"),
+	WeaponsParallelMinBatch,
+	TEXT("Fewer registered weapons update on the game thread only, task overhead is bigger than the work"),
+	ECVF_Default
+};
+
+//Events bits, FTPSWeaponSim::DropClip and DropShell come from TickDrops
+static constexpr uint8 WeaponEventReload = 1 << 2;
+static constexpr uint8 WeaponEventLogDispersion = 1 << 3;
+
+void UTPSWeaponSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	UTPSFixedStepSubsystem* myFixedStep = Cast<UTPSFixedStepSubsystem>(Collection.InitializeDependency(UTPSFixedStepSubsystem::StaticClass()));
+	if (myFixedStep)
+	{
+		FixedStepHandle = myFixedStep->Register(this);
+	}
+}
+
+void UTPSWeaponSubsystem::Deinitialize()
+{
+	UTPSFixedStepSubsystem* myFixedStep = GetWorld()->GetSubsystem<UTPSFixedStepSubsystem>();
+	if (myFixedStep)
+	{
+		myFixedStep->Unregister(FixedStepHandle);
+	}
+
+	Weapons.Empty();
+	Infos.Empty();
+	Sims.Empty();
+	DispersionStepDeltas.Empty();
+	LogDispersionFlags.Empty();
+	ShotCounts.Empty();
+	Events.Empty();
+	FreeHandles.Empty();
+	NumWeapons = 0;
+	Super::Deinitialize();
+}
+
+TStatId UTPSWeaponSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTPSWeaponSubsystem, STATGROUP_Tickables);
+}
+
+bool UTPSWeaponSubsystem::IsBatchEnabled()
+{
+	return WeaponsBatch != 0;
+}
+
+int32 UTPSWeaponSubsystem::Register(AWeaponDefault* Weapon, const FTPSWeaponSim& Sim)
+{
+	if (!Weapon)
+		return INDEX_NONE;
+
+	int32 Handle = INDEX_NONE;
+	if (FreeHandles.Num() > 0)
+	{
+		Handle = FreeHandles.Pop(false);
+	}
+	else
+	{
+		Handle = Weapons.AddDefaulted();
+		Infos.AddDefaulted();
+		Sims.AddDefaulted();
+		DispersionStepDeltas.AddDefaulted();
+		LogDispersionFlags.AddDefaulted();
+		ShotCounts.AddDefaulted();
+		Events.AddDefaulted();
+	}
+
+	Weapons[Handle] = Weapon;
+	Infos[Handle] = &Weapon->WeaponSetting;
+	Sims[Handle] = Sim;
+	DispersionStepDeltas[Handle] = 0.0f;
+	LogDispersionFlags[Handle] = Weapon->ShowDebug;
+	//may be registered from an event in the game thread pass, nothing pending for it
+	ShotCounts[Handle] = 0;
+	Events[Handle] = 0;
+	NumWeapons++;
+	return Handle;
+}
+
+void UTPSWeaponSubsystem::Unregister(int32& Handle, FTPSWeaponSim& OutSim)
+{
+	if (Weapons.IsValidIndex(Handle) && Weapons[Handle] != nullptr)
+	{
+		OutSim = Sims[Handle];
+		Weapons[Handle] = nullptr;
+		Infos[Handle] = nullptr;
+		ShotCounts[Handle] = 0;
+		Events[Handle] = 0;
+		FreeHandles.Add(Handle);
+		NumWeapons--;
+	}
+	Handle = INDEX_NONE;
+}
+
+void UTPSWeaponSubsystem::Tick(float DeltaTime)
+{
+	CSV_SCOPED_TIMING_STAT(TPS, WeaponsUpdate);
+
+	const int32 Num = Weapons.Num();
+	ParallelFor(Num, [this, DeltaTime](int32 i)
+	{
+		if (!Weapons[i])
+			return;
+
+		FTPSWeaponSim& mySim = Sims[i];
+		ShotCounts[i] = mySim.TickFire(*Infos[i], DeltaTime);
+		Events[i] = mySim.TickDrops(DeltaTime);
+	}, Num < WeaponsParallelMinBatch);
+
+	//events may destroy or spawn weapons, Weapons[i] is read again every time
+	int32 NumEvents = 0;
+	for (int32 i = 0; i < Num; i++)
+	{
+		const uint8 myShotCount = ShotCounts[i];
+		const uint8 myEvents = Events[i];
+		if (myShotCount == 0 && myEvents == 0)
+			continue;
+
+		ShotCounts[i] = 0;
+		Events[i] = 0;
+		NumEvents++;
+		if ((myEvents & FTPSWeaponSim::DropClip) && Weapons[i])
+		{
+			Weapons[i]->SpawnClipDropMesh();
+		}
+		if ((myEvents & FTPSWeaponSim::DropShell) && Weapons[i])
+		{
+			Weapons[i]->SpawnShellDropMesh();
+		}
+		if (myShotCount > 0 && Weapons[i])
+		{
+			Weapons[i]->Fire(myShotCount);
+		}
+	}
+
+	CSV_CUSTOM_STAT(TPS, WeaponsBatched, NumWeapons, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(TPS, WeaponEvents, NumEvents, ECsvCustomStatOp::Accumulate);
+}
+
+void UTPSWeaponSubsystem::FixedStep(float StepTime)
+{
+	CSV_SCOPED_TIMING_STAT(TPS, WeaponsFixedStep);
+
+	const int32 Num = Weapons.Num();
+	ParallelFor(Num, [this, StepTime](int32 i)
+	{
+		if (!Weapons[i])
+			return;
+
+		FTPSWeaponSim& mySim = Sims[i];
+		const float OldDispersion = mySim.Dispersion;
+		const bool bReloadDone = mySim.TickReload(StepTime);
+		mySim.TickDispersion();
+		DispersionStepDeltas[i] = mySim.Dispersion - OldDispersion;
+		Events[i] = (bReloadDone ? WeaponEventReload : 0) | (LogDispersionFlags[i] ? WeaponEventLogDispersion : 0);
+	}, Num < WeaponsParallelMinBatch);
+
+	for (int32 i = 0; i < Num; i++)
+	{
+		const uint8 myEvents = Events[i];
+		if (myEvents == 0)
+			continue;
+
+		Events[i] = 0;
+		//simulated proxies only mirror the reload flag
+		if ((myEvents & WeaponEventReload) && Weapons[i] && Weapons[i]->CanFinishReload())
+		{
+			Weapons[i]->FinishReload();
+		}
+		if ((myEvents & WeaponEventLogDispersion) && Weapons[i])
+		{
+			Weapons[i]->LogDispersion();
+		}
+	}
+}
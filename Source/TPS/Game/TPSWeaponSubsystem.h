@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "TPSFixedStepSubsystem.h"
+#include "../Weapon/TPSWeaponSim.h"
+#include "TPSWeaponSubsystem.generated.h"
+
+class AWeaponDefault;
+
+/**
+ * Fire, drop, reload and dispersion timers of all weapons in flat arrays, instead of one actor tick per weapon.
+ * Every frame fire and drop timers, and every fixed step reload and dispersion, are advanced with ParallelFor
+ * (single threaded under TPS.Weapons.ParallelMinBatch weapons); fire, reload and drop events then run on the
+ * game thread in weapon order. Registered weapons disable their actor tick, TPS.Weapons.Batch 0 keeps the old per-actor tick.
+ */
+UCLASS()
+class TPS_API UTPSWeaponSubsystem : public UWorldSubsystem, public FTickableGameObject, public ITPSFixedStepTarget
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return NumWeapons > 0; }
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	//End FTickableGameObject
+
+	void FixedStep(float StepTime) override;
+
+	static bool IsBatchEnabled();
+
+	//returns handle, the weapon's sim state moves into the array until Unregister
+	int32 Register(AWeaponDefault* Weapon, const FTPSWeaponSim& Sim);
+	//OutSim - state handed back to the weapon
+	void Unregister(int32& Handle, FTPSWeaponSim& OutSim);
+
+	FTPSWeaponSim& GetSim(int32 Handle) { return Sims[Handle]; }
+	const FTPSWeaponSim& GetSim(int32 Handle) const { return Sims[Handle]; }
+	float GetDispersionStepDelta(int32 Handle) const { return DispersionStepDeltas[Handle]; }
+	int32 GetNumWeapons() const { return NumWeapons; }
+
+protected:
+	TArray<AWeaponDefault*> Weapons;
+	//WeaponSetting of the actor, read only in the parallel pass
+	TArray<const FWeaponInfo*> Infos;
+	TArray<FTPSWeaponSim> Sims;
+	TArray<float> DispersionStepDeltas;
+	TArray<bool> LogDispersionFlags;
+	//parallel pass output, read by the game thread pass
+	TArray<uint8> ShotCounts;
+	TArray<uint8> Events;
+	TArray<int32> FreeHandles;
+	int32 NumWeapons = 0;
+	int32 FixedStepHandle = INDEX_NONE;
+};
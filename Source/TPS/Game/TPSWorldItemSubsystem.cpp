@@ -0,0 +1,337 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSWorldItemSubsystem.h"
+#include "TPSGameInstance.h"
+#include "EngineUtils.h"
+#include "TimerManager.h"
+#include "../TPS.h"
+
+float WorldItemsCellSize = 500.0f;
+FAutoConsoleVariableRef CVARWorldItemsCellSize{
+	TEXT("TPS.WorldItems.CellSize"),
+	WorldItemsCellSize,
+	TEXT("Pickup grid cell size, about the usual query radius, applied on next world start"),
+	ECVF_Default
+};
+
+void UTPSWorldItemSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CellSize = FMath::Max(WorldItemsCellSize, 50.0f);
+}
+
+void UTPSWorldItemSubsystem::Deinitialize()
+{
+	UWorld* myWorld = GetWorld();
+	if (myWorld && ActorSpawnedHandle.IsValid())
+	{
+		myWorld->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+	ActorSpawnedHandle.Reset();
+	PickupHandles.Empty();
+	Cells.Empty();
+	Items.Empty();
+	Locations.Empty();
+	ItemCells.Empty();
+	Kinds.Empty();
+	WeaponTypes.Empty();
+	FreeHandles.Empty();
+	Super::Deinitialize();
+}
+
+void UTPSWorldItemSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	AmmoClass = AmmoPickupClass.IsValid() ? AmmoPickupClass.TryLoadClass<AActor>() : nullptr;
+	WeaponClass = WeaponPickupClass.IsValid() ? WeaponPickupClass.TryLoadClass<AActor>() : nullptr;
+	if (!AmmoClass && !WeaponClass)
+		return;
+
+	//placed in the level
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+	{
+		if ((AmmoClass && It->IsA(AmmoClass)) || (WeaponClass && It->IsA(WeaponClass)))
+		{
+			RegisterPickup(*It);
+		}
+	}
+	//dropped later
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UTPSWorldItemSubsystem::OnActorSpawned));
+}
+
+void UTPSWorldItemSubsystem::OnActorSpawned(AActor* Actor)
+{
+	if (!Actor || !((AmmoClass && Actor->IsA(AmmoClass)) || (WeaponClass && Actor->IsA(WeaponClass))))
+		return;
+
+	//expose on spawn variables (WeaponSlot of a drop) are set after this broadcast
+	GetWorld()->GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateUObject(this, &UTPSWorldItemSubsystem::RegisterPickup, TWeakObjectPtr<AActor>(Actor)));
+}
+
+void UTPSWorldItemSubsystem::RegisterPickup(TWeakObjectPtr<AActor> Actor)
+{
+	AActor* myActor = Actor.Get();
+	if (!myActor || myActor->IsPendingKill() || PickupHandles.Contains(myActor))
+		return;
+
+	ETPSWorldItemKind Kind = ETPSWorldItemKind::Other;
+	EWeaponType WeaponType = EWeaponType::RifleType;
+	if (!ReadPickupType(myActor, Kind, WeaponType))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UTPSWorldItemSubsystem::RegisterPickup - %s has no %s/%s variable"), *myActor->GetName(), *AmmoTypeVariable.ToString(), *WeaponSlotVariable.ToString());
+	}
+
+	PickupHandles.Add(myActor, Register(myActor, Kind, WeaponType));
+	myActor->OnEndPlay.AddDynamic(this, &UTPSWorldItemSubsystem::OnPickupEndPlay);
+}
+
+void UTPSWorldItemSubsystem::OnPickupEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	int32 Handle = INDEX_NONE;
+	if (PickupHandles.RemoveAndCopyValue(Actor, Handle))
+	{
+		Unregister(Handle);
+	}
+}
+
+bool UTPSWorldItemSubsystem::ReadPickupType(AActor* Actor, ETPSWorldItemKind& OutKind, EWeaponType& OutWeaponType) const
+{
+	UClass* myClass = Actor->GetClass();
+	if (AmmoClass && Actor->IsA(AmmoClass))
+	{
+		//blueprint enum variables are byte properties, native ones enum properties
+		FProperty* myProp = myClass->FindPropertyByName(AmmoTypeVariable);
+		const FNumericProperty* myValue = nullptr;
+		if (const FByteProperty* myByte = CastField<FByteProperty>(myProp))
+			myValue = myByte;
+		else if (const FEnumProperty* myEnum = CastField<FEnumProperty>(myProp))
+			myValue = myEnum->GetUnderlyingProperty();
+		if (!myValue)
+			return false;
+
+		OutKind = ETPSWorldItemKind::Ammo;
+		OutWeaponType = (EWeaponType)myValue->GetUnsignedIntPropertyValue(myProp->ContainerPtrToValuePtr<void>(Actor));
+		return true;
+	}
+	if (WeaponClass && Actor->IsA(WeaponClass))
+	{
+		const FStructProperty* myProp = CastField<FStructProperty>(myClass->FindPropertyByName(WeaponSlotVariable));
+		if (!myProp || myProp->Struct != FWeaponSlot::StaticStruct())
+			return false;
+
+		OutKind = ETPSWorldItemKind::Weapon;
+		const FWeaponSlot* mySlot = myProp->ContainerPtrToValuePtr<FWeaponSlot>(Actor);
+		UTPSGameInstance* myGI = Cast<UTPSGameInstance>(GetWorld()->GetGameInstance());
+		FWeaponInfo myInfo;
+		if (myGI && !mySlot->NameItem.IsNone() && myGI->GetWeaponInfoByName(mySlot->NameItem, myInfo))
+		{
+			OutWeaponType = myInfo.WeaponType;
+		}
+		return true;
+	}
+	return false;
+}
+
+FIntPoint UTPSWorldItemSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+int32 UTPSWorldItemSubsystem::Register(AActor* Item, ETPSWorldItemKind Kind, EWeaponType WeaponType)
+{
+	if (!Item)
+		return INDEX_NONE;
+
+	int32 Handle = INDEX_NONE;
+	if (FreeHandles.Num() > 0)
+	{
+		Handle = FreeHandles.Pop(false);
+	}
+	else
+	{
+		Handle = Items.AddDefaulted();
+		Locations.AddDefaulted();
+		ItemCells.AddDefaulted();
+		Kinds.AddDefaulted();
+		WeaponTypes.AddDefaulted();
+	}
+
+	Items[Handle] = Item;
+	Locations[Handle] = Item->GetActorLocation();
+	Kinds[Handle] = Kind;
+	WeaponTypes[Handle] = WeaponType;
+	AddToCell(Handle);
+	return Handle;
+}
+
+void UTPSWorldItemSubsystem::Unregister(int32& Handle)
+{
+	if (IsValidHandle(Handle))
+	{
+		RemoveFromCell(Handle);
+		Items[Handle] = nullptr;
+		FreeHandles.Add(Handle);
+	}
+	Handle = INDEX_NONE;
+}
+
+void UTPSWorldItemSubsystem::UpdateItem(int32 Handle, ETPSWorldItemKind Kind, EWeaponType WeaponType)
+{
+	if (!IsValidHandle(Handle))
+		return;
+
+	Locations[Handle] = Items[Handle]->GetActorLocation();
+	Kinds[Handle] = Kind;
+	WeaponTypes[Handle] = WeaponType;
+	if (GetCell(Locations[Handle]) != ItemCells[Handle])
+	{
+		RemoveFromCell(Handle);
+		AddToCell(Handle);
+	}
+}
+
+void UTPSWorldItemSubsystem::AddToCell(int32 Handle)
+{
+	const FIntPoint Cell = GetCell(Locations[Handle]);
+	ItemCells[Handle] = Cell;
+	Cells.FindOrAdd(Cell).Add(Handle);
+
+	CellsMin = FIntPoint(FMath::Min(CellsMin.X, Cell.X), FMath::Min(CellsMin.Y, Cell.Y));
+	CellsMax = FIntPoint(FMath::Max(CellsMax.X, Cell.X), FMath::Max(CellsMax.Y, Cell.Y));
+}
+
+void UTPSWorldItemSubsystem::RemoveFromCell(int32 Handle)
+{
+	TArray<int32>* myCell = Cells.Find(ItemCells[Handle]);
+	if (!myCell)
+		return;
+
+	myCell->RemoveSingleSwap(Handle, false);
+	if (myCell->Num() == 0)
+	{
+		Cells.Remove(ItemCells[Handle]);
+	}
+}
+
+void UTPSWorldItemSubsystem::GatherCell(const FIntPoint& Cell, const FVector& Location, float RadiusSq, const FTPSWorldItemFilter& Filter, TArray<TPair<float, int32>>& OutCandidates) const
+{
+	const TArray<int32>* myCell = Cells.Find(Cell);
+	if (!myCell)
+		return;
+
+	for (int32 Handle : *myCell)
+	{
+		if (!Filter.Matches(Kinds[Handle], WeaponTypes[Handle]))
+			continue;
+
+		const float DistSq = FVector::DistSquared(Location, Locations[Handle]);
+		if (DistSq <= RadiusSq)
+		{
+			OutCandidates.Emplace(DistSq, Handle);
+		}
+	}
+}
+
+void UTPSWorldItemSubsystem::FindInRadius(const FVector& Location, float Radius, const FTPSWorldItemFilter& Filter, TArray<AActor*>& OutItems) const
+{
+	OutItems.Reset();
+	if (Radius <= 0.0f || Cells.Num() == 0)
+		return;
+
+	const FIntPoint Min = GetCell(Location - FVector(Radius));
+	const FIntPoint Max = GetCell(Location + FVector(Radius));
+	const float RadiusSq = FMath::Square(Radius);
+
+	TArray<TPair<float, int32>> Candidates;
+	for (int32 X = Min.X; X <= Max.X; X++)
+	{
+		for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+		{
+			GatherCell(FIntPoint(X, Y), Location, RadiusSq, Filter, Candidates);
+		}
+	}
+
+	OutItems.Reserve(Candidates.Num());
+	for (const TPair<float, int32>& Candidate : Candidates)
+	{
+		OutItems.Add(Items[Candidate.Value]);
+	}
+}
+
+void UTPSWorldItemSubsystem::FindNearest(const FVector& Location, int32 Count, float MaxRadius, const FTPSWorldItemFilter& Filter, TArray<AActor*>& OutItems) const
+{
+	OutItems.Reset();
+	if (Count <= 0 || Cells.Num() == 0)
+		return;
+
+	const FIntPoint Center = GetCell(Location);
+	const float RadiusSq = MaxRadius > 0.0f ? FMath::Square(MaxRadius) : MAX_flt;
+	//ring that covers the limit, or every cell ever used
+	const int32 MaxRing = MaxRadius > 0.0f
+		? FMath::CeilToInt(MaxRadius / CellSize)
+		: FMath::Max(FMath::Max(FMath::Abs(CellsMin.X - Center.X), FMath::Abs(CellsMax.X - Center.X)),
+			FMath::Max(FMath::Abs(CellsMin.Y - Center.Y), FMath::Abs(CellsMax.Y - Center.Y)));
+
+	TArray<TPair<float, int32>> Candidates;
+	for (int32 Ring = 0; Ring <= MaxRing; Ring++)
+	{
+		if (Ring == 0)
+		{
+			GatherCell(Center, Location, RadiusSq, Filter, Candidates);
+		}
+		else
+		{
+			for (int32 i = -Ring; i <= Ring; i++)
+			{
+				GatherCell(FIntPoint(Center.X + i, Center.Y - Ring), Location, RadiusSq, Filter, Candidates);
+				GatherCell(FIntPoint(Center.X + i, Center.Y + Ring), Location, RadiusSq, Filter, Candidates);
+			}
+			for (int32 i = -Ring + 1; i <= Ring - 1; i++)
+			{
+				GatherCell(FIntPoint(Center.X - Ring, Center.Y + i), Location, RadiusSq, Filter, Candidates);
+				GatherCell(FIntPoint(Center.X + Ring, Center.Y + i), Location, RadiusSq, Filter, Candidates);
+			}
+		}
+
+		//cells past this ring are at least Ring * CellSize away
+		if (Candidates.Num() >= Count)
+		{
+			Candidates.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+			if (Candidates[Count - 1].Key <= FMath::Square(Ring * CellSize))
+				break;
+		}
+	}
+
+	Candidates.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+	const int32 Num = FMath::Min(Count, Candidates.Num());
+	OutItems.Reserve(Num);
+	for (int32 i = 0; i < Num; i++)
+	{
+		OutItems.Add(Items[Candidates[i].Value]);
+	}
+}
+
+TArray<AActor*> UTPSWorldItemSubsystem::BP_FindInRadius(FVector Location, float Radius, ETPSWorldItemKind Kind, EWeaponType WeaponType, bool bAnyWeaponType) const
+{
+	FTPSWorldItemFilter Filter;
+	Filter.Kind = Kind;
+	Filter.WeaponTypeMask = bAnyWeaponType ? MAX_uint32 : 1u << (uint32)WeaponType;
+
+	TArray<AActor*> Result;
+	FindInRadius(Location, Radius, Filter, Result);
+	return Result;
+}
+
+TArray<AActor*> UTPSWorldItemSubsystem::BP_FindNearest(FVector Location, int32 Count, float MaxRadius, ETPSWorldItemKind Kind, EWeaponType WeaponType, bool bAnyWeaponType) const
+{
+	FTPSWorldItemFilter Filter;
+	Filter.Kind = Kind;
+	Filter.WeaponTypeMask = bAnyWeaponType ? MAX_uint32 : 1u << (uint32)WeaponType;
+
+	TArray<AActor*> Result;
+	FindNearest(Location, Count, MaxRadius, Filter, Result);
+	return Result;
+}
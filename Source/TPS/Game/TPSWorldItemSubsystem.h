@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "../FuncLibrary/Types.h"
+#include "TPSWorldItemSubsystem.generated.h"
+
+UENUM(BlueprintType)
+enum class ETPSWorldItemKind : uint8
+{
+	Other,
+	Weapon,
+	Ammo,
+	//queries only
+	Any
+};
+
+//Which items a query returns, WeaponTypeMask bit (1 << EWeaponType)
+struct FTPSWorldItemFilter
+{
+	ETPSWorldItemKind Kind = ETPSWorldItemKind::Any;
+	uint32 WeaponTypeMask = MAX_uint32;
+
+	bool Matches(ETPSWorldItemKind ItemKind, EWeaponType ItemWeaponType) const
+	{
+		return (Kind == ETPSWorldItemKind::Any || Kind == ItemKind) && (WeaponTypeMask & (1u << (uint32)ItemWeaponType)) != 0;
+	}
+};
+
+/**
+ * Pickups on the ground in a uniform 2D hash grid of TPS.WorldItems.CellSize cells.
+ * AWorldItemDefault registers on BeginPlay and unregisters on pickup or EndPlay,
+ * a moved item calls UpdateItem. Queries only visit cells around the location, never the whole list.
+ * Blueprint pickups of AmmoPickupClass/WeaponPickupClass are registered here on spawn, kind and weapon type
+ * read from their own variables, and leave on EndPlay.
+ */
+UCLASS(config = Game)
+class TPS_API UTPSWorldItemSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	//returns handle
+	int32 Register(AActor* Item, ETPSWorldItemKind Kind, EWeaponType WeaponType);
+	void Unregister(int32& Handle);
+	void UpdateItem(int32 Handle, ETPSWorldItemKind Kind, EWeaponType WeaponType);
+
+	//unsorted, every item closer than Radius
+	void FindInRadius(const FVector& Location, float Radius, const FTPSWorldItemFilter& Filter, TArray<AActor*>& OutItems) const;
+	//nearest first, at most Count, MaxRadius <= 0 - no limit
+	void FindNearest(const FVector& Location, int32 Count, float MaxRadius, const FTPSWorldItemFilter& Filter, TArray<AActor*>& OutItems) const;
+
+	UFUNCTION(BlueprintCallable, Category = "WorldItems", meta = (DisplayName = "Find World Items In Radius"))
+	TArray<AActor*> BP_FindInRadius(FVector Location, float Radius, ETPSWorldItemKind Kind, EWeaponType WeaponType, bool bAnyWeaponType = true) const;
+	UFUNCTION(BlueprintCallable, Category = "WorldItems", meta = (DisplayName = "Find Nearest World Items"))
+	TArray<AActor*> BP_FindNearest(FVector Location, int32 Count, float MaxRadius, ETPSWorldItemKind Kind, EWeaponType WeaponType, bool bAnyWeaponType = true) const;
+
+	int32 GetNumItems() const { return Items.Num() - FreeHandles.Num(); }
+
+	//blueprint pickups, variables read on register: ammo type enum and FWeaponSlot of the weapon
+	UPROPERTY(Config)
+	FSoftClassPath AmmoPickupClass;
+	UPROPERTY(Config)
+	FName AmmoTypeVariable = TEXT("WeaponTypeAmmo");
+	UPROPERTY(Config)
+	FSoftClassPath WeaponPickupClass;
+	UPROPERTY(Config)
+	FName WeaponSlotVariable = TEXT("WeaponSlot");
+
+protected:
+	//pickup blueprints
+	void OnActorSpawned(AActor* Actor);
+	void RegisterPickup(TWeakObjectPtr<AActor> Actor);
+	UFUNCTION()
+	void OnPickupEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+	bool ReadPickupType(AActor* Actor, ETPSWorldItemKind& OutKind, EWeaponType& OutWeaponType) const;
+
+	UPROPERTY()
+	UClass* AmmoClass = nullptr;
+	UPROPERTY()
+	UClass* WeaponClass = nullptr;
+	FDelegateHandle ActorSpawnedHandle;
+	TMap<AActor*, int32> PickupHandles;
+
+	bool IsValidHandle(int32 Handle) const { return Items.IsValidIndex(Handle) && Items[Handle] != nullptr; }
+	FIntPoint GetCell(const FVector& Location) const;
+	void AddToCell(int32 Handle);
+	void RemoveFromCell(int32 Handle);
+	//candidates of one cell into OutCandidates as (distance squared, handle)
+	void GatherCell(const FIntPoint& Cell, const FVector& Location, float RadiusSq, const FTPSWorldItemFilter& Filter, TArray<TPair<float, int32>>& OutCandidates) const;
+
+	float CellSize = 500.0f;
+	TMap<FIntPoint, TArray<int32>> Cells;
+	//bounds of every cell ever used, stop for unlimited ring search
+	FIntPoint CellsMin = FIntPoint(MAX_int32, MAX_int32);
+	FIntPoint CellsMax = FIntPoint(MIN_int32, MIN_int32);
+
+	TArray<AActor*> Items;
+	TArray<FVector> Locations;
+	TArray<FIntPoint> ItemCells;
+	TArray<ETPSWorldItemKind> Kinds;
+	TArray<EWeaponType> WeaponTypes;
+	TArray<int32> FreeHandles;
+};
@@ -2,6 +2,87 @@
 
 
 #include "TPS_IGameActor.h"
+#include "Components/MeshComponent.h"
+#include "Materials/MaterialInterface.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+
+void FTPSSurfaceTypeCache::Build(const AActor* Actor, const UPrimitiveComponent* MainComponent)
+{
+	Invalidate();
+	bIsBuilt = true;
+	if (!Actor)
+		return;
+
+	if (MainComponent)
+	{
+		AddComponent(MainComponent);
+	}
+	TInlineComponentArray<UMeshComponent*> myMeshes(Actor);
+	for (const UMeshComponent* Mesh : myMeshes)
+	{
+		if (Mesh != MainComponent)
+		{
+			AddComponent(Mesh);
+		}
+	}
+}
+
+FTPSSurfaceTypeCache::FComponentSlots& FTPSSurfaceTypeCache::AddComponent(const UPrimitiveComponent* Component)
+{
+	FComponentSlots& myEntry = Components.AddDefaulted_GetRef();
+	myEntry.Component = Component;
+	myEntry.Slots.SetNum(Component->GetNumMaterials());
+	for (int32 i = 0; i < myEntry.Slots.Num(); i++)
+	{
+		UMaterialInterface* myMaterial = Component->GetMaterial(i);
+		myEntry.Slots[i].Material = myMaterial;
+		myEntry.Slots[i].SurfaceType = Resolve(myMaterial);
+	}
+	return myEntry;
+}
+
+EPhysicalSurface FTPSSurfaceTypeCache::Resolve(UMaterialInterface* Material)
+{
+	UPhysicalMaterial* myPhysMaterial = Material ? Material->GetPhysicalMaterial() : nullptr;
+	return myPhysMaterial ? myPhysMaterial->SurfaceType.GetValue() : EPhysicalSurface::SurfaceType_Default;
+}
+
+EPhysicalSurface FTPSSurfaceTypeCache::Get(const UPrimitiveComponent* Component, int32 MaterialIndex)
+{
+	FComponentSlots* myEntry = nullptr;
+	if (!Component)
+	{
+		myEntry = Components.Num() > 0 ? &Components[0] : nullptr;
+	}
+	else
+	{
+		myEntry = Components.FindByPredicate([Component](const FComponentSlots& Elem) { return Elem.Component == Component; });
+		//component created after Build
+		if (!myEntry)
+			myEntry = &AddComponent(Component);
+	}
+
+	const UPrimitiveComponent* myComponent = myEntry ? myEntry->Component.Get() : nullptr;
+	if (!myComponent || MaterialIndex < 0)
+		return EPhysicalSurface::SurfaceType_Default;
+
+	if (MaterialIndex >= myEntry->Slots.Num())
+	{
+		//mesh with more slots set since Build
+		if (MaterialIndex >= myComponent->GetNumMaterials())
+			return EPhysicalSurface::SurfaceType_Default;
+		myEntry->Slots.SetNum(myComponent->GetNumMaterials());
+	}
+
+	FSlot& mySlot = myEntry->Slots[MaterialIndex];
+	UMaterialInterface* myMaterial = myComponent->GetMaterial(MaterialIndex);
+	if (mySlot.Material.Get() != myMaterial)
+	{
+		mySlot.Material = myMaterial;
+		mySlot.SurfaceType = Resolve(myMaterial);
+	}
+	return mySlot.SurfaceType;
+}
 
 // Add default functionality here for any ITPS_IGameActor functions that are not pure virtual.
 
@@ -10,6 +91,16 @@ EPhysicalSurface ITPS_IGameActor::GetSurfuceType()
 	return EPhysicalSurface::SurfaceType_Default;
 }
 
+EPhysicalSurface ITPS_IGameActor::GetCachedSurfaceType(const UPrimitiveComponent* Component, int32 MaterialIndex)
+{
+	return GetSurfuceType();
+}
+
+void ITPS_IGameActor::InvalidateSurfaceTypeCache()
+{
+
+}
+
 TArray<UTPS_StateEffect*> ITPS_IGameActor::GetAllCurrentEffects()
 {
 	TArray<UTPS_StateEffect*> Effect;
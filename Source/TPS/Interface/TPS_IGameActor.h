@@ -7,6 +7,45 @@
 #include "../StateEffects/TPS_StateEffect.h"
 #include "TPS_IGameActor.generated.h"
 
+class UPrimitiveComponent;
+class UMaterialInterface;
+
+/**
+ * Surface type per material slot of an actor's mesh components, built once at BeginPlay instead of
+ * walking mesh, material and physical material on every hit. Each lookup compares the slot's current
+ * material with the cached one, a swapped material is resolved again on that lookup.
+ */
+struct TPS_API FTPSSurfaceTypeCache
+{
+	//every mesh component of Actor, MainComponent (nullptr - the first one) answers lookups without a component
+	void Build(const AActor* Actor, const UPrimitiveComponent* MainComponent = nullptr);
+	//after mesh components were added, removed or got another mesh
+	void Invalidate() { Components.Reset(); bIsBuilt = false; }
+	bool IsBuilt() const { return bIsBuilt; }
+
+	//unknown slot or no material - SurfaceType_Default
+	EPhysicalSurface Get(const UPrimitiveComponent* Component = nullptr, int32 MaterialIndex = 0);
+
+protected:
+	struct FSlot
+	{
+		TWeakObjectPtr<UMaterialInterface> Material;
+		EPhysicalSurface SurfaceType = EPhysicalSurface::SurfaceType_Default;
+	};
+	struct FComponentSlots
+	{
+		TWeakObjectPtr<const UPrimitiveComponent> Component;
+		TArray<FSlot, TInlineAllocator<4>> Slots;
+	};
+
+	FComponentSlots& AddComponent(const UPrimitiveComponent* Component);
+	static EPhysicalSurface Resolve(UMaterialInterface* Material);
+
+	//main component first
+	TArray<FComponentSlots, TInlineAllocator<2>> Components;
+	bool bIsBuilt = false;
+};
+
 // This class does not need to be modified.
 UINTERFACE(MinimalAPI)
 class UTPS_IGameActor : public UInterface
@@ -30,6 +69,9 @@ public:
 	//	bool AviableForEffects();	
 
 	virtual EPhysicalSurface GetSurfuceType();
+	//surface of a material slot, Component nullptr - the actor's main mesh, implementers answer from their FTPSSurfaceTypeCache
+	virtual EPhysicalSurface GetCachedSurfaceType(const UPrimitiveComponent* Component = nullptr, int32 MaterialIndex = 0);
+	virtual void InvalidateSurfaceTypeCache();
 
 	virtual TArray<UTPS_StateEffect*> GetAllCurrentEffects();
 	virtual void RemoveEffect(UTPS_StateEffect* RemoveEffect);
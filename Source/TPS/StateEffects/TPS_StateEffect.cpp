@@ -6,9 +6,11 @@
 #include "../Character/TPSCharacterHealthComponent.h"
 #include "../Interface/TPS_IGameActor.h"
 #include "Kismet/GameplayStatics.h"
+#include "../TPS.h"
 
 bool UTPS_StateEffect::InitObject(AActor* Actor)
 {
+	CSV_CUSTOM_STAT(TPS, EffectsApplied, 1, ECsvCustomStatOp::Accumulate);
 
 	myActor = Actor;
 
@@ -66,10 +68,15 @@ bool UTPS_StateEffect_ExecuteTimer::InitObject(AActor* Actor)
 {
 	Super::InitObject(Actor);
 
-	GetWorld()->GetTimerManager().SetTimer(TimerHandle_EffectTimer, this, &UTPS_StateEffect_ExecuteTimer::DestroyObject, Timer, false);
-	GetWorld()->GetTimerManager().SetTimer(TimerHandle_ExecuteTimer, this, &UTPS_StateEffect_ExecuteTimer::Execute, RateTime, true);
+	ElapsedTime = 0.0f;
+	ExecuteAccumulator = 0.0f;
+	UTPSFixedStepSubsystem* myFixedStep = GetWorld()->GetSubsystem<UTPSFixedStepSubsystem>();
+	if (myFixedStep)
+	{
+		FixedStepHandle = myFixedStep->Register(this);
+	}
 	
-	if (ParticleEffect)
+	if (ParticleEffect && TPSShouldPlayCosmetics(GetWorld()))
 	{
 		FName NameBoneToAttached;
 		FVector Loc = FVector(0);
@@ -85,15 +92,52 @@ bool UTPS_StateEffect_ExecuteTimer::InitObject(AActor* Actor)
 	return true;
 }
 
+float UTPS_StateEffect_ExecuteTimer::GetRemainingTime() const
+{
+	if (FixedStepHandle != INDEX_NONE)
+	{
+		return FMath::Max(Timer - ElapsedTime, 0.0f);
+	}
+	return Timer;
+}
+
+void UTPS_StateEffect_ExecuteTimer::FixedStep(float StepTime)
+{
+	ElapsedTime += StepTime;
+	ExecuteAccumulator += StepTime;
+
+	//ticks due by the end, RateTime below the step runs several per step
+	const float Rate = FMath::Max(RateTime, KINDA_SMALL_NUMBER);
+	while (ExecuteAccumulator >= Rate && FixedStepHandle != INDEX_NONE)
+	{
+		ExecuteAccumulator -= Rate;
+		Execute();
+	}
+
+	if (ElapsedTime >= Timer && FixedStepHandle != INDEX_NONE)
+	{
+		DestroyObject();
+	}
+}
+
 void UTPS_StateEffect_ExecuteTimer::DestroyObject()
 {
-	UTPSCharacterHealthComponent* myCharHealthComp = Cast<UTPSCharacterHealthComponent>(myActor->GetComponentByClass(UTPSCharacterHealthComponent::StaticClass()));
+	//may be removed before the effect time ends (save restore)
+	UTPSFixedStepSubsystem* myFixedStep = GetWorld() ? GetWorld()->GetSubsystem<UTPSFixedStepSubsystem>() : nullptr;
+	if (myFixedStep)
+	{
+		myFixedStep->Unregister(FixedStepHandle);
+	}
+	UTPSCharacterHealthComponent* myCharHealthComp = myActor ? Cast<UTPSCharacterHealthComponent>(myActor->GetComponentByClass(UTPSCharacterHealthComponent::StaticClass())) : nullptr;
 	if (myCharHealthComp)
 	{
 		myCharHealthComp->HealthChangeBlock = 0;
 	}
-	ParticleEmitter->DestroyComponent();
-	ParticleEmitter = nullptr;
+	if (ParticleEmitter)
+	{
+		ParticleEmitter->DestroyComponent();
+		ParticleEmitter = nullptr;
+	}
 	Super::DestroyObject();
 }
 
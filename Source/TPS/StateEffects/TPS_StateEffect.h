@@ -6,6 +6,7 @@
 #include "UObject/NoExportTypes.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "Particles/ParticleSystemComponent.h"
+#include "../Game/TPSFixedStepSubsystem.h"
 #include "TPS_StateEffect.generated.h"
 
 /**
@@ -20,6 +21,10 @@ public:
 	
 	virtual bool InitObject(AActor* Actor);
 	virtual void DestroyObject();
+	//seconds until the effect ends by itself, < 0 - until removed
+	virtual float GetDuration() const { return -1.0f; }
+	//seconds left of GetDuration, < 0 - until removed
+	virtual float GetRemainingTime() const { return GetDuration(); }
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Setting")
 	TArray<TEnumAsByte<EPhysicalSurface>> PossibleInteractSurface;
@@ -28,6 +33,8 @@ public:
 	bool bIsStakable = false;
 
 	AActor* myActor = nullptr;
+	//FTPSActiveEffectRep::InstanceId on the owner, 0 - not replicated
+	int32 RepInstanceId = 0;
 };
 
 UCLASS()
@@ -45,8 +52,9 @@ public:
 	float Power = 20.0f;
 };
 
+//Execute every RateTime for Timer seconds, counted in fixed gameplay steps
 UCLASS()
-class TPS_API UTPS_StateEffect_ExecuteTimer : public UTPS_StateEffect
+class TPS_API UTPS_StateEffect_ExecuteTimer : public UTPS_StateEffect, public ITPSFixedStepTarget
 {
 	GENERATED_BODY()
 
@@ -54,8 +62,11 @@ public:
 
 	bool InitObject(AActor* Actor) override;
 	void DestroyObject() override;
+	void FixedStep(float StepTime) override;
 
 	virtual void Execute();
+	float GetDuration() const override { return Timer; }
+	float GetRemainingTime() const override;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Setting ExecuteTimer")
 	float Power = 20.0f;
@@ -66,8 +77,9 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Setting ExecuteTimer")
 	float RateTime = 1.0f;
 
-	FTimerHandle TimerHandle_ExecuteTimer;
-	FTimerHandle TimerHandle_EffectTimer;
+	int32 FixedStepHandle = INDEX_NONE;
+	float ElapsedTime = 0.0f;
+	float ExecuteAccumulator = 0.0f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Setting ExecuteTimer")
 	UParticleSystem* ParticleEffect = nullptr;
 
@@ -2,8 +2,7 @@
 
 
 #include "TPS_EnvironmentStructure.h"
-#include "Materials/MaterialInterface.h"
-#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Components/StaticMeshComponent.h"
 
 // Sets default values
 ATPS_EnvironmentStructure::ATPS_EnvironmentStructure()
@@ -11,6 +10,9 @@ ATPS_EnvironmentStructure::ATPS_EnvironmentStructure()
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
+	//placed in level, client has it from map load until something changes
+	bReplicates = true;
+	NetDormancy = DORM_Initial;
 }
 
 // Called when the game starts or when spawned
@@ -18,6 +20,23 @@ void ATPS_EnvironmentStructure::BeginPlay()
 {
 	Super::BeginPlay();
 	
+	SurfaceTypeCache.Build(this, FindComponentByClass<UStaticMeshComponent>());
+}
+
+void ATPS_EnvironmentStructure::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//timer effects step on the fixed clock, they end with the owner
+	const TArray<UTPS_StateEffect*> myEffects = Effects;
+	for (UTPS_StateEffect* myEffect : myEffects)
+	{
+		if (myEffect)
+		{
+			myEffect->DestroyObject();
+		}
+	}
+	Effects.Empty();
+
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
@@ -29,18 +48,23 @@ void ATPS_EnvironmentStructure::Tick(float DeltaTime)
 
 EPhysicalSurface ATPS_EnvironmentStructure::GetSurfuceType()
 {
-	EPhysicalSurface Result = EPhysicalSurface::SurfaceType_Default;
-	UStaticMeshComponent* myMesh = Cast<UStaticMeshComponent>(GetComponentByClass(UStaticMeshComponent::StaticClass()));
-	if (myMesh)
+	return GetCachedSurfaceType(nullptr, 0);
+}
+
+EPhysicalSurface ATPS_EnvironmentStructure::GetCachedSurfaceType(const UPrimitiveComponent* Component, int32 MaterialIndex)
+{
+	if (!SurfaceTypeCache.IsBuilt())
 	{
-		UMaterialInterface* myMaterial = myMesh->GetMaterial(0);
-		if (myMaterial)
-		{
-			Result = myMaterial->GetPhysicalMaterial()->SurfaceType;
-		}
+		SurfaceTypeCache.Build(this, FindComponentByClass<UStaticMeshComponent>());
 	}
-	return Result;
+	return SurfaceTypeCache.Get(Component, MaterialIndex);
+}
+
+void ATPS_EnvironmentStructure::InvalidateSurfaceTypeCache()
+{
+	SurfaceTypeCache.Invalidate();
 }
+
 TArray<UTPS_StateEffect*> ATPS_EnvironmentStructure::GetAllCurrentEffects()
 {
 	return Effects;
@@ -49,9 +73,20 @@ TArray<UTPS_StateEffect*> ATPS_EnvironmentStructure::GetAllCurrentEffects()
 void ATPS_EnvironmentStructure::RemoveEffect(UTPS_StateEffect* RemoveEffect)
 {
 	Effects.Remove(RemoveEffect);
+	if (HasAuthority())
+		FlushNetDormancy();
 }
 
 void ATPS_EnvironmentStructure::AddEffect(UTPS_StateEffect* newEffect)
 {
 	Effects.Add(newEffect);
+	if (HasAuthority())
+		FlushNetDormancy();
+}
+
+float ATPS_EnvironmentStructure::TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser)
+{
+	if (HasAuthority())
+		FlushNetDormancy();
+	return Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
 }
\ No newline at end of file
@@ -20,13 +20,18 @@ public:
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
+
 
 	EPhysicalSurface GetSurfuceType() override;	
+	EPhysicalSurface GetCachedSurfaceType(const UPrimitiveComponent* Component = nullptr, int32 MaterialIndex = 0) override;
+	void InvalidateSurfaceTypeCache() override;
 	
 	TArray<UTPS_StateEffect*> GetAllCurrentEffects() override;
 	void RemoveEffect(UTPS_StateEffect* RemoveEffect)override;
@@ -35,4 +40,8 @@ public:
 	//Effect
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Setting")
 	TArray<UTPS_StateEffect*> Effects;
+
+protected:
+	//first static mesh is the main one
+	FTPSSurfaceTypeCache SurfaceTypeCache;
 };
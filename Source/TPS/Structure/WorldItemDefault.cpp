@@ -6,22 +6,64 @@
 // Sets default values
 AWorldItemDefault::AWorldItemDefault()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	//nothing to do per frame, pickups are found through UTPSWorldItemSubsystem (blueprints with Event Tick still tick)
+	PrimaryActorTick.bCanEverTick = false;
 
+	bReplicates = true;
+	NetDormancy = DORM_DormantAll;
 }
 
 // Called when the game starts or when spawned
 void AWorldItemDefault::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	UTPSWorldItemSubsystem* myItems = GetWorld()->GetSubsystem<UTPSWorldItemSubsystem>();
+	if (myItems)
+	{
+		RegistryHandle = myItems->Register(this, ItemKind, ItemWeaponType);
+	}
+}
+
+void AWorldItemDefault::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	PickedUp();
+	Super::EndPlay(EndPlayReason);
+}
+
+void AWorldItemDefault::PickedUp()
+{
+	UTPSWorldItemSubsystem* myItems = GetWorld() ? GetWorld()->GetSubsystem<UTPSWorldItemSubsystem>() : nullptr;
+	if (myItems)
+	{
+		myItems->Unregister(RegistryHandle);
+	}
 }
 
-// Called every frame
-void AWorldItemDefault::Tick(float DeltaTime)
+void AWorldItemDefault::UpdateRegistry()
 {
-	Super::Tick(DeltaTime);
+	UTPSWorldItemSubsystem* myItems = GetWorld()->GetSubsystem<UTPSWorldItemSubsystem>();
+	if (myItems)
+	{
+		myItems->UpdateItem(RegistryHandle, ItemKind, ItemWeaponType);
+	}
+}
 
+void AWorldItemDefault::NotifyActorBeginOverlap(AActor* OtherActor)
+{
+	//pick up starts here
+	WakeReplication();
+	Super::NotifyActorBeginOverlap(OtherActor);
 }
 
+float AWorldItemDefault::TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser)
+{
+	WakeReplication();
+	return Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+}
+
+void AWorldItemDefault::WakeReplication()
+{
+	if (HasAuthority())
+		FlushNetDormancy();
+}
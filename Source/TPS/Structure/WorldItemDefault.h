@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "../Game/TPSWorldItemSubsystem.h"
 #include "WorldItemDefault.generated.h"
 
 UCLASS()
@@ -18,9 +19,30 @@ public:
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	//UTPSWorldItemSubsystem entry
+	int32 RegistryHandle = INDEX_NONE;
 
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	//what proximity queries see, set by the subclass (Pickup_Ammo/Pickup_Weapon are registered from their own variables instead)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item")
+	ETPSWorldItemKind ItemKind = ETPSWorldItemKind::Other;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item")
+	EWeaponType ItemWeaponType = EWeaponType::RifleType;
+
+	//leaves the pickup grid, call when taken, the actor may live on for FX
+	UFUNCTION(BlueprintCallable, Category = "Item")
+	void PickedUp();
+	//after moving the item or changing ItemKind/ItemWeaponType
+	UFUNCTION(BlueprintCallable, Category = "Item")
+	void UpdateRegistry();
+
+	virtual void NotifyActorBeginOverlap(AActor* OtherActor) override;
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
+
+	//dormant until something happens to the item, call before changing replicated state
+	UFUNCTION(BlueprintCallable, Category = "Net")
+	void WakeReplication();
 
 };
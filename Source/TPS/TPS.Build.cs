@@ -10,5 +10,7 @@ public class TPS : ModuleRules
 
         PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", 
 			"HeadMountedDisplay", "NavigationSystem", "AIModule", "PhysicsCore", "Slate" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "RenderCore", "NetCore", "ReplicationGraph", "SlateCore" });
     }
 }
@@ -6,4 +6,7 @@
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, TPS, "TPS" );
 
 DEFINE_LOG_CATEGORY(LogTPS)
- 
\ No newline at end of file
+
+CSV_DEFINE_CATEGORY(TPS, true);
+
+int32 GTPSServerRPCCount = 0;
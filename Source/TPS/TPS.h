@@ -3,5 +3,29 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Engine/World.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTPS, Log, All);
+
+CSV_DECLARE_CATEGORY_EXTERN(TPS);
+
+//server RPCs received since start, read by ATPSBotSwarmGameMode
+extern TPS_API int32 GTPSServerRPCCount;
+
+inline void TPSCountServerRPC()
+{
+	GTPSServerRPCCount++;
+	CSV_CUSTOM_STAT(TPS, ServerRPCs, 1, ECsvCustomStatOp::Accumulate);
+}
+
+//FX, sounds, decals, drop meshes and debug draw, never on dedicated server (UE_SERVER strips it at compile time)
+//gameplay state must not depend on it, see AWeaponDefault::OnWeaponFired
+inline bool TPSShouldPlayCosmetics(const UWorld* World)
+{
+#if UE_SERVER
+	return false;
+#else
+	return World && World->GetNetMode() != NM_DedicatedServer;
+#endif
+}
@@ -2,6 +2,10 @@
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "Kismet/GameplayStatics.h"
 #include "Engine/GameEngine.h"
+#include "../TPS.h"
+#include "../FuncLibrary/TPSTelemetry.h"
+#include "Net/UnrealNetwork.h"
+#include "../Game/TPSGameInstance.h"
 
 // Sets default values
 AProjectileDefault::AProjectileDefault()
@@ -40,6 +44,9 @@ AProjectileDefault::AProjectileDefault()
 
 	BulletProjectileMovement->bRotationFollowsVelocity = true;
 	BulletProjectileMovement->bShouldBounce = true;
+
+	bReplicates = true;
+	SetReplicateMovement(true);
 }
 
 // Called when the game starts or when spawned
@@ -49,6 +56,23 @@ void AProjectileDefault::BeginPlay()
 
 }
 
+void AProjectileDefault::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(AProjectileDefault, WeaponIdName, COND_InitialOnly);
+}
+
+void AProjectileDefault::OnRep_WeaponIdName()
+{
+	UTPSGameInstance* myGI = Cast<UTPSGameInstance>(GetGameInstance());
+	FWeaponInfo myWeaponInfo;
+	if (myGI && myGI->GetWeaponInfoByName(WeaponIdName, myWeaponInfo))
+	{
+		InitProjectile(myWeaponInfo.ProjectileSetting);
+	}
+}
+
 // Called every frame
 void AProjectileDefault::Tick(float DeltaTime)
 {
@@ -61,8 +85,9 @@ void AProjectileDefault::BulletCollisionSphereHit(UPrimitiveComponent* HitComp,
 	if (OtherActor && Hit.PhysMaterial.IsValid())
 	{
 		EPhysicalSurface mySurfacetype = UGameplayStatics::GetSurfaceType(Hit);
+		const bool bIsCosmetic = TPSShouldPlayCosmetics(GetWorld());
 
-		if (ProjectileSetting.HitDecals.Contains(mySurfacetype))
+		if (bIsCosmetic && ProjectileSetting.HitDecals.Contains(mySurfacetype))
 		{
 			UMaterialInterface* myMaterial = ProjectileSetting.HitDecals[mySurfacetype];
 
@@ -71,7 +96,7 @@ void AProjectileDefault::BulletCollisionSphereHit(UPrimitiveComponent* HitComp,
 				UGameplayStatics::SpawnDecalAttached(myMaterial, FVector(20.0f), OtherComp, NAME_None, Hit.ImpactPoint, Hit.ImpactNormal.Rotation(), EAttachLocation::KeepWorldPosition, 10.0f);
 			}
 		}
-		if (ProjectileSetting.HitFXs.Contains(mySurfacetype))
+		if (bIsCosmetic && ProjectileSetting.HitFXs.Contains(mySurfacetype))
 		{
 			UParticleSystem* myParticle = ProjectileSetting.HitFXs[mySurfacetype];
 			if (myParticle)
@@ -80,13 +105,22 @@ void AProjectileDefault::BulletCollisionSphereHit(UPrimitiveComponent* HitComp,
 			}
 		}
 
-		if (ProjectileSetting.HitSound)
+		if (bIsCosmetic && ProjectileSetting.HitSound)
 		{
 			UGameplayStatics::PlaySoundAtLocation(GetWorld(), ProjectileSetting.HitSound, Hit.ImpactPoint);
 		}
-		UTypes::AddEffectBySurfaceType(Hit.GetActor(), ProjectileSetting.Effect, mySurfacetype);
+		if (HasAuthority())
+			UTypes::AddEffectBySurfaceType(Hit.GetActor(), ProjectileSetting.Effect, mySurfacetype);
+	}
+	if (HasAuthority() && FTPSTelemetry::IsEnabled())
+	{
+		const bool bHasSurface = OtherActor && Hit.PhysMaterial.IsValid();
+		FTPSTelemetry::Record(GetWorld(), ETPSTelemetryType::ProjectileHit, WeaponIdName, Hit.ImpactPoint, GetVelocity().GetSafeNormal(), OtherActor,
+			bHasSurface ? UGameplayStatics::GetSurfaceType(Hit) : SurfaceType_Default, ProjectileSetting.ProjectileDamage,
+			bHasSurface ? ProjectileSetting.Effect.Get() : nullptr);
 	}
-	UGameplayStatics::ApplyPointDamage(OtherActor, ProjectileSetting.ProjectileDamage, Hit.TraceStart, Hit, GetInstigatorController(), this, NULL);
+	if (HasAuthority())
+		UGameplayStatics::ApplyPointDamage(OtherActor, ProjectileSetting.ProjectileDamage, Hit.TraceStart, Hit, GetInstigatorController(), this, NULL);
 	//UGameplayStatics::ApplyDamage(OtherActor, ProjectileSetting.ProjectileDamage, GetInstigatorController(), this, NULL);
 	ImpactProjectile();
 }
@@ -113,7 +147,7 @@ void AProjectileDefault::InitProjectile(FProjectileInfo InitParam)
 	{
 		BulletMesh->DestroyComponent();
 	}
-	if (ProjectileSetting.ProjectileTrailFx)
+	if (ProjectileSetting.ProjectileTrailFx && TPSShouldPlayCosmetics(GetWorld()))
 	{
 		BulletFX->SetTemplate(ProjectileSetting.ProjectileTrailFx);
 	}
@@ -125,6 +159,8 @@ void AProjectileDefault::InitProjectile(FProjectileInfo InitParam)
 
 void AProjectileDefault::ImpactProjectile()
 {
-	this->Destroy();
+	//server destroys, replication removes client copy
+	if (HasAuthority())
+		this->Destroy();
 }
 
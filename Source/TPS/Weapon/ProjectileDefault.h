@@ -28,12 +28,20 @@ public:
 	class UParticleSystemComponent* BulletFX = nullptr;
 	UPROPERTY(BlueprintReadOnly)
 	FProjectileInfo ProjectileSetting;
+	//row in DT_WeaponInfo, clients build ProjectileSetting by it
+	UPROPERTY(ReplicatedUsing = OnRep_WeaponIdName, BlueprintReadOnly)
+	FName WeaponIdName;
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	UFUNCTION()
+	void OnRep_WeaponIdName();
+
 public:
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
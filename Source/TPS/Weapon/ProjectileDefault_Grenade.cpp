@@ -3,15 +3,9 @@
 
 #include "ProjectileDefault_Grenade.h"
 #include "Kismet/GameplayStatics.h"
-#include "DrawDebugHelpers.h"
-
-int32 DebugExplodeShow = 0;
-FAutoConsoleVariableRef CVARExplodeShow{
-	TEXT("TPS.DebugExplode"),
-	DebugExplodeShow,
-	TEXT("Draw Debug for Explode"),
-	ECVF_Cheat
-};
+#include "../TPS.h"
+#include "../FuncLibrary/TPSDebugDraw.h"
+#include "../FuncLibrary/TPSTelemetry.h"
 
 void AProjectileDefault_Grenade::BeginPlay()
 {
@@ -21,7 +15,8 @@ void AProjectileDefault_Grenade::BeginPlay()
 void AProjectileDefault_Grenade::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
-	TimerExplose(DeltaTime);
+	if (HasAuthority())
+		TimerExplose(DeltaTime);
 
 }
 
@@ -55,20 +50,12 @@ void AProjectileDefault_Grenade::ImpactProjectile()
 
 void AProjectileDefault_Grenade::Explose()
 {
-	if (DebugExplodeShow)
-	{
-		DrawDebugSphere(GetWorld(), GetActorLocation(), ProjectileSetting.ProjectileMinRadiusDamage, 12, FColor::Green, false, 12.0f);
-		DrawDebugSphere(GetWorld(), GetActorLocation(), ProjectileSetting.ProjectileMaxRadiusDamage, 12, FColor::Red, false, 12.0f);
-	}
+	TPS_DEBUG_SPHERE(GetWorld(), Explosion, GetActorLocation(), ProjectileSetting.ProjectileMinRadiusDamage, FColor::Green, 12.0f);
+	TPS_DEBUG_SPHERE(GetWorld(), Explosion, GetActorLocation(), ProjectileSetting.ProjectileMaxRadiusDamage, FColor::Red, 12.0f);
 	TimerEnabled = false;
-	if (ProjectileSetting.ExploseFX)
-	{
-		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ProjectileSetting.ExploseFX, GetActorLocation(), GetActorRotation(), FVector(1.0f));
-	}
-	if (ProjectileSetting.ExploseSound)
-	{
-		UGameplayStatics::PlaySoundAtLocation(GetWorld(), ProjectileSetting.ExploseSound, GetActorLocation());
-	}
+	if (FTPSTelemetry::IsEnabled())
+		FTPSTelemetry::Record(GetWorld(), ETPSTelemetryType::Explosion, WeaponIdName, GetActorLocation(), FVector::ZeroVector, nullptr, SurfaceType_Default, ProjectileSetting.ExplodeMaxDamage, nullptr);
+	MulticastExploseFX(GetActorLocation());
 	TArray<AActor*> IgnoredActor;
 	UGameplayStatics::ApplyRadialDamageWithFalloff(GetWorld(),
 		ProjectileSetting.ExplodeMaxDamage,
@@ -81,3 +68,18 @@ void AProjectileDefault_Grenade::Explose()
 
 	this->Destroy();
 }
+
+void AProjectileDefault_Grenade::MulticastExploseFX_Implementation(FVector_NetQuantize Location)
+{
+	if (!TPSShouldPlayCosmetics(GetWorld()))
+		return;
+
+	if (ProjectileSetting.ExploseFX)
+	{
+		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ProjectileSetting.ExploseFX, Location, GetActorRotation(), FVector(1.0f));
+	}
+	if (ProjectileSetting.ExploseSound)
+	{
+		UGameplayStatics::PlaySoundAtLocation(GetWorld(), ProjectileSetting.ExploseSound, Location);
+	}
+}
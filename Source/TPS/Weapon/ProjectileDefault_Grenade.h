@@ -30,6 +30,8 @@ public:
 	virtual void ImpactProjectile() override;
 
 	void Explose();
+	UFUNCTION(NetMulticast, Reliable)
+	void MulticastExploseFX(FVector_NetQuantize Location);
 
 	bool TimerEnabled = false;
 	float TimerToExplose = 0.0f;
@@ -0,0 +1,208 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TPSWeaponSim.h"
+
+void FTPSWeaponSim::Init(const FWeaponInfo& Info, int32 InRound, int32 Seed)
+{
+	Round = InRound;
+	bFiring = false;
+	bReloading = false;
+	FireTimer = 0.0f;
+	ReloadTimer = Info.ReloadTime;
+	Time = 0.0f;
+	Stream.Initialize(Seed);
+}
+
+void FTPSWeaponSim::SetMovementState(const FWeaponInfo& Info, EMovementState NewMovementState)
+{
+	bBlockFire = false;
+
+	const FWeaponDispersion& myDispersion = Info.DispersionWeapon;
+	switch (NewMovementState)
+	{
+	case EMovementState::Aim_State:
+		DispersionMax = myDispersion.Aim_StateDispersionAimMax;
+		DispersionMin = myDispersion.Aim_StateDispersionAimMin;
+		DispersionRecoil = myDispersion.Aim_StateDispersionAimRecoil;
+		DispersionReduction = myDispersion.Aim_StateDispersionReduction;
+		break;
+	case EMovementState::AimWalk_State:
+		DispersionMax = myDispersion.AimWalk_StateDispersionAimMax;
+		DispersionMin = myDispersion.AimWalk_StateDispersionAimMin;
+		DispersionRecoil = myDispersion.AimWalk_StateDispersionAimRecoil;
+		DispersionReduction = myDispersion.Aim_StateDispersionReduction;
+		break;
+	case EMovementState::Walk_State:
+		DispersionMax = myDispersion.Walk_StateDispersionAimMax;
+		DispersionMin = myDispersion.Walk_StateDispersionAimMin;
+		DispersionRecoil = myDispersion.Walk_StateDispersionAimRecoil;
+		DispersionReduction = myDispersion.Aim_StateDispersionReduction;
+		break;
+	case EMovementState::Run_State:
+		DispersionMax = myDispersion.Run_StateDispersionAimMax;
+		DispersionMin = myDispersion.Run_StateDispersionAimMin;
+		DispersionRecoil = myDispersion.Run_StateDispersionAimRecoil;
+		DispersionReduction = myDispersion.Aim_StateDispersionReduction;
+		break;
+	case EMovementState::Sprint_State:
+		bBlockFire = true;
+		SetFiring(false);
+		break;
+	default:
+		break;
+	}
+}
+
+void FTPSWeaponSim::SetFiring(bool bIsFire)
+{
+	bFiring = bIsFire && !bBlockFire;
+	FireTimer = 0.01f;
+}
+
+uint8 FTPSWeaponSim::TickFire(const FWeaponInfo& Info, float DeltaTime)
+{
+	if (!CanFire())
+		return 0;
+
+	if (FireTimer >= 0.0f)
+	{
+		FireTimer -= DeltaTime;
+		return 0;
+	}
+
+	//all rounds due this step go in one batch
+	uint8 ShotCount = 0;
+	while (FireTimer < 0.0f && ShotCount < Round && ShotCount < MaxShotCount)
+	{
+		ShotCount++;
+		FireTimer += FMath::Max(Info.RateOfFire, 0.01f);
+	}
+	return ShotCount;
+}
+
+bool FTPSWeaponSim::TickReload(float DeltaTime)
+{
+	if (!bReloading)
+		return false;
+
+	if (ReloadTimer < 0.0f)
+		return true;
+
+	ReloadTimer -= DeltaTime;
+	return false;
+}
+
+void FTPSWeaponSim::TickDispersion()
+{
+	if (bReloading)
+		return;
+
+	if (!bFiring)
+	{
+		Dispersion += bReduceDispersion ? -DispersionReduction : DispersionReduction;
+	}
+	Dispersion = FMath::Clamp(Dispersion, DispersionMin, DispersionMax);
+}
+
+uint8 FTPSWeaponSim::TickDrops(float DeltaTime)
+{
+	uint8 Result = 0;
+	if (bDropClip)
+	{
+		if (DropClipTimer < 0.0f)
+		{
+			bDropClip = false;
+			Result |= DropClip;
+		}
+		else
+		{
+			DropClipTimer -= DeltaTime;
+		}
+	}
+	if (bDropShell)
+	{
+		if (DropShellTimer < 0.0f)
+		{
+			bDropShell = false;
+			Result |= DropShell;
+		}
+		else
+		{
+			DropShellTimer -= DeltaTime;
+		}
+	}
+	return Result;
+}
+
+void FTPSWeaponSim::ConsumeShots(uint8 ShotCount)
+{
+	Round -= ShotCount;
+	Dispersion += DispersionRecoil * ShotCount;
+}
+
+FTPSWeaponShotEvent FTPSWeaponSim::MakeShotEvent(uint8 ShotCount)
+{
+	FTPSWeaponShotEvent Event;
+	Event.Time = Time;
+	Event.Seed = (int32)Stream.GetUnsignedInt();
+	Event.Dispersion = Dispersion;
+	Event.ShotCount = ShotCount;
+	return Event;
+}
+
+void FTPSWeaponSim::StartReload(const FWeaponInfo& Info)
+{
+	bReloading = true;
+	ReloadTimer = Info.ReloadTime;
+}
+
+int32 FTPSWeaponSim::FinishReload(const FWeaponInfo& Info, int32 AvailableAmmo)
+{
+	bReloading = false;
+
+	const int32 NeedToReload = Info.MaxRound - Round;
+	if (NeedToReload > AvailableAmmo)
+	{
+		Round = AvailableAmmo;
+		return AvailableAmmo;
+	}
+	Round += NeedToReload;
+	return NeedToReload;
+}
+
+void FTPSWeaponSim::CancelReload()
+{
+	bReloading = false;
+}
+
+void FTPSWeaponSim::Step(const FWeaponInfo& Info, float DeltaTime, TArray<FTPSWeaponShotEvent>& OutShots)
+{
+	const uint8 ShotCount = TickFire(Info, DeltaTime);
+	if (ShotCount > 0)
+	{
+		OutShots.Add(MakeShotEvent(ShotCount));
+		ConsumeShots(ShotCount);
+		if (Round <= 0 && !bReloading)
+			StartReload(Info);
+	}
+	if (TickReload(DeltaTime))
+		FinishReload(Info, Info.MaxRound);
+	TickDispersion();
+	Time += DeltaTime;
+}
+
+FVector FTPSWeaponSim::ApplyDispersion(const FVector& Direction, float DispersionDegrees, const FRandomStream& PelletStream)
+{
+	return PelletStream.VRandCone(Direction, DispersionDegrees * PI / 180.f);
+}
+
+FVector FTPSWeaponSim::GetFireDirection(const FVector& Muzzle, const FVector& MuzzleForward, const FVector& AimPoint, float MinAimDistance)
+{
+	const FVector ToAim = AimPoint - Muzzle;
+	if (ToAim.SizeSquared() > FMath::Square(MinAimDistance))
+	{
+		return ToAim.GetSafeNormal();
+	}
+	return MuzzleForward;
+}
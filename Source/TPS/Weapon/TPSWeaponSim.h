@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "../FuncLibrary/Types.h"
+
+//One trigger batch due this step, pellets are replayed from Seed
+struct FTPSWeaponShotEvent
+{
+	float Time = 0.0f;
+	int32 Seed = 0;
+	//degrees, before recoil of this batch
+	float Dispersion = 0.0f;
+	uint8 ShotCount = 0;
+};
+
+/**
+ * Fire rate, dispersion, reload and rounds of one weapon without world or actor.
+ * UTPSWeaponSubsystem keeps one per weapon in a flat array and steps them all in one pass,
+ * AWeaponDefault mirrors Round, bFiring and bReloading into its replicated properties.
+ * Dispersion change and reduction are per step, like the actor tick they came from.
+ * Step() is the whole loop with unlimited ammo, used by the WeaponSim micro benchmark.
+ */
+struct TPS_API FTPSWeaponSim
+{
+	int32 Round = 0;
+	bool bFiring = false;
+	bool bReloading = false;
+	bool bBlockFire = false;
+	bool bReduceDispersion = false;
+
+	float FireTimer = 0.0f;
+	float ReloadTimer = 0.0f;
+	float Time = 0.0f;
+
+	float Dispersion = 0.0f;
+	float DispersionMax = 1.0f;
+	float DispersionMin = 0.1f;
+	float DispersionRecoil = 0.1f;
+	float DispersionReduction = 0.1f;
+
+	//clip and shell drop meshes, spawned by the actor when due
+	bool bDropClip = false;
+	float DropClipTimer = -1.0f;
+	bool bDropShell = false;
+	float DropShellTimer = -1.0f;
+
+	//batch seeds
+	FRandomStream Stream;
+
+	void Init(const FWeaponInfo& Info, int32 InRound, int32 Seed);
+	void SetMovementState(const FWeaponInfo& Info, EMovementState NewMovementState);
+	void SetFiring(bool bIsFire);
+
+	bool CanFire() const { return bFiring && Round > 0 && !bReloading; }
+	//shots due after DeltaTime, 0 - none, at most MaxShotCount
+	uint8 TickFire(const FWeaponInfo& Info, float DeltaTime);
+	//true when the reload timer ran out, FinishReload is up to the caller
+	bool TickReload(float DeltaTime);
+	void TickDispersion();
+	//DropClip | DropShell due after DeltaTime, their flags are cleared
+	uint8 TickDrops(float DeltaTime);
+
+	//rounds and recoil of fired shots
+	void ConsumeShots(uint8 ShotCount);
+	FTPSWeaponShotEvent MakeShotEvent(uint8 ShotCount);
+
+	void StartReload(const FWeaponInfo& Info);
+	//AvailableAmmo - ammo in inventory, returns ammo taken from it
+	int32 FinishReload(const FWeaponInfo& Info, int32 AvailableAmmo);
+	void CancelReload();
+
+	//fire, reload with unlimited ammo and dispersion for one step
+	void Step(const FWeaponInfo& Info, float DeltaTime, TArray<FTPSWeaponShotEvent>& OutShots);
+
+	static FVector ApplyDispersion(const FVector& Direction, float DispersionDegrees, const FRandomStream& PelletStream);
+	//towards AimPoint unless it is closer than MinAimDistance to the muzzle
+	static FVector GetFireDirection(const FVector& Muzzle, const FVector& MuzzleForward, const FVector& AimPoint, float MinAimDistance);
+
+	static constexpr uint8 MaxShotCount = 32;
+	static constexpr uint8 DropClip = 1 << 0;
+	static constexpr uint8 DropShell = 1 << 1;
+};
@@ -1,10 +1,20 @@
 #include "WeaponDefault.h"
-#include "DrawDebugHelpers.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Kismet/GameplayStatics.h"
 #include "Engine/StaticMeshActor.h"
 #include "Engine/GameEngine.h"
 #include "../Character/TPSInventoryComponent.h"
+#include "../Character/TPSCharacter.h"
+#include "../TPS.h"
+#include "../FuncLibrary/TPSDebugDraw.h"
+#include "../FuncLibrary/TPSTelemetry.h"
+#include "../Game/TPSGameInstance.h"
+#include "../Game/TPSLagCompensationSubsystem.h"
+#include "../Game/TPSAnimSubsystem.h"
+#include "../Game/TPSWeaponAudioSubsystem.h"
+#include "Components/AudioComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
 
 // Sets default values
 AWeaponDefault::AWeaponDefault()
@@ -12,6 +22,8 @@ AWeaponDefault::AWeaponDefault()
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
+	bReplicates = true;
+
 	SceneComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Scene"));
 	RootComponent = SceneComponent;
 
@@ -19,6 +31,7 @@ AWeaponDefault::AWeaponDefault()
 	SkeletalMeshWeapon->SetGenerateOverlapEvents(false);
 	SkeletalMeshWeapon->SetCollisionProfileName(TEXT("NoCollision"));
 	SkeletalMeshWeapon->SetupAttachment(RootComponent);
+	UTPSAnimSubsystem::SetupMesh(SkeletalMeshWeapon);
 
 	StaticMeshWeapon = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Static Mesh "));
 	StaticMeshWeapon->SetGenerateOverlapEvents(false);
@@ -33,6 +46,96 @@ AWeaponDefault::AWeaponDefault()
 void AWeaponDefault::BeginPlay()
 {
 	Super::BeginPlay();
+
+	//initial replication sets SimSeed before BeginPlay on clients
+	if (HasAuthority())
+	{
+		SimSeed = FMath::Rand();
+	}
+	LocalSim.Stream.Initialize(SimSeed);
+
+	UTPSWeaponSubsystem* myWeapons = GetWorld()->GetSubsystem<UTPSWeaponSubsystem>();
+	if (myWeapons && UTPSWeaponSubsystem::IsBatchEnabled())
+	{
+		WeaponSubsystem = myWeapons;
+		SimHandle = myWeapons->Register(this, LocalSim);
+		//timers run in the subsystem, Tick only while a fire loop sound plays
+		SetActorTickEnabled(false);
+	}
+	else
+	{
+		UTPSFixedStepSubsystem* myFixedStep = GetWorld()->GetSubsystem<UTPSFixedStepSubsystem>();
+		if (myFixedStep)
+		{
+			FixedStepHandle = myFixedStep->Register(this);
+		}
+	}
+}
+
+void AWeaponDefault::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AWeaponDefault, WeaponIdName);
+	DOREPLIFETIME_CONDITION(AWeaponDefault, SimSeed, COND_InitialOnly);
+	//server rounds win over owner prediction
+	DOREPLIFETIME(AWeaponDefault, AdditionalWeaponInfo);
+	//owner predicts own reload and fire cosmetics
+	DOREPLIFETIME_CONDITION(AWeaponDefault, WeaponReloading, COND_SkipOwner);
+	DOREPLIFETIME_CONDITION(AWeaponDefault, FireRepInfo, COND_SkipOwner);
+}
+
+void AWeaponDefault::OnRep_WeaponIdName()
+{
+	UTPSGameInstance* myGI = Cast<UTPSGameInstance>(GetGameInstance());
+	if (myGI && myGI->GetWeaponInfoByName(WeaponIdName, WeaponSetting))
+	{
+		WeaponInit();
+	}
+
+	//owner may have got CurrentWeapon before the settings arrived
+	ATPSCharacter* myChar = Cast<ATPSCharacter>(GetOwner());
+	if (myChar && myChar->GetCurrentWeapon() == this)
+	{
+		myChar->OnCurrentWeaponChanged.Broadcast();
+	}
+}
+
+void AWeaponDefault::OnRep_WeaponReloading()
+{
+	//visual only, reload itself runs on server and owner
+	GetSim().bReloading = WeaponReloading;
+	if (WeaponReloading)
+	{
+		OnWeaponReloadStart.Broadcast(WeaponAiming ? WeaponSetting.AnimWeaponInfo.AnimCharReloadAim : WeaponSetting.AnimWeaponInfo.AnimCharReload);
+	}
+	else
+	{
+		OnWeaponReloadEnd.Broadcast(true, 0);
+	}
+}
+
+void AWeaponDefault::OnRep_AdditionalWeaponInfo()
+{
+	//server rounds win over owner prediction
+	GetSim().Round = AdditionalWeaponInfo.Round;
+}
+
+void AWeaponDefault::OnRep_FireRepInfo()
+{
+	//several batches may collapse into one update, play the last one for every missed counter
+	uint8 NumBatches = FireRepInfo.FireCounter - LastPlayedFireCounter;
+	LastPlayedFireCounter = FireRepInfo.FireCounter;
+
+	if (IsOwnerLocallyControlled())
+		return;
+
+	NumBatches = FMath::Min<uint8>(NumBatches, 3);
+	for (uint8 i = 0; i < NumBatches; i++)
+	{
+		SimulateShots(FireRepInfo.LastBatch, false, true);
+		PlayFireCosmetics(FireRepInfo.LastBatch);
+	}
 }
 
 // Called every frame
@@ -40,111 +143,175 @@ void AWeaponDefault::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	if (SimHandle != INDEX_NONE)
+	{
+		FireSoundTick(DeltaTime);
+		if (!FireLoopAudio)
+		{
+			SetActorTickEnabled(false);
+		}
+		return;
+	}
+
 	FireTick(DeltaTime);
-	ReloadTick(DeltaTime);
-	DispersionTick(DeltaTime);
-	ClipDropTick(DeltaTime);
-	ShellDropTick(DeltaTime);
+	//no fixed step clock (world without subsystems), step with the frame
+	if (FixedStepHandle == INDEX_NONE)
+	{
+		FixedStep(DeltaTime);
+	}
+	DropTick(DeltaTime);
+	FireSoundTick(DeltaTime);
+
+	SyncReplicatedState();
 }
 
-void AWeaponDefault::FireTick(float DeltaTime)
+void AWeaponDefault::FixedStep(float StepTime)
 {
-	if (WeaponFiring && GetWeaponRound() > 0 && !WeaponReloading)
+	const float OldDispersion = GetSim().Dispersion;
+	ReloadTick(StepTime);
+	DispersionTick(StepTime);
+	DispersionStepDelta = GetSim().Dispersion - OldDispersion;
+}
+
+void AWeaponDefault::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopFireLoop(EndPlayReason == EEndPlayReason::Destroyed);
+
+	if (WeaponSubsystem)
 	{
-		if (FireTimer < 0.f)
-		{
-			Fire();
-		}
-		else
-			FireTimer -= DeltaTime;
+		WeaponSubsystem->Unregister(SimHandle, LocalSim);
+		WeaponSubsystem = nullptr;
+	}
+	UTPSFixedStepSubsystem* myFixedStep = GetWorld()->GetSubsystem<UTPSFixedStepSubsystem>();
+	if (myFixedStep)
+	{
+		myFixedStep->Unregister(FixedStepHandle);
+	}
+
+	UTPSAnimSubsystem* myAnim = GetWorld()->GetSubsystem<UTPSAnimSubsystem>();
+	if (myAnim)
+	{
+		myAnim->Unregister(SkeletalMeshWeapon);
 	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
-void AWeaponDefault::ReloadTick(float DeltaTime)
+void AWeaponDefault::FireSoundTick(float DeltaTime)
 {
-	if (WeaponReloading)
+	if (FireLoopAudio && GetWorld()->GetTimeSeconds() - LastFireSoundTime > WeaponSetting.RateOfFire + WeaponSetting.FireAudio.LoopStopDelay)
 	{
-		if (ReloadTimer < 0.0f)
-		{
-			FinishReload();
-		}
-		else
-		{
-			ReloadTimer -= DeltaTime;
-		}
+		StopFireLoop(true);
 	}
 }
 
-void AWeaponDefault::DispersionTick(float DeltaTime)
+void AWeaponDefault::PlayFireSound(const FVector& Location)
 {
-	if (!WeaponReloading)
+	UTPSWeaponAudioSubsystem* myAudio = GetWorld()->GetSubsystem<UTPSWeaponAudioSubsystem>();
+	if (!myAudio)
+		return;
+
+	const FWeaponAudioInfo& Audio = WeaponSetting.FireAudio;
+	if (!Audio.FireLoop)
 	{
-		if (!WeaponFiring)
-		{
-			if (ShouldReduceDispersion)
-			{
-				CurrentDispersion = CurrentDispersion - CurrentDispersionReduction;
-			}
-			else
-			{
-				CurrentDispersion = CurrentDispersion + CurrentDispersionReduction;
-			}
-		}
+		myAudio->PlayAtLocation(WeaponSetting.SoundFireWeapon, WeaponIdName, Audio, Location);
+		return;
+	}
 
-		if (CurrentDispersion < CurrentDispersionMin)
+	LastFireSoundTime = GetWorld()->GetTimeSeconds();
+	if (!FireLoopAudio && myAudio->CanPlay(WeaponIdName, Audio, Location))
+	{
+		USceneComponent* AttachTo = ShootLocation ? (USceneComponent*)ShootLocation : RootComponent;
+		FireLoopAudio = UGameplayStatics::SpawnSoundAttached(Audio.FireLoop, AttachTo, NAME_None, FVector::ZeroVector, EAttachLocation::KeepRelativeOffset,
+			true, 1.0f, 1.0f, 0.0f, nullptr, Audio.Concurrency, false);
+		myAudio->AddVoice(FireLoopAudio, WeaponIdName);
+		//batched weapon ticks only to stop the loop
+		if (FireLoopAudio && SimHandle != INDEX_NONE)
 		{
-			CurrentDispersion = CurrentDispersionMin;
-		}
-		else
-		{
-			if (CurrentDispersion > CurrentDispersionMax)
-			{
-				CurrentDispersion = CurrentDispersionMax;
-			}
+			SetActorTickEnabled(true);
 		}
 	}
-	if (ShowDebug)
-		UE_LOG(LogTemp, Warning, TEXT("Dispersion: MAX = %f. MIN = %f. Current = %f"), CurrentDispersionMax, CurrentDispersionMin, CurrentDispersion);
 }
 
-void AWeaponDefault::ClipDropTick(float DeltaTime)
+void AWeaponDefault::StopFireLoop(bool bPlayTail)
 {
-	if (DropClipFlag)
+	if (!FireLoopAudio)
+		return;
+
+	const FVector Location = FireLoopAudio->GetComponentLocation();
+	FireLoopAudio->Stop();
+	FireLoopAudio->DestroyComponent();
+	FireLoopAudio = nullptr;
+
+	UTPSWeaponAudioSubsystem* myAudio = GetWorld() ? GetWorld()->GetSubsystem<UTPSWeaponAudioSubsystem>() : nullptr;
+	if (bPlayTail && myAudio)
 	{
-		if (DropClipTimer < 0.0f)
-		{
-			DropClipFlag = false;
-			InitDropMesh(WeaponSetting.ClipDropMesh.DropMesh, WeaponSetting.ClipDropMesh.DropMeshOffset, WeaponSetting.ClipDropMesh.DropMeshImpulseDir, WeaponSetting.ClipDropMesh.DropMeshLifeTime, WeaponSetting.ClipDropMesh.ImpulseRandomDispersion, WeaponSetting.ClipDropMesh.PowerImpulse, WeaponSetting.ClipDropMesh.CustomMass);
-		}
-		else
-		{
-			DropClipTimer -= DeltaTime;
-		}
+		myAudio->PlayAtLocation(WeaponSetting.FireAudio.FireTail, WeaponIdName, WeaponSetting.FireAudio, Location);
 	}
 }
 
-void AWeaponDefault::ShellDropTick(float DeltaTime)
+void AWeaponDefault::FireTick(float DeltaTime)
+{
+	const uint8 ShotCount = GetSim().TickFire(WeaponSetting, DeltaTime);
+	if (ShotCount > 0)
+		Fire(ShotCount);
+}
+
+void AWeaponDefault::ReloadTick(float DeltaTime)
 {
-	if (DropShellFlag)
+	if (GetSim().bReloading && CanFinishReload() && GetSim().TickReload(DeltaTime))
 	{
-		if (DropShellTimer < 0.0f)
-		{
-			DropShellFlag = false;
-			InitDropMesh(WeaponSetting.ShellBullets.DropMesh, WeaponSetting.ShellBullets.DropMeshOffset, WeaponSetting.ShellBullets.DropMeshImpulseDir, WeaponSetting.ShellBullets.DropMeshLifeTime, WeaponSetting.ShellBullets.ImpulseRandomDispersion, WeaponSetting.ShellBullets.PowerImpulse, WeaponSetting.ShellBullets.CustomMass);
-		}
-		else
-		{
-			DropShellTimer -= DeltaTime;
-		}
+		FinishReload();
 	}
 }
 
+void AWeaponDefault::DispersionTick(float DeltaTime)
+{
+	GetSim().TickDispersion();
+	if (ShowDebug)
+		LogDispersion();
+}
+
+void AWeaponDefault::LogDispersion() const
+{
+	if (TPSShouldPlayCosmetics(GetWorld()))
+		UE_LOG(LogTemp, Warning, TEXT("Dispersion: MAX = %f. MIN = %f. Current = %f"), GetSim().DispersionMax, GetSim().DispersionMin, GetSim().Dispersion);
+}
+
+void AWeaponDefault::DropTick(float DeltaTime)
+{
+	const uint8 Drops = GetSim().TickDrops(DeltaTime);
+	if (Drops & FTPSWeaponSim::DropClip)
+		SpawnClipDropMesh();
+	if (Drops & FTPSWeaponSim::DropShell)
+		SpawnShellDropMesh();
+}
+
+void AWeaponDefault::SpawnClipDropMesh()
+{
+	InitDropMesh(WeaponSetting.ClipDropMesh.DropMesh, WeaponSetting.ClipDropMesh.DropMeshOffset, WeaponSetting.ClipDropMesh.DropMeshImpulseDir, WeaponSetting.ClipDropMesh.DropMeshLifeTime, WeaponSetting.ClipDropMesh.ImpulseRandomDispersion, WeaponSetting.ClipDropMesh.PowerImpulse, WeaponSetting.ClipDropMesh.CustomMass);
+}
+
+void AWeaponDefault::SpawnShellDropMesh()
+{
+	InitDropMesh(WeaponSetting.ShellBullets.DropMesh, WeaponSetting.ShellBullets.DropMeshOffset, WeaponSetting.ShellBullets.DropMeshImpulseDir, WeaponSetting.ShellBullets.DropMeshLifeTime, WeaponSetting.ShellBullets.ImpulseRandomDispersion, WeaponSetting.ShellBullets.PowerImpulse, WeaponSetting.ShellBullets.CustomMass);
+}
+
 void AWeaponDefault::WeaponInit()
 {
 	if (SkeletalMeshWeapon && !SkeletalMeshWeapon->SkeletalMesh)
 	{
 		SkeletalMeshWeapon->DestroyComponent(true);
 	}
+	else if (SkeletalMeshWeapon)
+	{
+		//weapon pose is cosmetic, never needed off screen
+		UTPSAnimSubsystem* myAnim = GetWorld()->GetSubsystem<UTPSAnimSubsystem>();
+		if (myAnim)
+		{
+			myAnim->Register(SkeletalMeshWeapon, false, false);
+		}
+	}
 
 	if (StaticMeshWeapon && !StaticMeshWeapon->GetStaticMesh())
 	{
@@ -153,31 +320,155 @@ void AWeaponDefault::WeaponInit()
 	UpdateStateWeapon(EMovementState::Run_State);
 }
 
+void AWeaponDefault::SetAdditionalWeaponInfo(const FAdditionalWeaponInfo& NewInfo)
+{
+	AdditionalWeaponInfo = NewInfo;
+	GetSim().Round = NewInfo.Round;
+}
+
+void AWeaponDefault::SyncReplicatedState()
+{
+	WeaponFiring = GetSim().bFiring;
+	WeaponReloading = GetSim().bReloading;
+	AdditionalWeaponInfo.Round = GetSim().Round;
+}
+
 void AWeaponDefault::SetWeaponStateFire(bool bIsFire)
 {
-	if (CheckWeaponCanFire())
+	GetSim().SetFiring(bIsFire);
+	SyncReplicatedState();
+}
+
+bool AWeaponDefault::CheckWeaponCanFire()
+{
+	return !GetSim().bBlockFire;
+}
+
+FProjectileInfo AWeaponDefault::GetProjectile()
+{
+	return WeaponSetting.ProjectileSetting;
+}
+
+bool AWeaponDefault::IsOwnerLocallyControlled() const
+{
+	APawn* myPawn = Cast<APawn>(GetOwner());
+	return myPawn && myPawn->IsLocallyControlled();
+}
+
+void AWeaponDefault::Fire(uint8 ShotCount)
+{
+	if (!ShootLocation || ShotCount == 0)
+		return;
+
+	const FTPSWeaponShotEvent Shot = GetSim().MakeShotEvent(ShotCount);
+	FWeaponFireBatch Batch;
+	Batch.Origin = ShootLocation->GetComponentLocation();
+	Batch.Direction = GetFireDirection();
+	Batch.Seed = Shot.Seed;
+	Batch.Dispersion = (uint16)FMath::Clamp(FMath::RoundToInt(Shot.Dispersion * 100.0f), 0, 65535);
+	Batch.ShotCount = ShotCount;
+	AGameStateBase* myGameState = GetWorld()->GetGameState();
+	Batch.ClientTime = myGameState ? myGameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+
+	if (HasAuthority())
 	{
-		WeaponFiring = bIsFire;
+		ExecuteFireBatch(Batch);
 	}
 	else
 	{
-		WeaponFiring = false;
+		//predict rounds, dispersion and visuals on owning client, server replays the same seed
+		GetSim().ConsumeShots(ShotCount);
+		SyncReplicatedState();
+		OnWeaponFired.Broadcast();
+		SimulateShots(Batch, false, true);
+		PlayFireCosmetics(Batch);
+		ServerFireBatch(Batch);
+
+		if (GetWeaponRound() <= 0 && !GetSim().bReloading)
+		{
+			if (CheckCanWeaponReload())
+				InitReload();
+		}
 	}
-	FireTimer = 0.01f;//!!!!!
 }
 
-bool AWeaponDefault::CheckWeaponCanFire()
+bool AWeaponDefault::ServerFireBatch_Validate(const FWeaponFireBatch& Batch)
 {
-	return !BlockFire;
+	return Batch.ShotCount > 0 && Batch.ShotCount <= 32;
 }
 
-FProjectileInfo AWeaponDefault::GetProjectile()
+void AWeaponDefault::ServerFireBatch_Implementation(const FWeaponFireBatch& Batch)
 {
-	return WeaponSetting.ProjectileSetting;
+	TPSCountServerRPC();
+
+	if (GetSim().bReloading || GetSim().bBlockFire || GetWeaponRound() <= 0)
+		return;
+
+	//token bucket, one shot per RateOfFire, at most 1 + ServerShotTolerance saved up
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float MaxCredit = 1.0f + FMath::Max(ServerShotTolerance, 0);
+	if (WeaponSetting.RateOfFire <= 0.0f || LastServerFireTime < 0.0f)
+	{
+		ServerShotCredit = MaxCredit;
+	}
+	else
+	{
+		ServerShotCredit = FMath::Min(ServerShotCredit + (Now - LastServerFireTime) / WeaponSetting.RateOfFire, MaxCredit);
+	}
+	LastServerFireTime = Now;
+
+	const int32 ShotCount = FMath::Min3<int32>(Batch.ShotCount, FMath::FloorToInt(ServerShotCredit), GetWeaponRound());
+	if (ShotCount <= 0)
+		return;
+	ServerShotCredit -= ShotCount;
+
+	//seed and spread come from the server sim in the state the server knows, not from the client
+	const FTPSWeaponShotEvent Shot = GetSim().MakeShotEvent(ShotCount);
+	FWeaponFireBatch ServerBatch = Batch;
+	ServerBatch.ShotCount = ShotCount;
+	ServerBatch.Seed = Shot.Seed;
+	ServerBatch.Dispersion = (uint16)FMath::Clamp(FMath::RoundToInt(Shot.Dispersion * 100.0f), 0, 65535);
+	if (ShootLocation && FVector::DistSquared(Batch.Origin, ShootLocation->GetComponentLocation()) > FMath::Square(MaxClientOriginError))
+	{
+		ServerBatch.Origin = ShootLocation->GetComponentLocation();
+	}
+
+	ExecuteFireBatch(ServerBatch);
 }
 
-void AWeaponDefault::Fire()
+void AWeaponDefault::ExecuteFireBatch(const FWeaponFireBatch& Batch)
 {
+	CSV_SCOPED_TIMING_STAT(TPS, WeaponFire);
+	CSV_CUSTOM_STAT(TPS, ShotsFired, Batch.ShotCount, ECsvCustomStatOp::Accumulate);
+
+	GetSim().ConsumeShots(Batch.ShotCount);
+	SyncReplicatedState();
+	OnWeaponFired.Broadcast();
+
+	const bool bIsCosmetic = TPSShouldPlayCosmetics(GetWorld());
+	SimulateShots(Batch, true, bIsCosmetic);
+	if (bIsCosmetic)
+	{
+		PlayFireCosmetics(Batch);
+	}
+
+	FireRepInfo.FireCounter++;
+	FireRepInfo.LastBatch = Batch;
+
+	if (GetWeaponRound() <= 0 && !GetSim().bReloading)
+	{
+		//Init Reload
+		if (CheckCanWeaponReload())
+			InitReload();
+	}
+}
+
+void AWeaponDefault::PlayFireCosmetics(const FWeaponFireBatch& Batch)
+{
+	//anim, FX and sound only, rounds and inventory are handled by OnWeaponFired
+	if (!TPSShouldPlayCosmetics(GetWorld()))
+		return;
+
 	UAnimMontage* AnimToPlay = nullptr;
 	if (WeaponAiming)
 	{
@@ -203,51 +494,61 @@ void AWeaponDefault::Fire()
 		}
 		else
 		{
-			DropShellFlag = true;
-			DropShellTimer = WeaponSetting.ShellBullets.DropMeshTime;
+			GetSim().bDropShell = true;
+			GetSim().DropShellTimer = WeaponSetting.ShellBullets.DropMeshTime;
 		}
 	}
 
 	OnWeaponFireStart.Broadcast(AnimToPlay);
 
-	FireTimer = WeaponSetting.RateOfFire;
-	AdditionalWeaponInfo.Round = AdditionalWeaponInfo.Round - 1;
-	ChangeDispersionByShot();
+	PlayFireSound(Batch.Origin);
+	if (ShootLocation)
+	{
+		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), WeaponSetting.EffectFireWeapon, ShootLocation->GetComponentTransform());
+	}
+}
 
-	OnWeaponFireStart.Broadcast(AnimToPlay);
+void AWeaponDefault::SimulateShots(const FWeaponFireBatch& Batch, bool bApplyGameplay, bool bSpawnImpactFX)
+{
+	FRandomStream Stream(Batch.Seed);
+	const float Dispersion = Batch.Dispersion / 100.0f;
+	const int8 NumberProjectile = GetNumberProjectileByShot();
+	const FVector SpawnLocation = Batch.Origin;
+	FProjectileInfo ProjectileInfo;
+	ProjectileInfo = GetProjectile();
+
+	//remote shooter saw targets in the past, trace characters rewound to its time
+	UTPSLagCompensationSubsystem* myLagComp = nullptr;
+	TArray<AActor*> Actors;
+	if (bApplyGameplay && !ProjectileInfo.Projectile && !IsOwnerLocallyControlled())
+	{
+		myLagComp = GetWorld()->GetSubsystem<UTPSLagCompensationSubsystem>();
+		if (myLagComp && myLagComp->IsEnabled())
+			myLagComp->GetCompensatedActors(Actors);
+		else
+			myLagComp = nullptr;
+	}
 
-	UGameplayStatics::SpawnSoundAtLocation(GetWorld(), WeaponSetting.SoundFireWeapon, ShootLocation->GetComponentLocation());
-	UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), WeaponSetting.EffectFireWeapon, ShootLocation->GetComponentTransform());
+	TPS_DEBUG_CONE(GetWorld(), Dispersion, SpawnLocation, Batch.Direction, WeaponSetting.DistacneTrace, Dispersion, FColor::Yellow, 1.0f);
 
-	int8 NumberProjectile = GetNumberProjectileByShot();
+	//server side only, clients replay the same batch
+	const bool bRecordTelemetry = bApplyGameplay && FTPSTelemetry::IsEnabled();
 
-	if (ShootLocation)
+	for (uint8 Shot = 0; Shot < Batch.ShotCount; Shot++)
 	{
-		FVector SpawnLocation = ShootLocation->GetComponentLocation();
-		FRotator SpawnRotation = ShootLocation->GetComponentRotation();
-		FProjectileInfo ProjectileInfo;
-		ProjectileInfo = GetProjectile();
-
-		FVector EndLocation;
 		for (int8 i = 0; i < NumberProjectile; i++)
 		{
-			EndLocation = GetFireEndLocation();
-
-			if (ShowDebug)
-			{
-				DrawDebugLine(GetWorld(), SpawnLocation, SpawnLocation + ShootLocation->GetForwardVector() * WeaponSetting.DistacneTrace,
-					FColor::Green, false, 5.f, (uint8)'\000', 0.5f);
-			}
+			const FVector Dir = FTPSWeaponSim::ApplyDispersion(Batch.Direction, Dispersion, Stream);
 
 			if (ProjectileInfo.Projectile)
 			{
-				//Projectile Init ballistic fire
-				FVector Dir = EndLocation - SpawnLocation;
-
-				Dir.Normalize();
+				//projectiles are replicated actors, clients only see them
+				if (!bApplyGameplay)
+					continue;
 
+				//Projectile Init ballistic fire
 				FMatrix myMatrix(Dir, FVector(0, 1, 0), FVector(0, 0, 1), FVector::ZeroVector);
-				SpawnRotation = myMatrix.Rotator();
+				FRotator SpawnRotation = myMatrix.Rotator();
 
 				FActorSpawnParameters SpawnParams;
 				SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
@@ -255,8 +556,11 @@ void AWeaponDefault::Fire()
 				SpawnParams.Instigator = GetInstigator();
 
 				AProjectileDefault* myProjectile = Cast<AProjectileDefault>(GetWorld()->SpawnActor(ProjectileInfo.Projectile, &SpawnLocation, &SpawnRotation, SpawnParams));
+				if (bRecordTelemetry)
+					FTPSTelemetry::Record(GetWorld(), ETPSTelemetryType::Shot, WeaponIdName, SpawnLocation, Dir, nullptr, SurfaceType_Default, 0.0f, ProjectileInfo.Effect);
 				if (myProjectile)
 				{
+					myProjectile->WeaponIdName = WeaponIdName;
 					myProjectile->InitProjectile(ProjectileInfo);
 					myProjectile->BulletProjectileMovement->InitialSpeed = ProjectileInfo.ProjectileInitSpeed;
 					myProjectile->BulletProjectileMovement->Velocity = Dir * ProjectileInfo.ProjectileInitSpeed;
@@ -265,129 +569,104 @@ void AWeaponDefault::Fire()
 			else
 			{
 				FHitResult Hit;
-				TArray<AActor*> Actors;
 
-				UKismetSystemLibrary::LineTraceSingle(GetWorld(), SpawnLocation, EndLocation * WeaponSetting.DistacneTrace,
-					ETraceTypeQuery::TraceTypeQuery4, false, Actors, EDrawDebugTrace::ForDuration, Hit, true, FLinearColor::Red, FLinearColor::Green, 5.0f);
+				UKismetSystemLibrary::LineTraceSingle(GetWorld(), SpawnLocation, SpawnLocation + Dir * WeaponSetting.DistacneTrace,
+					ETraceTypeQuery::TraceTypeQuery4, false, Actors, EDrawDebugTrace::None, Hit, true);
+
+				if (myLagComp)
+				{
+					FHitResult RewindHit;
+					const FVector RewindEnd = Hit.bBlockingHit ? Hit.Location : SpawnLocation + Dir * WeaponSetting.DistacneTrace;
+					if (myLagComp->RewindLineTrace(SpawnLocation, RewindEnd, Batch.ClientTime, GetOwner(), RewindHit))
+						Hit = RewindHit;
+				}
+
+				TPS_DEBUG_LINE(GetWorld(), WeaponTrace, SpawnLocation, Hit.bBlockingHit ? Hit.ImpactPoint : SpawnLocation + Dir * WeaponSetting.DistacneTrace,
+					Hit.bBlockingHit ? FColor::Red : FColor::Green, 5.0f);
+				TPS_DEBUG_POINT(GetWorld(), WeaponTrace, Hit.ImpactPoint, 16.0f, FColor::Red, 5.0f);
+
+				if (bRecordTelemetry)
+				{
+					const bool bDamaged = Hit.GetActor() && Hit.PhysMaterial.IsValid();
+					FTPSTelemetry::Record(GetWorld(), ETPSTelemetryType::Shot, WeaponIdName, SpawnLocation, Dir, Hit.GetActor(),
+						bDamaged ? UGameplayStatics::GetSurfaceType(Hit) : SurfaceType_Default,
+						bDamaged ? WeaponSetting.ProjectileSetting.ProjectileDamage : 0.0f, nullptr);
+				}
 
 				if (Hit.GetActor() && Hit.PhysMaterial.IsValid())
 				{
 					EPhysicalSurface mySurfacetype = UGameplayStatics::GetSurfaceType(Hit);
 
-					if (WeaponSetting.ProjectileSetting.HitDecals.Contains(mySurfacetype))
+					if (bSpawnImpactFX)
 					{
-						UMaterialInterface* myMaterial = WeaponSetting.ProjectileSetting.HitDecals[mySurfacetype];
-						if (myMaterial && Hit.GetComponent())
-							UGameplayStatics::SpawnDecalAttached(myMaterial, FVector(20.0f), Hit.GetComponent(), NAME_None, Hit.ImpactPoint, Hit.ImpactNormal.Rotation(), EAttachLocation::KeepWorldPosition);
-					}
-					if (WeaponSetting.ProjectileSetting.HitFXs.Contains(mySurfacetype))
-					{
-						UParticleSystem* myParicle = WeaponSetting.ProjectileSetting.HitFXs[mySurfacetype];
-						if (myParicle)
+						if (WeaponSetting.ProjectileSetting.HitDecals.Contains(mySurfacetype))
 						{
-							UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), myParicle, FTransform(Hit.ImpactNormal.Rotation(), Hit.ImpactPoint, FVector(1.0f)));
+							UMaterialInterface* myMaterial = WeaponSetting.ProjectileSetting.HitDecals[mySurfacetype];
+							if (myMaterial && Hit.GetComponent())
+								UGameplayStatics::SpawnDecalAttached(myMaterial, FVector(20.0f), Hit.GetComponent(), NAME_None, Hit.ImpactPoint, Hit.ImpactNormal.Rotation(), EAttachLocation::KeepWorldPosition);
+						}
+						if (WeaponSetting.ProjectileSetting.HitFXs.Contains(mySurfacetype))
+						{
+							UParticleSystem* myParicle = WeaponSetting.ProjectileSetting.HitFXs[mySurfacetype];
+							if (myParicle)
+							{
+								UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), myParicle, FTransform(Hit.ImpactNormal.Rotation(), Hit.ImpactPoint, FVector(1.0f)));
+							}
+						}
+						if (WeaponSetting.ProjectileSetting.HitSound)
+						{
+							UGameplayStatics::PlaySoundAtLocation(GetWorld(), WeaponSetting.ProjectileSetting.HitSound, Hit.ImpactPoint);
 						}
-					}
-					if (WeaponSetting.ProjectileSetting.HitSound)
-					{
-						UGameplayStatics::PlaySoundAtLocation(GetWorld(), WeaponSetting.ProjectileSetting.HitSound, Hit.ImpactPoint);
 					}
 
-					//UTypes::AddEffectBySurfaceType(Hit.GetActor(), ProjectileInfo.Effect, mySurfacetype);
+					if (bApplyGameplay)
+					{
+						//UTypes::AddEffectBySurfaceType(Hit.GetActor(), ProjectileInfo.Effect, mySurfacetype);
 
-					UGameplayStatics::ApplyPointDamage(Hit.GetActor(), WeaponSetting.ProjectileSetting.ProjectileDamage, Hit.TraceStart, Hit, GetInstigatorController(), this, NULL);
-					//UGameplayStatics::ApplyDamage(Hit.GetActor(), WeaponSetting.ProjectileSetting.ProjectileDamage, GetInstigatorController(), this, NULL);
+						UGameplayStatics::ApplyPointDamage(Hit.GetActor(), WeaponSetting.ProjectileSetting.ProjectileDamage, Hit.TraceStart, Hit, GetInstigatorController(), this, NULL);
+						//UGameplayStatics::ApplyDamage(Hit.GetActor(), WeaponSetting.ProjectileSetting.ProjectileDamage, GetInstigatorController(), this, NULL);
+					}
 				}
 			}
 		}
 	}
-
-	if (GetWeaponRound() <= 0 && !WeaponReloading)
-	{
-		//Init Reload
-		if (CheckCanWeaponReload())
-			InitReload();
-	}
 }
 
 void AWeaponDefault::UpdateStateWeapon(EMovementState NewMovementState)
 {
-	//ToDo Dispersion
-	BlockFire = false;
-
-	switch (NewMovementState)
-	{
-	case EMovementState::Aim_State:
-
-		CurrentDispersionMax = WeaponSetting.DispersionWeapon.Aim_StateDispersionAimMax;
-		CurrentDispersionMin = WeaponSetting.DispersionWeapon.Aim_StateDispersionAimMin;
-		CurrentDispersionRecoil = WeaponSetting.DispersionWeapon.Aim_StateDispersionAimRecoil;
-		CurrentDispersionReduction = WeaponSetting.DispersionWeapon.Aim_StateDispersionReduction;
-		break;
-	case EMovementState::AimWalk_State:
-
-		CurrentDispersionMax = WeaponSetting.DispersionWeapon.AimWalk_StateDispersionAimMax;
-		CurrentDispersionMin = WeaponSetting.DispersionWeapon.AimWalk_StateDispersionAimMin;
-		CurrentDispersionRecoil = WeaponSetting.DispersionWeapon.AimWalk_StateDispersionAimRecoil;
-		CurrentDispersionReduction = WeaponSetting.DispersionWeapon.Aim_StateDispersionReduction;
-		break;
-	case EMovementState::Walk_State:
-
-		CurrentDispersionMax = WeaponSetting.DispersionWeapon.Walk_StateDispersionAimMax;
-		CurrentDispersionMin = WeaponSetting.DispersionWeapon.Walk_StateDispersionAimMin;
-		CurrentDispersionRecoil = WeaponSetting.DispersionWeapon.Walk_StateDispersionAimRecoil;
-		CurrentDispersionReduction = WeaponSetting.DispersionWeapon.Aim_StateDispersionReduction;
-		break;
-	case EMovementState::Run_State:
-
-		CurrentDispersionMax = WeaponSetting.DispersionWeapon.Run_StateDispersionAimMax;
-		CurrentDispersionMin = WeaponSetting.DispersionWeapon.Run_StateDispersionAimMin;
-		CurrentDispersionRecoil = WeaponSetting.DispersionWeapon.Run_StateDispersionAimRecoil;
-		CurrentDispersionReduction = WeaponSetting.DispersionWeapon.Aim_StateDispersionReduction;
-		break;
-	case EMovementState::Sprint_State:
-		BlockFire = true;
-		SetWeaponStateFire(false);//set fire trigger to false
-		//Block Fire
-		break;
-	default:
-		break;
-	}
-}
-
-void AWeaponDefault::ChangeDispersionByShot()
-{
-	CurrentDispersion = CurrentDispersion + CurrentDispersionRecoil;
+	GetSim().SetMovementState(WeaponSetting, NewMovementState);
+	//same rule as the owner's cursor tick, the server has no cursor
+	GetSim().bReduceDispersion = NewMovementState == EMovementState::Aim_State || NewMovementState == EMovementState::AimWalk_State;
+	SyncReplicatedState();
 }
 
 float AWeaponDefault::GetCurrentDispersion() const
 {
-	float Result = CurrentDispersion;
-	return Result;
+	const UTPSFixedStepSubsystem* myFixedStep = GetWorld()->GetSubsystem<UTPSFixedStepSubsystem>();
+	if (!myFixedStep || !IsOnFixedStep())
+		return GetSim().Dispersion;
+
+	//recoil between steps shows at once, only the step's own change is interpolated
+	const float StepDelta = SimHandle != INDEX_NONE ? WeaponSubsystem->GetDispersionStepDelta(SimHandle) : DispersionStepDelta;
+	const float Result = GetSim().Dispersion - (1.0f - myFixedStep->GetAlpha()) * StepDelta;
+	return FMath::Clamp(Result, GetSim().DispersionMin, GetSim().DispersionMax);
 }
 
-FVector AWeaponDefault::ApplyDispersionToShoot(FVector DirectionShoot) const
+float AWeaponDefault::GetReloadProgress() const
 {
-	return FMath::VRandCone(DirectionShoot, GetCurrentDispersion() * PI / 180.f);
+	if (!GetSim().bReloading)
+		return 0.0f;
+	if (WeaponSetting.ReloadTime <= 0.0f)
+		return 1.0f;
+
+	const UTPSFixedStepSubsystem* myFixedStep = GetWorld()->GetSubsystem<UTPSFixedStepSubsystem>();
+	const float Pending = myFixedStep && IsOnFixedStep() ? myFixedStep->GetAlpha() * myFixedStep->GetStepTime() : 0.0f;
+	return FMath::Clamp(1.0f - (GetSim().ReloadTimer - Pending) / WeaponSetting.ReloadTime, 0.0f, 1.0f);
 }
 
-FVector AWeaponDefault::GetFireEndLocation() const
+FVector AWeaponDefault::GetFireDirection() const
 {
-	bool bShootDirection = false;
-	FVector EndLocation = FVector(0.f);
-
-	FVector tmpV = (ShootLocation->GetComponentLocation() - ShootEndLocation);
-
-	if (tmpV.Size() > SizeVectorToChangeShootDirectionLogic)
-	{
-		EndLocation = ShootLocation->GetComponentLocation() + ApplyDispersionToShoot(tmpV.GetSafeNormal()) * -20000.0f;
-	}
-
-	else
-	{
-		EndLocation = ShootLocation->GetComponentLocation() + ApplyDispersionToShoot(ShootLocation->GetForwardVector()) * 20000.0f;
-	}
-	return EndLocation;
+	return FTPSWeaponSim::GetFireDirection(ShootLocation->GetComponentLocation(), ShootLocation->GetForwardVector(), ShootEndLocation, SizeVectorToChangeShootDirectionLogic);
 }
 
 int8 AWeaponDefault::GetNumberProjectileByShot() const
@@ -397,13 +676,15 @@ int8 AWeaponDefault::GetNumberProjectileByShot() const
 
 int32 AWeaponDefault::GetWeaponRound()
 {
-	return AdditionalWeaponInfo.Round;
+	return GetSim().Round;
 }
 
 void AWeaponDefault::InitReload()
 {
-	WeaponReloading = true;
-	ReloadTimer = WeaponSetting.ReloadTime;
+	CSV_CUSTOM_STAT(TPS, Reloads, 1, ECsvCustomStatOp::Accumulate);
+
+	GetSim().StartReload(WeaponSetting);
+	SyncReplicatedState();
 
 	UAnimMontage* AnimToPlay = nullptr;
 	if (WeaponAiming)
@@ -427,6 +708,9 @@ void AWeaponDefault::InitReload()
 		AnimWeaponToPlay = WeaponSetting.AnimWeaponInfo.AnimWeaponReload;
 	}
 
+	if (!TPSShouldPlayCosmetics(GetWorld()))
+		return;
+
 	if (WeaponSetting.AnimWeaponInfo.AnimWeaponReload
 		&& SkeletalMeshWeapon
 		&& SkeletalMeshWeapon->GetAnimInstance())
@@ -436,41 +720,33 @@ void AWeaponDefault::InitReload()
 
 	if (WeaponSetting.ClipDropMesh.DropMesh)
 	{
-		DropClipFlag = true;
-		DropClipTimer = WeaponSetting.ClipDropMesh.DropMeshTime;
+		GetSim().bDropClip = true;
+		GetSim().DropClipTimer = WeaponSetting.ClipDropMesh.DropMeshTime;
 	}
 }
 
 void AWeaponDefault::FinishReload()
 {
-	WeaponReloading = false;
-
-	int8 AviableAmmoFromInventory = GetAviableAmmoForReload();
-	int8 AmmoNeedTakeFromInv;
-	int8 NeedToReload = WeaponSetting.MaxRound - AdditionalWeaponInfo.Round;
-
-	if (NeedToReload > AviableAmmoFromInventory)
-	{
-		AdditionalWeaponInfo.Round = AviableAmmoFromInventory;
-		AmmoNeedTakeFromInv = AviableAmmoFromInventory;
-	}
-	else
-	{
-		AdditionalWeaponInfo.Round += NeedToReload;
-		AmmoNeedTakeFromInv = NeedToReload;
-	}
+	const int32 AmmoNeedTakeFromInv = GetSim().FinishReload(WeaponSetting, GetAviableAmmoForReload());
+	SyncReplicatedState();
 
 	OnWeaponReloadEnd.Broadcast(true, -AmmoNeedTakeFromInv);
 }
 
+bool AWeaponDefault::CanFinishReload() const
+{
+	return HasAuthority() || IsOwnerLocallyControlled();
+}
+
 void AWeaponDefault::CancelReload()
 {
-	WeaponReloading = false;
+	GetSim().CancelReload();
+	SyncReplicatedState();
 	if (SkeletalMeshWeapon && SkeletalMeshWeapon->GetAnimInstance())
 		SkeletalMeshWeapon->GetAnimInstance()->StopAllMontages(0.15f);
 
 	OnWeaponReloadEnd.Broadcast(false, 0);
-	DropClipFlag = false;
+	GetSim().bDropClip = false;
 }
 
 
@@ -512,7 +788,7 @@ int8 AWeaponDefault::GetAviableAmmoForReload()
 
 void AWeaponDefault::InitDropMesh(UStaticMesh* DropMesh, FTransform Offset, FVector DropImpulseDirection, float LifeTimeMesh, float ImpilseRandomDispersion, float PowerImpulse, float CustomMass)
 {
-	if (DropMesh)
+	if (DropMesh && TPSShouldPlayCosmetics(GetWorld()))
 	{
 		FTransform Transform;
 		FVector LocalDir = this->GetActorForwardVector() * Offset.GetLocation().X + this->GetActorRightVector() * Offset.GetLocation().Y + this->GetActorUpVector() * Offset.GetLocation().Z;
@@ -6,14 +6,52 @@
 
 #include "../FuncLibrary/Types.h"
 #include "ProjectileDefault.h"
+#include "TPSWeaponSim.h"
+#include "../Game/TPSFixedStepSubsystem.h"
+#include "../Game/TPSWeaponSubsystem.h"
 #include "WeaponDefault.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnWeaponFireStart, UAnimMontage*, Anim);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnWeaponFired);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnWeaponReloadStart, UAnimMontage*, Anim);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnWeaponReloadEnd, bool, bIsSuccess, int32, AmmoSafe);
 
+//One trigger batch sent client -> server. Pellet directions are replayed from Seed on every machine.
+USTRUCT()
+struct FWeaponFireBatch
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize Origin = FVector::ZeroVector;
+	UPROPERTY()
+	FVector_NetQuantizeNormal Direction = FVector::ForwardVector;
+	UPROPERTY()
+	int32 Seed = 0;
+	//dispersion in 1/100 degree
+	UPROPERTY()
+	uint16 Dispersion = 0;
+	UPROPERTY()
+	uint8 ShotCount = 0;
+	//server world time seen by the shooter, hitscan targets are rewound to it
+	UPROPERTY()
+	float ClientTime = 0.0f;
+};
+
+//Replicated to simulated proxies, drives shells, muzzle FX, sounds and impact decals
+USTRUCT()
+struct FWeaponFireRepInfo
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint8 FireCounter = 0;
+	UPROPERTY()
+	FWeaponFireBatch LastBatch;
+};
+
 UCLASS()
-class TPS_API AWeaponDefault : public AActor
+class TPS_API AWeaponDefault : public AActor, public ITPSFixedStepTarget
 {
 	GENERATED_BODY()
 
@@ -21,7 +59,10 @@ public:
 	// Sets default values for this actor's properties
 	AWeaponDefault();
 
+	//cosmetic, not on dedicated server
 	FOnWeaponFireStart OnWeaponFireStart;
+	//rounds consumed, on server and predicting owner
+	FOnWeaponFired OnWeaponFired;
 	FOnWeaponReloadEnd OnWeaponReloadEnd;
 	FOnWeaponReloadStart OnWeaponReloadStart;
 
@@ -36,24 +77,79 @@ public:
 
 	UPROPERTY()
 	FWeaponInfo WeaponSetting;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon Info")
+	//row in DT_WeaponInfo, clients load WeaponSetting by it
+	UPROPERTY(ReplicatedUsing = OnRep_WeaponIdName, BlueprintReadOnly, Category = "Weapon Info")
+	FName WeaponIdName;
+	//mirror of Sim.Round, set it with SetAdditionalWeaponInfo
+	UPROPERTY(ReplicatedUsing = OnRep_AdditionalWeaponInfo, EditAnywhere, BlueprintReadWrite, Category = "Weapon Info")
 	FAdditionalWeaponInfo AdditionalWeaponInfo;
 
+	//fire, reload and dispersion rules, the actor adds replication, inventory and cosmetics
+	//lives in UTPSWeaponSubsystem while registered, always go through GetSim
+	FTPSWeaponSim& GetSim() { return SimHandle != INDEX_NONE ? WeaponSubsystem->GetSim(SimHandle) : LocalSim; }
+	const FTPSWeaponSim& GetSim() const { return SimHandle != INDEX_NONE ? WeaponSubsystem->GetSim(SimHandle) : LocalSim; }
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UFUNCTION()
+	void OnRep_WeaponIdName();
+	UFUNCTION()
+	void OnRep_FireRepInfo();
+	UFUNCTION()
+	void OnRep_WeaponReloading();
+	UFUNCTION()
+	void OnRep_AdditionalWeaponInfo();
+
+	UPROPERTY(ReplicatedUsing = OnRep_FireRepInfo)
+	FWeaponFireRepInfo FireRepInfo;
+	uint8 LastPlayedFireCounter = 0;
+	UPROPERTY(Transient)
+	class UAudioComponent* FireLoopAudio = nullptr;
+	float LastFireSoundTime = -1.0f;
+	float LastServerFireTime = -1.0f;
+	//shots the owning client may still send, refilled by one every RateOfFire
+	float ServerShotCredit = 0.0f;
+	//batch seed stream start, same on server and owner so prediction replays the server pellets
+	UPROPERTY(Replicated)
+	int32 SimSeed = 0;
+
+	//sim state before BeginPlay, after EndPlay or with TPS.Weapons.Batch 0
+	FTPSWeaponSim LocalSim;
+	UPROPERTY(Transient)
+	UTPSWeaponSubsystem* WeaponSubsystem = nullptr;
+	int32 SimHandle = INDEX_NONE;
+
+	//own fixed step, only when not batched
+	int32 FixedStepHandle = INDEX_NONE;
+	//dispersion change of the last fixed step, undone by the part of the step not reached yet
+	float DispersionStepDelta = 0.0f;
 
 public:
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	// Tick func
 	virtual void Tick(float DeltaTime) override;
 
+	//reload and dispersion run on the fixed gameplay step, batched weapons are stepped by UTPSWeaponSubsystem
+	void FixedStep(float StepTime) override;
+	bool IsOnFixedStep() const { return SimHandle != INDEX_NONE || FixedStepHandle != INDEX_NONE; }
+
 	void FireTick(float DeltaTime);
 	void ReloadTick(float DeltaTime);
 	void DispersionTick(float DeltaTime);
-	void ClipDropTick(float DeltaTime);
-	void ShellDropTick(float DeltaTime);
+	void DropTick(float DeltaTime);
+	void SpawnClipDropMesh();
+	void SpawnShellDropMesh();
+	void LogDispersion() const;
+	void FireSoundTick(float DeltaTime);
 
 	void WeaponInit();
+	void SetAdditionalWeaponInfo(const FAdditionalWeaponInfo& NewInfo);
+	//Sim -> WeaponFiring, WeaponReloading, AdditionalWeaponInfo
+	void SyncReplicatedState();
 
 	UFUNCTION(BlueprintCallable)
 	void SetWeaponStateFire(bool bIsFire);
@@ -62,47 +158,40 @@ public:
 
 	FProjectileInfo GetProjectile();
 
-	void Fire();
+	void Fire(uint8 ShotCount = 1);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerFireBatch(const FWeaponFireBatch& Batch);
+
+	//server side: rounds, damage, projectiles
+	void ExecuteFireBatch(const FWeaponFireBatch& Batch);
+	//replay pellets from Batch.Seed, gameplay only on server, impact FX only where cosmetic
+	void SimulateShots(const FWeaponFireBatch& Batch, bool bApplyGameplay, bool bSpawnImpactFX);
+	void PlayFireCosmetics(const FWeaponFireBatch& Batch);
+	//FireAudio.FireLoop while batches keep coming, else SoundFireWeapon per batch
+	void PlayFireSound(const FVector& Location);
+	void StopFireLoop(bool bPlayTail);
+	bool IsOwnerLocallyControlled() const;
 
 	void UpdateStateWeapon(EMovementState NewMovementState);
-	void ChangeDispersionByShot();
+	//interpolated between fixed steps for presentation, shots use Sim.Dispersion
 	float GetCurrentDispersion() const;
-	FVector ApplyDispersionToShoot(FVector DirectionShoot)const;
+	//0..1 while reloading, interpolated between fixed steps
+	UFUNCTION(BlueprintCallable)
+	float GetReloadProgress() const;
 
-	FVector GetFireEndLocation()const;
+	FVector GetFireDirection()const;
 	int8 GetNumberProjectileByShot() const;
 
-	//Timers
-	float FireTimer = 0.0f;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ReloadLogic")
-	float ReloadTimer = 0.0f;
-
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FRotator MeshWorldPistion;
 
-	//flags
+	//flags, mirrors of Sim.bFiring and Sim.bReloading for Blueprints and replication
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "FireLogic")
 	bool WeaponFiring = false;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ReloadLogic")
+	UPROPERTY(ReplicatedUsing = OnRep_WeaponReloading, EditAnywhere, BlueprintReadWrite, Category = "ReloadLogic")
 	bool WeaponReloading = false;
 	bool WeaponAiming = false;
-	bool BlockFire = false;
-
-	//Dispersion
-	bool ShouldReduceDispersion = false;
-	float CurrentDispersion = 0.0f;
-	float CurrentDispersionMax = 1.0f;
-	float CurrentDispersionMin = 0.1f;
-	float CurrentDispersionRecoil = 0.1f;
-	float CurrentDispersionReduction = 0.1f;
-
-	//Timer Drop Magazine on Reload
-	bool DropClipFlag = false;
-	float DropClipTimer = -1.0f;
-
-	//shell Flag
-	bool DropShellFlag = false;
-	float DropShellTimer = -1.0f;
 
 	FVector ShootEndLocation = FVector(0);
 
@@ -110,6 +199,8 @@ public:
 	int32 GetWeaponRound();
 	void InitReload();
 	void FinishReload();
+	//simulated proxies only mirror the reload flag
+	bool CanFinishReload() const;
 	void CancelReload();
 
 	bool CheckCanWeaponReload();
@@ -123,4 +214,11 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug")
 	float SizeVectorToChangeShootDirectionLogic = 100.0f;
+
+	//server accepts client origin only this close to own muzzle
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Net")
+	float MaxClientOriginError = 200.0f;
+	//shots the client may save up over the fire rate, for jitter
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Net")
+	int32 ServerShotTolerance = 1;
 };
@@ -10,5 +10,6 @@ public class TPSEditorTarget : TargetRules
 		Type = TargetType.Editor;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
 		ExtraModuleNames.Add("TPS");
+		bWithPushModel = true;
 	}
 }